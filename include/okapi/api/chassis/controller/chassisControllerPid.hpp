@@ -7,8 +7,13 @@
 
 #include "okapi/api/chassis/controller/chassisController.hpp"
 #include "okapi/api/control/iterative/iterativePosPidController.hpp"
+#include "okapi/api/control/util/sCurveProfile.hpp"
+#include "okapi/api/units/QAngularAcceleration.hpp"
+#include "okapi/api/units/QAngularJerk.hpp"
+#include "okapi/api/units/QAngularSpeed.hpp"
 #include "okapi/api/util/abstractRate.hpp"
 #include "okapi/api/util/logging.hpp"
+#include "okapi/api/util/loopStats.hpp"
 #include "okapi/api/util/timeUtil.hpp"
 #include <atomic>
 #include <memory>
@@ -166,6 +171,33 @@ class ChassisControllerPID : public ChassisController {
    */
   void setVelocityMode(bool ivelocityMode);
 
+  /**
+   * Makes turns follow a time-optimal profile instead of stepping the turn controller's target
+   * straight to the final angle. The robot's rotation follows an S-curve which respects these
+   * limits, or a trapezoid if the jerk is zero. The turn controller tracks the profile while a
+   * feedforward on the profile's velocity does most of the work, so the turn controller can be
+   * tuned for small corrections instead of for the largest turn. Throws a `std::invalid_argument`
+   * exception if the velocity or acceleration is not positive.
+   *
+   * ```cpp
+   * // Turn at up to 180 degrees per second, accelerating at up to 360 degrees per second squared
+   * chassis->setTurnProfile(180_deg / second, 360_deg / second / second);
+   * ```
+   *
+   * @param imaxVel The maximum angular velocity of the robot.
+   * @param imaxAccel The maximum angular acceleration of the robot.
+   * @param imaxJerk The maximum angular jerk of the robot, or zero for no limit.
+   */
+  void setTurnProfile(QAngularSpeed imaxVel,
+                      QAngularAcceleration imaxAccel,
+                      QAngularJerk imaxJerk = QAngularJerk(0.0));
+
+  /**
+   * Makes turns step the turn controller's target straight to the final angle again. This is the
+   * default.
+   */
+  void disableTurnProfile();
+
   /**
    * Sets the gains for all controllers.
    *
@@ -200,6 +232,14 @@ class ChassisControllerPID : public ChassisController {
    */
   CrossplatformThread *getThread() const;
 
+  /**
+   * Returns the timing statistics of the task which runs this controller. Measuring is off until
+   * `getLoopStats().setEnabled(true)` is called.
+   *
+   * @return The timing statistics of the controller task.
+   */
+  LoopStats &getLoopStats();
+
   /**
    * Interrupts the current movement to stop the robot.
    */
@@ -233,6 +273,7 @@ class ChassisControllerPID : public ChassisController {
   bool normalTurns{true};
   std::shared_ptr<ChassisModel> chassisModel;
   TimeUtil timeUtil;
+  LoopStats loopStats{"ChassisControllerPID", timeUtil.getTimer()};
   std::unique_ptr<IterativePosPIDController> distancePid;
   std::unique_ptr<IterativePosPIDController> turnPid;
   std::unique_ptr<IterativePosPIDController> anglePid;
@@ -245,6 +286,17 @@ class ChassisControllerPID : public ChassisController {
   std::atomic_bool dtorCalled{false};
   QTime threadSleepTime{10_ms};
 
+  // The turn limits in rad/s, rad/s/s, and rad/s/s/s, or a velocity of zero for unprofiled turns
+  double turnMaxVel{0};
+  double turnMaxAccel{0};
+  double turnMaxJerk{0};
+
+  // This must be locked when accessing turnProfile or turnProfiled
+  CrossplatformMutex turnProfileMutex;
+  SCurveProfile turnProfile{};
+  bool turnProfiled{false};
+  std::atomic_bool turnProfileDone{true};
+
   static void trampoline(void *context);
   void loop();
 
@@ -267,6 +319,14 @@ class ChassisControllerPID : public ChassisController {
    */
   void stopAfterSettled();
 
+  /**
+   * Converts an angular velocity of the robot to the output which drives the motors that fast.
+   *
+   * @param ivelocity The angular velocity of the robot in rad/s. Positive is clockwise.
+   * @return The yaw to pass to the model.
+   */
+  double turnFeedforward(double ivelocity) const;
+
   typedef enum { distance, angle, none } modeType;
   modeType mode{none};
 
@@ -13,6 +13,7 @@
 #include "okapi/api/units/QSpeed.hpp"
 #include "okapi/api/util/abstractRate.hpp"
 #include "okapi/api/util/logging.hpp"
+#include "okapi/api/util/loopStats.hpp"
 #include "okapi/api/util/timeUtil.hpp"
 #include <atomic>
 #include <memory>
@@ -137,9 +138,18 @@ class OdomChassisController : public ChassisController {
    */
   std::shared_ptr<Odometry> getOdometry();
 
+  /**
+   * Returns the timing statistics of the odometry task. Measuring is off until
+   * `getLoopStats().setEnabled(true)` is called.
+   *
+   * @return The timing statistics of the odometry task.
+   */
+  LoopStats &getLoopStats();
+
   protected:
   std::shared_ptr<Logger> logger;
   TimeUtil timeUtil;
+  LoopStats loopStats{"Odometry", timeUtil.getTimer()};
   QLength moveThreshold;
   QAngle turnThreshold;
   std::shared_ptr<Odometry> odom;
@@ -0,0 +1,376 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include "okapi/api/chassis/controller/chassisScales.hpp"
+#include "okapi/api/chassis/model/xDriveModel.hpp"
+#include "okapi/api/control/async/asyncPositionController.hpp"
+#include "okapi/api/control/util/pathfinderUtil.hpp"
+#include "okapi/api/units/QAngularSpeed.hpp"
+#include "okapi/api/units/QSpeed.hpp"
+#include "okapi/api/util/logging.hpp"
+#include "okapi/api/util/loopStats.hpp"
+#include "okapi/api/util/timeUtil.hpp"
+#include <atomic>
+#include <map>
+#include <memory>
+
+extern "C" {
+#include "okapi/pathfinder/include/pathfinder.h"
+}
+
+namespace okapi {
+class AsyncHolonomicMotionProfileController
+  : public AsyncPositionController<std::string, PathfinderPoint> {
+  public:
+  /**
+   * An Async Controller which generates and follows 2D motion profiles for an x drive. The robot
+   * follows the path while turning to a separate heading, so it can strafe and turn in one
+   * movement. Throws a `std::invalid_argument` exception if the gear ratio is zero.
+   *
+   * The wheel speeds are found the same way `XDriveModel::xArcade()` mixes its inputs, so the
+   * chassis scales are the effective scales of the x drive: `wheelDiameter` is the diameter which
+   * makes driving forward a given distance correct, and `wheelTrack` is the track which makes
+   * turning a given angle correct.
+   *
+   * @param itimeUtil The TimeUtil.
+   * @param ilimits The default limits of the path in m/s, m/s/s, and m/s/s/s.
+   * @param iturnLimits The default limits of the heading in rad/s, rad/s/s, and rad/s/s/s.
+   * @param imodel The x drive to control.
+   * @param iscales The chassis dimensions.
+   * @param ipair The gearset.
+   * @param ilogger The logger this instance will log to.
+   */
+  AsyncHolonomicMotionProfileController(
+    const TimeUtil &itimeUtil,
+    const PathfinderLimits &ilimits,
+    const PathfinderLimits &iturnLimits,
+    const std::shared_ptr<XDriveModel> &imodel,
+    const ChassisScales &iscales,
+    const AbstractMotor::GearsetRatioPair &ipair,
+    const std::shared_ptr<Logger> &ilogger = Logger::getDefaultLogger());
+
+  AsyncHolonomicMotionProfileController(AsyncHolonomicMotionProfileController &&other) = delete;
+
+  AsyncHolonomicMotionProfileController &
+  operator=(AsyncHolonomicMotionProfileController &&other) = delete;
+
+  ~AsyncHolonomicMotionProfileController() override;
+
+  /**
+   * Generates a path which intersects the given waypoints and saves it internally with a key of
+   * pathId. Call `setTarget()` with the same pathId to run it.
+   *
+   * The angle of each waypoint is the direction the robot is moving in, not the way it is facing.
+   * The robot turns from its starting heading to `iheading` while it follows the path. Both start
+   * at the same time, and whichever finishes first waits for the other, so the movement takes as
+   * long as the slower of the two.
+   *
+   * If the waypoints form a path which is impossible to achieve, an instance of
+   * `std::runtime_error` is thrown (and an error is logged) which describes the waypoints. If there
+   * are no waypoints, no path is generated.
+   *
+   * @param iwaypoints The waypoints to hit on the path.
+   * @param iheading The heading to face at the end of the path, relative to the start of the path.
+   * Positive angles turn the same way as positive waypoint angles.
+   * @param ipathId A unique identifier to save the path with.
+   */
+  void generatePath(std::initializer_list<PathfinderPoint> iwaypoints,
+                    QAngle iheading,
+                    const std::string &ipathId);
+
+  /**
+   * Generates a path which intersects the given waypoints and saves it internally with a key of
+   * pathId. See the other overload for details.
+   *
+   * @param iwaypoints The waypoints to hit on the path.
+   * @param iheading The heading to face at the end of the path, relative to the start of the path.
+   * @param ipathId A unique identifier to save the path with.
+   * @param ilimits The limits of the path to use for this path only.
+   * @param iturnLimits The limits of the heading to use for this path only.
+   */
+  void generatePath(std::initializer_list<PathfinderPoint> iwaypoints,
+                    QAngle iheading,
+                    const std::string &ipathId,
+                    const PathfinderLimits &ilimits,
+                    const PathfinderLimits &iturnLimits);
+
+  /**
+   * Removes a path and frees the memory it used. This function returns true if the path was either
+   * deleted or didn't exist in the first place. It returns false if the path could not be removed
+   * because it is running.
+   *
+   * @param ipathId A unique identifier for the path, previously passed to `generatePath()`
+   * @return True if the path no longer exists
+   */
+  bool removePath(const std::string &ipathId);
+
+  /**
+   * Gets the identifiers of all paths saved in this `AsyncHolonomicMotionProfileController`.
+   *
+   * @return The identifiers of all paths
+   */
+  std::vector<std::string> getPaths();
+
+  /**
+   * Executes a path with the given ID. If there is no path matching the ID, the method will
+   * return. Any targets set while a path is being followed will be ignored.
+   *
+   * @param ipathId A unique identifier for the path, previously passed to `generatePath()`.
+   */
+  void setTarget(std::string ipathId) override;
+
+  /**
+   * Executes a path with the given ID. If there is no path matching the ID, the method will
+   * return. Any targets set while a path is being followed will be ignored.
+   *
+   * @param ipathId A unique identifier for the path, previously passed to `generatePath()`.
+   * @param imirrored Whether to follow the profile mirrored, which also turns the other way.
+   */
+  void setTarget(std::string ipathId, bool imirrored);
+
+  /**
+   * Writes the value of the controller output. This method might be automatically called in another
+   * thread by the controller. This just calls `setTarget()`.
+   */
+  void controllerSet(std::string ivalue) override;
+
+  /**
+   * Gets the last set target, or the default target if none was set.
+   *
+   * @return the last target
+   */
+  std::string getTarget() override;
+
+  /**
+   * This is overridden to return the current path.
+   *
+   * @return The most recent value of the process variable.
+   */
+  std::string getProcessValue() const override;
+
+  /**
+   * Blocks the current task until the controller has settled. This controller is settled when
+   * it has finished following a path. If no path is being followed, it is settled.
+   */
+  void waitUntilSettled() override;
+
+  /**
+   * Generates a new path from the position (typically the current position) to the target and
+   * blocks until the controller has settled. Does not save the path which was generated.
+   *
+   * @param iwaypoints The waypoints to hit on the path.
+   * @param iheading The heading to face at the end of the path.
+   * @param imirrored Whether to follow the profile mirrored.
+   */
+  void moveTo(std::initializer_list<PathfinderPoint> iwaypoints,
+              QAngle iheading,
+              bool imirrored = false);
+
+  /**
+   * Returns the last error of the controller. Does not update when disabled. This implementation
+   * always returns zero since the robot is assumed to perfectly follow the path.
+   *
+   * @return the last error
+   */
+  PathfinderPoint getError() const override;
+
+  /**
+   * Returns whether the controller has settled at the target. Determining what settling means is
+   * implementation-dependent.
+   *
+   * If the controller is disabled, this method must return true.
+   *
+   * @return whether the controller is settled
+   */
+  bool isSettled() override;
+
+  /**
+   * Resets the controller so it can start from 0 again properly. Keeps configuration from
+   * before. This implementation also stops movement.
+   */
+  void reset() override;
+
+  /**
+   * Changes whether the controller is off or on. Turning the controller on after it was off will
+   * NOT cause the controller to move to its last set target.
+   */
+  void flipDisable() override;
+
+  /**
+   * Sets whether the controller is off or on. Turning the controller on after it was off will
+   * NOT cause the controller to move to its last set target, unless it was reset in that time.
+   *
+   * @param iisDisabled whether the controller is disabled
+   */
+  void flipDisable(bool iisDisabled) override;
+
+  /**
+   * Returns whether the controller is currently disabled.
+   *
+   * @return whether the controller is currently disabled
+   */
+  bool isDisabled() const override;
+
+  /**
+   * This implementation does nothing because the API always requires the starting position to be
+   * specified.
+   */
+  void tarePosition() override;
+
+  /**
+   * This implementation does nothing because the maximum velocity is configured using
+   * PathfinderLimits elsewhere.
+   *
+   * @param imaxVelocity Ignored.
+   */
+  void setMaxVelocity(std::int32_t imaxVelocity) override;
+
+  /**
+   * Starts the internal thread. This should not be called by normal users. This method is called
+   * by the `AsyncMotionProfileControllerBuilder` when making a new instance of this class.
+   */
+  void startThread();
+
+  /**
+   * @return The underlying thread handle.
+   */
+  CrossplatformThread *getThread() const;
+
+  /**
+   * Returns the timing statistics of the task which runs this controller. Measuring is off until
+   * `getLoopStats().setEnabled(true)` is called.
+   *
+   * @return The timing statistics of the controller task.
+   */
+  LoopStats &getLoopStats();
+
+  /**
+   * Attempts to remove a path without stopping execution. If that fails, disables the controller
+   * and removes the path.
+   *
+   * @param ipathId The path ID that will be removed
+   */
+  void forceRemovePath(const std::string &ipathId);
+
+  protected:
+  struct HolonomicPath {
+    int length;
+    double dt;
+
+    // The speeds of the top left, top right, bottom right, and bottom left motors at each step as
+    // a fraction of the gearset's speed, stored in groups of four
+    std::vector<float> commands;
+  };
+
+  std::shared_ptr<Logger> logger;
+
+  // Paths are never changed once they are saved, so the loop holds on to the path it is following
+  // instead of keeping this locked. currentPathMutex must be locked when accessing this.
+  std::map<std::string, std::shared_ptr<const HolonomicPath>> paths{};
+
+  PathfinderLimits limits;
+  PathfinderLimits turnLimits;
+  std::shared_ptr<XDriveModel> model;
+  ChassisScales scales;
+  AbstractMotor::GearsetRatioPair pair;
+  TimeUtil timeUtil;
+  LoopStats loopStats{"AsyncHolonomicMotionProfileController", timeUtil.getTimer()};
+
+  // This must be locked when using the scratch
+  CrossplatformMutex scratchMutex;
+  PathfinderScratch scratch{};
+
+  // This must be locked when accessing the paths or the current path
+  mutable CrossplatformMutex currentPathMutex;
+
+  std::string currentPath{""};
+  std::atomic_bool isRunning{false};
+  std::atomic_bool mirrored{false};
+  std::atomic_bool disabled{false};
+  std::atomic_bool dtorCalled{false};
+  CrossplatformThread *task{nullptr};
+  std::atomic_bool taskDone{false}; // Set by the task when it exits
+
+  static void trampoline(void *context);
+  void loop();
+
+  /**
+   * Generates the profile of the path and of the heading and combines them into wheel speeds. If
+   * a wheel would be faster than its motor, both profiles are slowed down together until none is.
+   * Throws a `std::runtime_error` if either profile is impossible. `scratchMutex` must be locked.
+   *
+   * @param points The waypoints to hit on the path.
+   * @param iheading The heading to face at the end of the path in radians.
+   * @param ipathId The identifier of the path, used in error messages.
+   * @param ilimits The limits of the path.
+   * @param iturnLimits The limits of the heading.
+   * @return The generated path.
+   */
+  HolonomicPath generateHolonomicPath(const std::vector<Waypoint> &points,
+                                      double iheading,
+                                      const std::string &ipathId,
+                                      const PathfinderLimits &ilimits,
+                                      const PathfinderLimits &iturnLimits);
+
+  /**
+   * Generates the profile of the path and of the heading at exactly these limits and combines them
+   * into wheel speeds. `scratchMutex` must be locked.
+   *
+   * @param points The waypoints to hit on the path.
+   * @param iheading The heading to face at the end of the path in radians.
+   * @param ipathId The identifier of the path, used in error messages.
+   * @param ilimits The limits of the path.
+   * @param iturnLimits The limits of the heading.
+   * @param opeakCommand The fastest speed of any wheel as a fraction of the gearset's speed.
+   * @return The generated path.
+   */
+  HolonomicPath combineProfiles(std::vector<Waypoint> points,
+                                double iheading,
+                                const std::string &ipathId,
+                                const PathfinderLimits &ilimits,
+                                const PathfinderLimits &iturnLimits,
+                                double &opeakCommand);
+
+  /**
+   * @param ilimits The limits of a profile.
+   * @param iscale How much slower to make the profile, between 0 and 1.
+   * @return The limits of the same profile slowed down in time, so every velocity is `iscale`
+   * times as fast.
+   */
+  static PathfinderLimits scaleLimits(const PathfinderLimits &ilimits, double iscale);
+
+  /**
+   * Generates a trajectory into the scratch. Throws a `std::runtime_error` if it is impossible.
+   *
+   * @param points The waypoints to hit.
+   * @param ipathId The identifier of the path, used in error messages.
+   * @param ilimits The limits to use.
+   * @param idt The time step in seconds.
+   * @return The number of segments in `scratch.segments()`.
+   */
+  int generateTrajectory(std::vector<Waypoint> &points,
+                         const std::string &ipathId,
+                         const PathfinderLimits &ilimits,
+                         double idt);
+
+  /**
+   * Follow the supplied path. Must follow the disabled lifecycle.
+   */
+  virtual void executeSinglePath(const HolonomicPath &path, std::unique_ptr<AbstractRate> rate);
+
+  /**
+   * Converts linear chassis speed to rotational motor speed.
+   *
+   * @param linear chassis frame speed
+   * @return motor frame speed
+   */
+  QAngularSpeed convertLinearToRotational(QSpeed linear) const;
+
+  std::string
+  getPathErrorMessage(const std::vector<Waypoint> &points, const std::string &ipathId, int length);
+};
+} // namespace okapi
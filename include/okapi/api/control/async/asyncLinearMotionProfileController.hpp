@@ -7,10 +7,12 @@
 
 #include "okapi/api/control/async/asyncPositionController.hpp"
 #include "okapi/api/control/util/pathfinderUtil.hpp"
+#include "okapi/api/control/util/trajectoryCache.hpp"
 #include "okapi/api/device/motor/abstractMotor.hpp"
 #include "okapi/api/units/QAngularSpeed.hpp"
 #include "okapi/api/units/QSpeed.hpp"
 #include "okapi/api/util/logging.hpp"
+#include "okapi/api/util/loopStats.hpp"
 #include "okapi/api/util/timeUtil.hpp"
 #include <atomic>
 #include <map>
@@ -241,6 +243,14 @@ class AsyncLinearMotionProfileController : public AsyncPositionController<std::s
    */
   CrossplatformThread *getThread() const;
 
+  /**
+   * Returns the timing statistics of the task which runs this controller. Measuring is off until
+   * `getLoopStats().setEnabled(true)` is called.
+   *
+   * @return The timing statistics of the controller task.
+   */
+  LoopStats &getLoopStats();
+
   /**
    * Attempts to remove a path without stopping execution, then if that fails, disables the
    * controller and removes the path.
@@ -249,8 +259,16 @@ class AsyncLinearMotionProfileController : public AsyncPositionController<std::s
    */
   void forceRemovePath(const std::string &ipathId);
 
+  /**
+   * Returns the cache of generated trajectories. Generating a path with the same waypoints and
+   * limits as an earlier path reuses the earlier trajectory instead of generating it again. Call
+   * `setDirectory()` on the cache to keep trajectories across program runs.
+   *
+   * @return The trajectory cache.
+   */
+  TrajectoryCache &getTrajectoryCache();
+
   protected:
-  using TrajectoryPtr = std::unique_ptr<TrajectoryCandidate, void (*)(TrajectoryCandidate *)>;
   using SegmentPtr = std::unique_ptr<Segment, void (*)(void *)>;
 
   struct TrajectoryPair {
@@ -266,6 +284,9 @@ class AsyncLinearMotionProfileController : public AsyncPositionController<std::s
   AbstractMotor::GearsetRatioPair pair;
   double currentProfilePosition{0};
   TimeUtil timeUtil;
+  LoopStats loopStats{"AsyncLinearMotionProfileController", timeUtil.getTimer()};
+  TrajectoryCache trajectoryCache{};
+  PathfinderScratch scratch{};
 
   // This must be locked when accessing the current path
   CrossplatformMutex currentPathMutex;
@@ -9,12 +9,21 @@
 #include "okapi/api/chassis/model/skidSteerModel.hpp"
 #include "okapi/api/control/async/asyncPositionController.hpp"
 #include "okapi/api/control/util/pathfinderUtil.hpp"
+#include "okapi/api/control/util/playbackTrajectory.hpp"
+#include "okapi/api/control/util/ramseteFollower.hpp"
+#include "okapi/api/control/util/trajectoryCache.hpp"
+#include "okapi/api/control/util/trajectoryFollower.hpp"
+#include "okapi/api/odometry/odometry.hpp"
 #include "okapi/api/units/QAngularSpeed.hpp"
 #include "okapi/api/units/QSpeed.hpp"
 #include "okapi/api/util/logging.hpp"
+#include "okapi/api/util/loopStats.hpp"
 #include "okapi/api/util/timeUtil.hpp"
 #include <atomic>
-#include <map>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <unordered_map>
 
 extern "C" {
 #include "okapi/pathfinder/include/pathfinder.h"
@@ -47,6 +56,45 @@ class AsyncMotionProfileController : public AsyncPositionController<std::string,
 
   ~AsyncMotionProfileController() override;
 
+  /**
+   * Identifies a path without its string ID. A handle is the slot the path is saved in, so looking
+   * up a path by its handle does no hashing or string comparisons. A handle stays valid for the
+   * life of the controller which returned it, even if its path is removed and saved again.
+   */
+  class PathHandle {
+    public:
+    /**
+     * Makes a handle which does not refer to any path.
+     */
+    PathHandle() = default;
+
+    /**
+     * @return True if this handle was returned by a controller.
+     */
+    bool isValid() const {
+      return slot != invalidSlot;
+    }
+
+    bool operator==(const PathHandle &other) const {
+      return slot == other.slot;
+    }
+
+    bool operator!=(const PathHandle &other) const {
+      return slot != other.slot;
+    }
+
+    protected:
+    friend class AsyncMotionProfileController;
+
+    // The target is packed into 32 bits with two flags, so a slot has 30 bits
+    static constexpr std::uint32_t invalidSlot = 0x3fffffff;
+
+    explicit PathHandle(std::uint32_t islot) : slot(islot) {
+    }
+
+    std::uint32_t slot{invalidSlot};
+  };
+
   /**
    * Generates a path which intersects the given waypoints and saves it internally with a key of
    * pathId. Call `executePath()` with the same pathId to run it.
@@ -57,8 +105,10 @@ class AsyncMotionProfileController : public AsyncPositionController<std::string,
    *
    * @param iwaypoints The waypoints to hit on the path.
    * @param ipathId A unique identifier to save the path with.
+   * @return The handle of the path.
    */
-  void generatePath(std::initializer_list<PathfinderPoint> iwaypoints, const std::string &ipathId);
+  PathHandle generatePath(std::initializer_list<PathfinderPoint> iwaypoints,
+                          const std::string &ipathId);
 
   /**
    * Generates a path which intersects the given waypoints and saves it internally with a key of
@@ -71,10 +121,105 @@ class AsyncMotionProfileController : public AsyncPositionController<std::string,
    * @param iwaypoints The waypoints to hit on the path.
    * @param ipathId A unique identifier to save the path with.
    * @param ilimits The limits to use for this path only.
+   * @return The handle of the path.
+   */
+  PathHandle generatePath(std::initializer_list<PathfinderPoint> iwaypoints,
+                          const std::string &ipathId,
+                          const PathfinderLimits &ilimits);
+
+  struct PathSpec {
+    std::vector<PathfinderPoint> waypoints; // The waypoints to hit on the path
+    std::string pathId;                     // A unique identifier to save the path with
+    std::optional<PathfinderLimits> limits{}; // The limits to use, or empty for the default limits
+  };
+
+  /**
+   * Generates several paths and saves each one internally with a key of its pathId, just like
+   * `generatePath()`. On the host (`THREADS_STD`), the paths are generated in parallel on one
+   * worker per core. On the brain they are generated one after another on the calling task.
+   *
+   * A path which cannot be generated does not stop the rest of the batch. The paths which were
+   * generated are all saved at once after the whole batch has finished, so the controller never
+   * sees part of a batch. Replacing the path the controller is following disables the controller,
+   * just like `forceRemovePath()`; replacing any other path leaves it running.
+   *
+   * @param ispecs The paths to generate.
+   * @return An error message for each path, in the same order as `ispecs`. The message is empty if
+   * the path was generated.
+   */
+  std::vector<std::string> generatePaths(const std::vector<PathSpec> &ispecs);
+
+  /**
+   * Queues a path to be generated on a background task and returns immediately. The path is saved
+   * internally with a key of pathId once it has been generated, just like `generatePath()`. Paths
+   * are generated in the order they were queued.
+   *
+   * The path can be passed to `setTarget()` right away. If it has not been generated yet, the
+   * controller waits for it before following it. This lets later paths in a routine be generated
+   * while the robot is driving earlier ones. Use `waitUntilPathGenerated()` to find out whether the
+   * path could be generated. If there are no waypoints, no path is generated.
+   *
+   * @param iwaypoints The waypoints to hit on the path.
+   * @param ipathId A unique identifier to save the path with.
+   * @return The handle the path will be saved with.
+   */
+  PathHandle generatePathAsync(std::initializer_list<PathfinderPoint> iwaypoints,
+                               const std::string &ipathId);
+
+  /**
+   * Queues a path to be generated on a background task and returns immediately. The path is saved
+   * internally with a key of pathId once it has been generated, just like `generatePath()`. Paths
+   * are generated in the order they were queued.
+   *
+   * The path can be passed to `setTarget()` right away. If it has not been generated yet, the
+   * controller waits for it before following it. This lets later paths in a routine be generated
+   * while the robot is driving earlier ones. Use `waitUntilPathGenerated()` to find out whether the
+   * path could be generated. If there are no waypoints, no path is generated.
+   *
+   * @param iwaypoints The waypoints to hit on the path.
+   * @param ipathId A unique identifier to save the path with.
+   * @param ilimits The limits to use for this path only.
+   * @return The handle the path will be saved with.
    */
-  void generatePath(std::initializer_list<PathfinderPoint> iwaypoints,
-                    const std::string &ipathId,
-                    const PathfinderLimits &ilimits);
+  PathHandle generatePathAsync(std::initializer_list<PathfinderPoint> iwaypoints,
+                               const std::string &ipathId,
+                               const PathfinderLimits &ilimits);
+
+  /**
+   * Gets the handle of a path ID. If the ID has not been used yet, it is given a handle now, which
+   * is useful for paths which will be loaded or generated later.
+   *
+   * @param ipathId A unique identifier for the path.
+   * @return The handle of the path.
+   */
+  PathHandle getPathHandle(const std::string &ipathId);
+
+  /**
+   * Returns whether a path queued with `generatePathAsync()` is still waiting to be generated or is
+   * being generated.
+   *
+   * @param ipathId A unique identifier for the path, previously passed to `generatePathAsync()`.
+   * @return True if the path has not finished generating.
+   */
+  bool isGeneratingPath(const std::string &ipathId);
+
+  /**
+   * Returns whether a path queued with `generatePathAsync()` is still waiting to be generated or is
+   * being generated.
+   *
+   * @param ipath The handle of the path.
+   * @return True if the path has not finished generating.
+   */
+  bool isGeneratingPath(PathHandle ipath);
+
+  /**
+   * Blocks the current task until a path queued with `generatePathAsync()` has finished generating.
+   * Returns immediately if the path is not queued.
+   *
+   * @param ipathId A unique identifier for the path, previously passed to `generatePathAsync()`.
+   * @return True if the path exists, false if it could not be generated.
+   */
+  bool waitUntilPathGenerated(const std::string &ipathId);
 
   /**
    * Removes a path and frees the memory it used. This function returns true if the path was either
@@ -95,7 +240,8 @@ class AsyncMotionProfileController : public AsyncPositionController<std::string,
 
   /**
    * Executes a path with the given ID. If there is no path matching the ID, the method will
-   * return. Any targets set while a path is being followed will be ignored.
+   * return. Any targets set while a path is being followed will be ignored. If the path is still
+   * being generated by `generatePathAsync()`, the controller waits for it before following it.
    *
    * @param ipathId A unique identifier for the path, previously passed to `generatePath()`.
    */
@@ -103,7 +249,8 @@ class AsyncMotionProfileController : public AsyncPositionController<std::string,
 
   /**
    * Executes a path with the given ID. If there is no path matching the ID, the method will
-   * return. Any targets set while a path is being followed will be ignored.
+   * return. Any targets set while a path is being followed will be ignored. If the path is still
+   * being generated by `generatePathAsync()`, the controller waits for it before following it.
    *
    * @param ipathId A unique identifier for the path, previously passed to `generatePath()`.
    * @param ibackwards Whether to follow the profile backwards.
@@ -111,6 +258,39 @@ class AsyncMotionProfileController : public AsyncPositionController<std::string,
    */
   void setTarget(std::string ipathId, bool ibackwards, bool imirrored = false);
 
+  /**
+   * Executes a path with the given handle. This is the same as `setTarget()` with the path's ID,
+   * but the target is changed with a single atomic store and no strings are copied.
+   *
+   * @param ipath The handle of the path.
+   * @param ibackwards Whether to follow the profile backwards.
+   * @param imirrored Whether to follow the profile mirrored.
+   */
+  void setTarget(PathHandle ipath, bool ibackwards = false, bool imirrored = false);
+
+  /**
+   * Follows a path after the paths which are already running or queued, without stopping in
+   * between. The chassis is only stopped after the last queued path. If no path is running, this
+   * is the same as `setTarget()`. Generate each path with an end velocity equal to the start
+   * velocity of the next one (see `PathfinderLimits::startVel`) so the hand-off is smooth.
+   * Disabling or resetting the controller clears the queue.
+   *
+   * @param ipathId A unique identifier for the path, previously passed to `generatePath()`.
+   * @param ibackwards Whether to follow the profile backwards.
+   * @param imirrored Whether to follow the profile mirrored.
+   */
+  void queueTarget(const std::string &ipathId, bool ibackwards = false, bool imirrored = false);
+
+  /**
+   * Follows a path after the paths which are already running or queued. This is the same as
+   * `queueTarget()` with the path's ID.
+   *
+   * @param ipath The handle of the path.
+   * @param ibackwards Whether to follow the profile backwards.
+   * @param imirrored Whether to follow the profile mirrored.
+   */
+  void queueTarget(PathHandle ipath, bool ibackwards = false, bool imirrored = false);
+
   /**
    * Writes the value of the controller output. This method might be automatically called in another
    * thread by the controller. This just calls `setTarget()`.
@@ -124,6 +304,13 @@ class AsyncMotionProfileController : public AsyncPositionController<std::string,
    */
   std::string getTarget() override;
 
+  /**
+   * Gets the handle of the last set target.
+   *
+   * @return The handle of the last target, or an invalid handle if none was set.
+   */
+  PathHandle getTargetHandle() const;
+
   /**
    * This is overridden to return the current path.
    *
@@ -163,6 +350,27 @@ class AsyncMotionProfileController : public AsyncPositionController<std::string,
               bool ibackwards = false,
               bool imirrored = false);
 
+  /**
+   * Replaces the path being followed with a new one from where the robot is now to the waypoints
+   * of the path it has not reached yet, for example after the robot was bumped. The new path
+   * starts at the robot's measured pose and velocity and keeps the limits and end velocity of the
+   * old one. It is generated in the calling task, and the controller switches to it within one
+   * step without stopping. The saved path is not changed.
+   *
+   * The pose is measured with odometry if `setRamseteFollower()` was called. Otherwise the robot
+   * is assumed to be on the path, and its velocity is measured with the encoders if
+   * `setFollowerGains()` was called. Only the spline to the next waypoint is fitted and measured,
+   * the splines between the remaining waypoints are reused from the old path.
+   *
+   * Paths which were loaded from a file or compacted do not keep their waypoints, so they can't be
+   * replanned.
+   *
+   * @return Whether the controller switched to a new path. This is false if no path is being
+   * followed, the path can't be replanned, the robot is past its last waypoint, or the new path is
+   * impossible or rejected by `setPathValidation()`.
+   */
+  bool replan();
+
   /**
    * Returns the last error of the controller. Does not update when disabled. This implementation
    * always returns zero since the robot is assumed to perfectly follow the path. Subclasses can
@@ -235,17 +443,37 @@ class AsyncMotionProfileController : public AsyncPositionController<std::string,
   CrossplatformThread *getThread() const;
 
   /**
-   * Saves a generated path to files. Paths are stored as `<ipathId>.<left/right>.csv`. An SD card
-   * must be inserted into the brain and the directory must exist. `idirectory` can be prefixed with
-   * `/usd/`, but it this is not required.
+   * Returns the timing statistics of the task which runs this controller. Measuring is off until
+   * `getLoopStats().setEnabled(true)` is called.
    *
-   * @param idirectory The directory to store the path files in
+   * @return The timing statistics of the controller task.
+   */
+  LoopStats &getLoopStats();
+
+  /**
+   * Saves a generated path to a binary file. Paths are stored as `<ipathId>.traj`. An SD card must
+   * be inserted into the brain and the directory must exist. `idirectory` can be prefixed with
+   * `/usd/`, but it this is not required. Use `storePathCsv()` to export a path for other tools.
+   *
+   * @param idirectory The directory to store the path file in
    * @param ipathId The path ID of the generated path
    */
   void storePath(const std::string &idirectory, const std::string &ipathId);
 
   /**
-   * Loads a path from a directory on the SD card containing path CSV files. `/usd/` is
+   * Saves a generated path to CSV files. Paths are stored as `<ipathId>.<left/right>.csv`. An SD
+   * card must be inserted into the brain and the directory must exist. `idirectory` can be prefixed
+   * with `/usd/`, but it this is not required. CSV files are much slower to load than the files
+   * written by `storePath()`, so this should only be used to export paths for other tools.
+   *
+   * @param idirectory The directory to store the path files in
+   * @param ipathId The path ID of the generated path
+   */
+  void storePathCsv(const std::string &idirectory, const std::string &ipathId);
+
+  /**
+   * Loads a path from a directory on the SD card. The binary file written by `storePath()` is
+   * loaded if it exists, otherwise the CSV files written by `storePathCsv()` are loaded. `/usd/` is
    * automatically prepended to `idirectory` if it is not specified.
    *
    * @param idirectory The directory that the path files are stored in
@@ -261,43 +489,578 @@ class AsyncMotionProfileController : public AsyncPositionController<std::string,
    */
   void forceRemovePath(const std::string &ipathId);
 
+  /**
+   * Replaces a path with a compact copy which only holds the wheel velocities needed to follow it.
+   * This cuts the memory used by the path by 90% or more, so every path for a match can be
+   * generated ahead of time. A compacted path can still be followed but can no longer be stored.
+   *
+   * @param ipathId The path ID of the path to compact.
+   * @param iencoding How to store the velocities. `int16` uses half as much memory as `float32`
+   * but rounds each velocity to 1/32767 of the fastest velocity on that side.
+   * @return True if the path was compacted. Returns false if the path does not exist.
+   */
+  bool compactPath(const std::string &ipathId,
+                   PlaybackTrajectory::encoding iencoding = PlaybackTrajectory::encoding::float32);
+
+  /**
+   * Follows paths with feedforward and encoder feedback instead of commanding each wheel's
+   * velocity. Each wheel is driven with a voltage from a `TrajectoryFollower` with these gains,
+   * which corrects for the distance the wheel has fallen behind the path. The follower runs
+   * several times per path segment if `iperiod` is shorter than a segment.
+   *
+   * @param igains The follower gains. The output of the follower is a fraction of the maximum
+   * voltage.
+   * @param iperiod How often to update the wheel voltages.
+   */
+  void setFollowerGains(const TrajectoryFollower::Gains &igains, QTime iperiod = 5_ms);
+
+  /**
+   * Goes back to following paths by commanding each wheel's velocity, which is the default.
+   */
+  void clearFollowerGains();
+
+  /**
+   * Follows paths by steering toward the pose the path says the robot should be at, measured with
+   * odometry. This corrects drift while the path is running. The odometry must be stepped by
+   * another task, for example the one started by an `OdomChassisController`. The pose at the start
+   * of each path is taken as the first waypoint of that path. Compacted paths no longer hold poses,
+   * so they are followed without odometry. This takes priority over `setFollowerGains()`.
+   *
+   * @param iodometry The odometry to read the pose from.
+   * @param igains The follower gains.
+   */
+  void setRamseteFollower(const std::shared_ptr<Odometry> &iodometry,
+                          const RamseteFollower::Gains &igains = RamseteFollower::Gains());
+
+  /**
+   * Stops following paths with odometry.
+   */
+  void clearRamseteFollower();
+
+  /**
+   * Returns the cache of generated trajectories. Generating a path with the same waypoints and
+   * limits as an earlier path reuses the earlier trajectory instead of generating it again. Call
+   * `setDirectory()` on the cache to keep trajectories across program runs.
+   *
+   * @return The trajectory cache.
+   */
+  TrajectoryCache &getTrajectoryCache();
+
+  /**
+   * A point where the path turns so tightly that the inner wheel stops or drives backwards, which
+   * is where a path usually needs the most from the motors.
+   */
+  struct HotSpot {
+    QTime time;            // When the robot reaches the tightest point of the turn
+    PathfinderPoint point; // Where the tightest point is, in the frame of the waypoints
+    double curvature;      // The curvature of the turn there in 1/m
+  };
+
+  /**
+   * What a path asks of the robot, found in one pass over the generated path.
+   */
+  struct PathReport {
+    QTime duration{0_ms};            // How long the path takes to follow
+    double maxWheelRpm{0};           // The fastest either motor has to turn in motor rpm
+    double maxWheelAccel{0};         // The largest acceleration of either wheel in m/s/s
+    double maxCurvature{0};          // The curvature of the tightest turn in 1/m
+    std::vector<HotSpot> hotSpots{}; // Each turn which stops or reverses the inner wheel
+    bool feasible{true};             // Whether the motors are fast enough to follow the path
+  };
+
+  /**
+   * What to do with a generated path which is faster than the motors can follow.
+   */
+  enum class PathValidation {
+    warn,   ///< Save the path and log a warning, which is the default.
+    reject, ///< Throw a `std::runtime_error` instead of saving the path.
+    rescale ///< Generate the path again, slowing down wherever a wheel would be too fast.
+  };
+
+  /**
+   * Sets what to do with generated paths which are faster than the motors can follow. Every path
+   * is checked when it is generated, by `generatePath()`, `generatePaths()`, `generatePathAsync()`,
+   * and `replan()`. `rescale` generates the path again with `PathfinderLimits::maxWheelVel` set
+   * just under the top speed of the motors, which slows the robot down on curves instead of over
+   * the whole path, and rejects it if it is still too fast. A rejected replanned path makes
+   * `replan()` return false instead of throwing. Paths loaded from a file are always saved with a
+   * warning.
+   *
+   * @param ivalidation What to do with paths the motors can't follow.
+   */
+  void setPathValidation(PathValidation ivalidation);
+
+  /**
+   * Generates a path and reports what it asks of the robot without saving it, so a path can be
+   * checked before the match. The path is generated with the limits as given, regardless of
+   * `setPathValidation()`. Throws a `std::runtime_error` if the path is impossible.
+   *
+   * @param iwaypoints The waypoints to hit on the path.
+   * @return The report of the path.
+   */
+  PathReport previewPath(std::initializer_list<PathfinderPoint> iwaypoints);
+
+  /**
+   * Generates a path and reports what it asks of the robot without saving it. See the other
+   * overload for details.
+   *
+   * @param iwaypoints The waypoints to hit on the path.
+   * @param ilimits The limits to use for this path only.
+   * @return The report of the path.
+   */
+  PathReport previewPath(std::initializer_list<PathfinderPoint> iwaypoints,
+                         const PathfinderLimits &ilimits);
+
+  /**
+   * Reports what a saved path asks of the robot. Compacted paths only keep their wheel velocities,
+   * so their report has no curvature or hot spots.
+   *
+   * @param ipathId The path ID of the path.
+   * @return The report of the path, or nothing if there is no path with that ID.
+   */
+  std::optional<PathReport> getPathReport(const std::string &ipathId) const;
+
   protected:
-  using TrajectoryPtr = std::unique_ptr<TrajectoryCandidate, void (*)(TrajectoryCandidate *)>;
   using SegmentPtr = std::unique_ptr<Segment, void (*)(void *)>;
 
   struct TrajectoryPair {
-    SegmentPtr left;
-    SegmentPtr right;
+    SegmentPtr segments; // The left trajectory followed by the right trajectory
     int length;
+    PathfinderLimits limits;
+    PlaybackTrajectory playback{}; // Replaces the segments once the path has been compacted
+
+    // The left and right motor speeds of each step as a fraction of the gearset's speed, stored
+    // in pairs. Computed once when the path is saved so following a path does no conversions.
+    // Compacted paths don't keep these, their velocities are converted as they are followed.
+    std::vector<float> commands{};
+
+    // The waypoints the path was generated from and the splines fitted through them, kept so
+    // replan() can reuse them. Paths which were loaded or compacted have no waypoints, and paths
+    // found in the trajectory cache have no splines.
+    std::vector<Waypoint> waypoints{};
+    std::vector<Spline> splines{};
+    std::vector<double> splineLengths{};
+
+    Segment *left() const {
+      return segments.get();
+    }
+
+    Segment *right() const {
+      return segments.get() + length;
+    }
+
+    bool isCompact() const {
+      return segments == nullptr;
+    }
+  };
+
+  /**
+   * An immutable snapshot of every saved path. Path IDs are interned: an ID is given a slot the
+   * first time it is saved and keeps that slot for the life of the controller, so the follower
+   * looks a path up by its slot instead of comparing strings. A path is never changed once it is in
+   * a table. Writers build a new table and swap it in, so a reader can keep using the table (or a
+   * path in it) it loaded for as long as it likes.
+   */
+  struct PathTable {
+    std::unordered_map<std::string, std::size_t> slots{}; // The slot of each interned ID
+    std::vector<std::string> names{};                      // The ID of each slot
+    std::vector<std::shared_ptr<const TrajectoryPair>> paths{}; // The path in each slot, or null
   };
 
   std::shared_ptr<Logger> logger;
-  std::map<std::string, TrajectoryPair> paths{};
   PathfinderLimits limits;
   std::shared_ptr<ChassisModel> model;
   ChassisScales scales;
   AbstractMotor::GearsetRatioPair pair;
   TimeUtil timeUtil;
+  LoopStats loopStats{"AsyncMotionProfileController", timeUtil.getTimer()};
+  TrajectoryCache trajectoryCache{};
+
+  // This must be locked when using the scratch
+  CrossplatformMutex scratchMutex;
+  PathfinderScratch scratch{};
+
+  // Holds the current table so it can be published with an atomic pointer
+  struct PathTableHolder {
+    std::shared_ptr<const PathTable> table;
+  };
+
+  // Use loadPathTable() and storePathTable() to access these. Readers never lock: they count
+  // themselves in pathTableReaders while they copy the table out of the holder. A replaced holder
+  // is kept in retiredPathTables until a store sees no readers, so it is never freed under one.
+  std::atomic<PathTableHolder *> pathTable{
+    new PathTableHolder{std::make_shared<const PathTable>()}};
+  mutable std::atomic_int pathTableReaders{0};
+  std::vector<std::unique_ptr<PathTableHolder>> retiredPathTables{};
+
+  // This must be locked while building and storing a new path table so two writers never lose each
+  // other's changes
+  CrossplatformMutex pathWriteMutex;
 
   // This must be locked when accessing the current path
   CrossplatformMutex currentPathMutex;
 
-  std::string currentPath{""};
+  struct Target {
+    PathHandle path;
+    bool backwards;
+    bool mirrored;
+  };
+
+  // Paths to follow after the current one. currentPathMutex must be locked when accessing this.
+  std::deque<Target> targetQueue{};
+
+  // Followers use these gains if set. currentPathMutex must be locked when accessing these.
+  std::optional<TrajectoryFollower::Gains> followerGains{};
+  QTime followerPeriod{5_ms};
+  std::shared_ptr<Odometry> odometry{nullptr};
+  RamseteFollower::Gains ramseteGains{};
+
+  // The target packed with packTarget(), so setting a target is one atomic store
+  std::atomic_uint32_t target{packTarget(Target{PathHandle(), false, false})};
   std::atomic_bool isRunning{false};
   std::atomic_int direction{1};
   std::atomic_bool mirrored{false};
   std::atomic_bool disabled{false};
   std::atomic_bool dtorCalled{false};
+  std::atomic<PathValidation> pathValidation{PathValidation::warn};
   CrossplatformThread *task{nullptr};
+  std::atomic_bool taskDone{false}; // Set by the task when it exits
+
+  // The path being followed and the path replan() made to replace it. currentPathMutex must be
+  // locked when accessing these.
+  std::shared_ptr<const TrajectoryPair> followingPath{nullptr};
+  std::shared_ptr<const TrajectoryPair> replacementPath{nullptr};
+
+  // Set with replacementPath so followers can check for it every step without locking
+  std::atomic_bool hasReplacement{false};
+
+  struct Progress {
+    const TrajectoryPair *path; // The path being followed
+    int step;                   // The step of the path being followed
+    RamseteFollower::Pose pose; // Where the robot is in the frame of the path
+    double velocity;            // How fast the robot is moving along the path in m/s
+  };
+
+  // Where the followers last saw the robot, published with a sequence lock so followers never
+  // wait. Only the follower task writes these. The sequence is odd while they are being written.
+  // Use publishProgress() and loadProgress() to access these.
+  std::atomic_uint32_t progressSequence{0};
+  std::atomic<const TrajectoryPair *> progressPath{nullptr};
+  std::atomic_int progressStep{-1};
+  std::atomic<double> progressX{0};
+  std::atomic<double> progressY{0};
+  std::atomic<double> progressHeading{0};
+  std::atomic<double> progressVelocity{0};
+
+  struct PathGenerationJob {
+    std::vector<Waypoint> points;
+    std::string pathId;
+    PathHandle path;
+    PathfinderLimits limits;
+  };
+
+  // This must be locked when accessing the generation queue or the path being generated
+  CrossplatformMutex generationMutex;
+
+  std::deque<PathGenerationJob> generationQueue{};
+  PathHandle generatingPath{};
+  CrossplatformThread *generationTask{nullptr};
+  std::atomic_bool generationDone{false}; // Set by the generation task when it exits
 
   static void trampoline(void *context);
   void loop();
 
+  static void generationTrampoline(void *context);
+  void generationLoop();
+
+  struct PathBatch {
+    const std::vector<PathSpec> &specs;
+    std::vector<std::optional<TrajectoryPair>> paths;
+    std::vector<std::string> errors;
+    std::atomic_size_t next{0};
+  };
+
+  struct PathBatchWorker {
+    AsyncMotionProfileController *controller;
+    PathBatch *batch;
+  };
+
+  static void batchTrampoline(void *context);
+
   /**
-   * Follow the supplied path. Must follow the disabled lifecycle.
+   * Generates paths from a batch until every path in it has been taken by a worker.
+   *
+   * @param ibatch The batch to generate.
+   */
+  void generateBatch(PathBatch &ibatch);
+
+  /**
+   * Converts waypoints to the units Pathfinder expects.
+   *
+   * @param iwaypoints The waypoints to convert.
+   * @return The converted waypoints.
+   */
+  static std::vector<Waypoint> toWaypoints(std::initializer_list<PathfinderPoint> iwaypoints);
+
+  /**
+   * Converts waypoints to the units Pathfinder expects.
+   *
+   * @param iwaypoints The waypoints to convert.
+   * @return The converted waypoints.
+   */
+  static std::vector<Waypoint> toWaypoints(const std::vector<PathfinderPoint> &iwaypoints);
+
+  /**
+   * Allocates a path with room for `ilength` segments on each side. Check `segments` for
+   * `nullptr` before using it.
+   *
+   * @param ilength The number of segments on each side.
+   * @param ilimits The limits the path was generated with.
+   * @return The uninitialized path.
+   */
+  static TrajectoryPair allocateTrajectoryPair(int ilength, const PathfinderLimits &ilimits);
+
+  /**
+   * Generates the left and right trajectories for a path without saving it. Throws a
+   * `std::runtime_error` if the path is impossible. This is safe to call from any task as long as
+   * each task uses its own scratch.
+   *
+   * @param points The waypoints to hit on the path.
+   * @param ipathId The identifier of the path, used in error messages.
+   * @param ilimits The limits to use for this path.
+   * @param iscratch The working memory to generate the path in.
+   * @return The generated path.
+   */
+  TrajectoryPair generateTrajectory(std::vector<Waypoint> points,
+                                    const std::string &ipathId,
+                                    const PathfinderLimits &ilimits,
+                                    PathfinderScratch &iscratch);
+
+  /**
+   * Generates the left and right trajectories of a prepared candidate. Throws a
+   * `std::runtime_error` if the path is impossible.
+   *
+   * @param points The waypoints the candidate was prepared from.
+   * @param ipathId The identifier of the path, used in error messages.
+   * @param ilimits The limits to use for this path.
+   * @param istatus The result of preparing the candidate.
+   * @param icandidate The prepared candidate.
+   * @param iscratch The working memory the candidate was prepared in.
+   * @return The generated path.
+   */
+  TrajectoryPair generateTrajectory(std::vector<Waypoint> &points,
+                                    const std::string &ipathId,
+                                    const PathfinderLimits &ilimits,
+                                    int istatus,
+                                    TrajectoryCandidate &icandidate,
+                                    PathfinderScratch &iscratch);
+
+  /**
+   * Generates the left and right trajectories for a path like `generateTrajectory()` and then
+   * checks that the motors can follow it, rejecting or regenerating it as `pathValidation` says.
+   * Throws a `std::runtime_error` if the path is impossible or rejected.
+   *
+   * @param points The waypoints to hit on the path.
+   * @param ipathId The identifier of the path, used in log and error messages.
+   * @param ilimits The limits to use for this path.
+   * @param iscratch The working memory to generate the path in.
+   * @return The generated path.
+   */
+  TrajectoryPair generateValidatedTrajectory(std::vector<Waypoint> points,
+                                             const std::string &ipathId,
+                                             const PathfinderLimits &ilimits,
+                                             PathfinderScratch &iscratch);
+
+  /**
+   * Logs what a generated path asks of the robot and applies `pathValidation` to it. Throws a
+   * `std::runtime_error` if the path is rejected, or if it is still too fast after it was
+   * rescaled.
+   *
+   * @param ipath The generated path.
+   * @param ipathId The identifier of the path, used in log and error messages.
+   * @param irescaled Whether the path was already generated again with rescaled limits.
+   * @return The limits to generate the path again with, or empty if the path can be saved as is.
+   */
+  std::optional<PathfinderLimits> applyPathValidation(const TrajectoryPair &ipath,
+                                                      const std::string &ipathId,
+                                                      bool irescaled) const;
+
+  /**
+   * Finds what a path asks of the robot in one pass over it.
+   *
+   * @param ipath The path to check.
+   * @return The report of the path.
+   */
+  PathReport validatePath(const TrajectoryPair &ipath) const;
+
+  /**
+   * Explains why Pathfinder could not prepare a path.
+   *
+   * @param points The waypoints of the path.
+   * @param ilimits The limits of the path.
+   * @return The most likely reason.
+   */
+  static std::string describePathProblem(const std::vector<Waypoint> &points,
+                                         const PathfinderLimits &ilimits);
+
+  /**
+   * @return The current path table.
+   */
+  std::shared_ptr<const PathTable> loadPathTable() const;
+
+  /**
+   * Makes a new path table visible to readers and frees the tables they no longer use.
+   * `pathWriteMutex` must be locked.
+   *
+   * @param itable The new path table.
+   */
+  void storePathTable(std::shared_ptr<const PathTable> itable);
+
+  /**
+   * Looks up a path in the current path table. The path stays valid for as long as the returned
+   * pointer is held, even if it is removed or replaced in the meantime.
+   *
+   * @param ipathId The identifier of the path.
+   * @return The path, or `nullptr` if there is no path with that identifier.
+   */
+  std::shared_ptr<const TrajectoryPair> findPath(const std::string &ipathId) const;
+
+  /**
+   * Looks up a path in a path table.
+   *
+   * @param itable The table to look in.
+   * @param ipath The handle of the path.
+   * @return The path, or `nullptr` if there is no path with that handle.
+   */
+  static std::shared_ptr<const TrajectoryPair> findPath(const PathTable &itable, PathHandle ipath);
+
+  /**
+   * Looks up the handle of a path ID without giving the ID a handle if it does not have one.
+   *
+   * @param ipathId The identifier of the path.
+   * @return The handle, or an invalid handle if the ID has not been used.
+   */
+  PathHandle findPathHandle(const std::string &ipathId) const;
+
+  /**
+   * @param ipath The handle of a path.
+   * @return The identifier of the path, or an empty string if the handle is invalid.
+   */
+  std::string getPathId(PathHandle ipath) const;
+
+  /**
+   * Packs a target into one word so it can be stored atomically.
+   *
+   * @param itarget The target to pack.
+   * @return The packed target.
+   */
+  static std::uint32_t packTarget(const Target &itarget);
+
+  /**
+   * @param ipacked A target from `packTarget()`.
+   * @return The unpacked target.
+   */
+  static Target unpackTarget(std::uint32_t ipacked);
+
+  /**
+   * Puts a path in a table, interning its identifier if it is new.
+   *
+   * @param itable The table to change.
+   * @param ipathId The identifier of the path.
+   * @param ipath The path, or `nullptr` to remove the path.
+   * @return The handle of the path.
+   */
+  static PathHandle setPath(PathTable &itable,
+                            const std::string &ipathId,
+                            std::shared_ptr<const TrajectoryPair> ipath);
+
+  /**
+   * Saves a path, replacing any existing path with the same identifier.
+   *
+   * @param ipathId The identifier to save the path with.
+   * @param ipath The path to save.
+   * @return The handle of the path.
+   */
+  PathHandle insertPath(const std::string &ipathId, TrajectoryPair &&ipath);
+
+  /**
+   * Follow the supplied path. Must follow the disabled lifecycle, and must return as soon as
+   * `isInterrupted()` so the loop can switch to the replanned path or exit.
    */
   virtual void executeSinglePath(const TrajectoryPair &path, std::unique_ptr<AbstractRate> rate);
 
+  /**
+   * @return Whether the path being followed should stop right away, because the controller was
+   * disabled or destroyed or `replan()` made a path to replace it.
+   */
+  bool isInterrupted() const;
+
+  /**
+   * Follow the supplied path with a `RamseteFollower` using odometry. The path must not be
+   * compacted. Must follow the disabled lifecycle.
+   *
+   * @param path The path to follow.
+   * @param iodometry The odometry to read the pose from.
+   * @param igains The follower gains.
+   * @param rate The rate to delay with.
+   */
+  void followSinglePathWithOdometry(const TrajectoryPair &path,
+                                    const std::shared_ptr<Odometry> &iodometry,
+                                    const RamseteFollower::Gains &igains,
+                                    std::unique_ptr<AbstractRate> rate);
+
+  /**
+   * Follow the supplied path with a `TrajectoryFollower` on each wheel. Must follow the disabled
+   * lifecycle.
+   *
+   * @param path The path to follow.
+   * @param igains The follower gains.
+   * @param iperiod How often to update the wheel voltages.
+   * @param rate The rate to delay with.
+   */
+  void followSinglePath(const TrajectoryPair &path,
+                        const TrajectoryFollower::Gains &igains,
+                        QTime iperiod,
+                        std::unique_ptr<AbstractRate> rate);
+
+  /**
+   * Records where the robot is so `replan()` can start from there. Followers call this once per
+   * step, so it never locks. Must only be called by the follower task.
+   *
+   * @param ipath The path being followed.
+   * @param istep The step of the path being followed.
+   * @param ipose Where the robot is in the frame of the path.
+   * @param ivelocity How fast the robot is moving along the path in m/s.
+   */
+  void publishProgress(const TrajectoryPair &ipath,
+                       int istep,
+                       const RamseteFollower::Pose &ipose,
+                       double ivelocity);
+
+  /**
+   * Reads the progress last published by a follower without waiting for it.
+   *
+   * @return Where the robot was when a follower last published its progress.
+   */
+  Progress loadProgress() const;
+
+  /**
+   * Finds where the center of the robot should be at a step of a path. The path must not be
+   * compacted.
+   *
+   * @param ipath The path.
+   * @param istep The step.
+   * @return The pose of the center of the robot in the frame of the path.
+   */
+  static RamseteFollower::Pose plannedPose(const TrajectoryPair &ipath, int istep);
+
+  /**
+   * Computes the motor speeds for each step of a path.
+   *
+   * @param ipath The path to compute the motor speeds for. Must not be compacted.
+   */
+  void computeCommands(TrajectoryPair &ipath) const;
+
   /**
    * Converts linear chassis speed to rotational motor speed.
    *
@@ -323,11 +1086,21 @@ class AsyncMotionProfileController : public AsyncPositionController<std::string,
   void internalLoadPath(FILE *leftPathFile, FILE *rightPathFile, const std::string &ipathId);
 
   /**
-   * Reads the length of the path in a thread-safe manner.
+   * Writes a path to a binary trajectory file.
+   *
+   * @param pathFile The file to write to.
+   * @param ipathId The path ID of the generated path.
+   * @return True if the path exists and was written.
+   */
+  bool internalStorePathBinary(FILE *pathFile, const std::string &ipathId);
+
+  /**
+   * Reads a path from a binary trajectory file.
    *
-   * @param path The path to read from.
-   * @return The length of the path.
+   * @param pathFile The file to read from.
+   * @param ipathId The path ID that the path will be loaded into.
+   * @return True if the path was loaded.
    */
-  int getPathLength(const TrajectoryPair &path);
+  bool internalLoadPathBinary(FILE *pathFile, const std::string &ipathId);
 };
 } // namespace okapi
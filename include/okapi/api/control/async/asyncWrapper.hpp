@@ -12,8 +12,10 @@
 #include "okapi/api/coreProsAPI.hpp"
 #include "okapi/api/util/abstractRate.hpp"
 #include "okapi/api/util/logging.hpp"
+#include "okapi/api/util/loopStats.hpp"
 #include "okapi/api/util/mathUtil.hpp"
 #include "okapi/api/util/supplier.hpp"
+#include "okapi/api/util/timeUtil.hpp"
 #include <atomic>
 #include <memory>
 
@@ -43,7 +45,36 @@ class AsyncWrapper : virtual public AsyncController<Input, Output> {
       input(iinput),
       output(ioutput),
       controller(icontroller),
-      ratio(iratio) {
+      ratio(iratio),
+      loopStats("AsyncWrapper", nullptr) {
+  }
+
+  /**
+   * A wrapper class that transforms an `IterativeController` into an `AsyncController` by running
+   * it in another task. The input controller will act like an `AsyncController`. Unlike the other
+   * constructor, the timer from `itimeUtil` lets the task be measured with `getLoopStats()`.
+   *
+   * @param iinput controller input, passed to the `IterativeController`
+   * @param ioutput controller output, written to from the `IterativeController`
+   * @param icontroller the controller to use
+   * @param itimeUtil used for rates used in the main loop and in `waitUntilSettled`, and for
+   * measuring the main loop
+   * @param iratio Any external gear ratio.
+   * @param ilogger The logger this instance will log to.
+   */
+  AsyncWrapper(const std::shared_ptr<ControllerInput<Input>> &iinput,
+               const std::shared_ptr<ControllerOutput<Output>> &ioutput,
+               const std::shared_ptr<IterativeController<Input, Output>> &icontroller,
+               const TimeUtil &itimeUtil,
+               const double iratio = 1,
+               std::shared_ptr<Logger> ilogger = Logger::getDefaultLogger())
+    : logger(std::move(ilogger)),
+      rateSupplier(itimeUtil.getRateSupplier()),
+      input(iinput),
+      output(ioutput),
+      controller(icontroller),
+      ratio(iratio),
+      loopStats("AsyncWrapper", itimeUtil.getTimer()) {
   }
 
   AsyncWrapper(AsyncWrapper<Input, Output> &&other) = delete;
@@ -240,6 +271,17 @@ class AsyncWrapper : virtual public AsyncController<Input, Output> {
     return task;
   }
 
+  /**
+   * Returns the timing statistics of the task which runs the controller. Measuring is off until
+   * `getLoopStats().setEnabled(true)` is called, and is only possible if this wrapper was given a
+   * `TimeUtil`.
+   *
+   * @return The timing statistics of the controller task.
+   */
+  LoopStats &getLoopStats() {
+    return loopStats;
+  }
+
   protected:
   std::shared_ptr<Logger> logger;
   Supplier<std::unique_ptr<AbstractRate>> rateSupplier;
@@ -251,6 +293,7 @@ class AsyncWrapper : virtual public AsyncController<Input, Output> {
   double ratio;
   std::atomic_bool dtorCalled{false};
   CrossplatformThread *task{nullptr};
+  LoopStats loopStats;
 
   static void trampoline(void *context) {
     if (context) {
@@ -265,7 +308,7 @@ class AsyncWrapper : virtual public AsyncController<Input, Output> {
         output->controllerSet(controller->step(input->controllerGet()));
       }
 
-      rate->delayUntil(controller->getSampleTime());
+      loopStats.delayUntil(*rate, controller->getSampleTime());
     }
   }
 
@@ -7,6 +7,13 @@
 
 #include "okapi/api/units/QAngle.hpp"
 #include "okapi/api/units/QLength.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+extern "C" {
+#include "okapi/pathfinder/include/pathfinder.h"
+}
 
 namespace okapi {
 struct PathfinderPoint {
@@ -15,9 +22,229 @@ struct PathfinderPoint {
   QAngle theta; // Exit angle relative to the start of the movement
 };
 
+/**
+ * How splines are fitted between waypoints.
+ */
+enum class PathfinderFit : std::int32_t {
+  hermiteCubic,       ///< Cubic splines. Curvature jumps at each waypoint.
+  hermiteQuintic,     ///< Quintic splines which are straight at each waypoint.
+  curvatureContinuous ///< Quintic splines whose curvature matches at each waypoint.
+};
+
+/**
+ * The default largest error in the measured length of each spline when generating a path, in
+ * meters. Splines are measured with adaptive Gauss-Kronrod quadrature, so this costs about as much
+ * as `PATHFINDER_SAMPLES_FAST` while being far more accurate than `PATHFINDER_SAMPLES_HIGH`.
+ */
+constexpr double pathfinderLengthTolerance = 1e-6;
+
 struct PathfinderLimits {
   double maxVel;   // Maximum robot velocity in m/s
   double maxAccel; // Maximum robot acceleration in m/s/s
   double maxJerk;  // Maximum robot jerk in m/s/s/s
+  PathfinderFit fit{PathfinderFit::hermiteCubic};
+
+  /**
+   * Maximum velocity of either wheel of a tank drive in m/s, or 0 for no limit. When this or
+   * `maxWheelAccel` is set, the robot slows down on curves so the outer wheel stays within these
+   * limits. Jerk is not limited in this mode.
+   */
+  double maxWheelVel{0};
+  double maxWheelAccel{0}; // Maximum acceleration of either wheel in m/s/s, or 0 for no limit
+
+  /**
+   * The velocities at the start and end of the path in m/s. A path which ends at the velocity the
+   * next path starts at can be chained to it with `AsyncMotionProfileController::queueTarget()`
+   * without stopping in between. If the path is too short to change between these and its other
+   * limits, the start velocity is lowered or the end velocity is not reached. Like the wheel
+   * limits, jerk is not limited when either of these is not zero.
+   */
+  double startVel{0};
+  double endVel{0};
+
+  /**
+   * How the length of each spline is measured. If `lengthTolerance` is positive, splines are
+   * measured with adaptive Gauss-Kronrod quadrature to within that many meters. If it is 0, they
+   * are measured by summing `lengthSamples` samples instead, and each segment is looked up in a
+   * table of those sums, which can be faster for small sample counts but is far less accurate.
+   */
+  double lengthTolerance{pathfinderLengthTolerance};
+  int lengthSamples{PATHFINDER_SAMPLES_FAST};
+
+  bool operator==(const PathfinderLimits &other) const;
+  bool operator!=(const PathfinderLimits &other) const;
+};
+
+/**
+ * Reusable working memory for trajectory generation. Pathfinder needs memory for the fitted
+ * splines, the center trajectory and a filter buffer while generating a path, none of which is
+ * kept afterwards. Keeping that memory in one of these between paths means repeated generation
+ * does not allocate once the buffers are large enough. A scratch must only be used by one task at
+ * a time.
+ */
+class PathfinderScratch {
+  public:
+  /**
+   * Grows the buffers to fit a path.
+   *
+   * @param ipathLength The number of waypoints.
+   * @param itrajectoryLength The number of segments in the trajectory, or 0 if it is not known
+   * yet.
+   * @param isampleCount The number of samples per spline, or 0 if no arc length table is needed.
+   */
+  void reserve(int ipathLength, int itrajectoryLength, int isampleCount = 0);
+
+  /**
+   * Grows the buffers used to build a wheel-limited velocity profile.
+   *
+   * @param igridLength The number of points the path is divided into.
+   */
+  void reserveProfile(int igridLength);
+
+  Spline *splines();
+  double *splineLengths();
+  Segment *segments();
+  double *buffer();
+  double *table();
+  Segment *grid();
+  double *profile();
+
+  protected:
+  std::vector<Spline> splineData{};
+  std::vector<double> splineLengthData{};
+  std::vector<Segment> segmentData{};
+  std::vector<double> bufferData{};
+  std::vector<double> tableData{};
+  std::vector<Segment> gridData{};
+  std::vector<double> profileData{};
 };
+
+/**
+ * Fits splines through waypoints and measures them so the trajectory can be generated with
+ * `pathfinder_generate_into()`. The splines are stored in the scratch.
+ *
+ * @param ipoints The waypoints in meters and radians.
+ * @param ilimits The limits and fit to use.
+ * @param idt The time step in seconds.
+ * @param iscratch The working memory to fit the splines in.
+ * @param ocandidate The prepared candidate.
+ * @return The length of the trajectory, or a negative number if the path is impossible.
+ */
+int preparePathfinderCandidate(std::vector<Waypoint> &ipoints,
+                               const PathfinderLimits &ilimits,
+                               double idt,
+                               PathfinderScratch &iscratch,
+                               TrajectoryCandidate &ocandidate);
+
+/**
+ * Prepares a candidate like the other overload, but reuses splines which were already fitted and
+ * measured. The last `icachedCount` splines are copied from `icachedSplines` and keep the lengths
+ * in `icachedLengths`, and only the splines before them are fitted and measured. Splines which
+ * keep their curvature continuous depend on their neighbors, so with that fit every spline is
+ * fitted and measured again.
+ *
+ * @param ipoints The waypoints in meters and radians.
+ * @param ilimits The limits and fit to use.
+ * @param idt The time step in seconds.
+ * @param icachedSplines The splines between the last `icachedCount + 1` waypoints.
+ * @param icachedLengths The lengths of those splines.
+ * @param icachedCount The number of splines to reuse.
+ * @param iscratch The working memory to fit the splines in.
+ * @param ocandidate The prepared candidate.
+ * @return The length of the trajectory, or a negative number if the path is impossible.
+ */
+int preparePathfinderCandidate(std::vector<Waypoint> &ipoints,
+                               const PathfinderLimits &ilimits,
+                               double idt,
+                               const Spline *icachedSplines,
+                               const double *icachedLengths,
+                               int icachedCount,
+                               PathfinderScratch &iscratch,
+                               TrajectoryCandidate &ocandidate);
+
+/**
+ * Generates the center trajectory of a prepared candidate into `iscratch.segments()`. If the
+ * limits include a wheel velocity or acceleration limit, or a start or end velocity, the velocity
+ * profile is built along the path so that, after `pathfinder_modify_tank()`, neither wheel exceeds
+ * the wheel limits. Otherwise this is the same as `pathfinder_generate_into()`.
+ *
+ * @param icandidate The candidate from `preparePathfinderCandidate()`. Its length is updated to
+ * the length of the generated trajectory.
+ * @param ilimits The limits the candidate was prepared with.
+ * @param iwheelTrack The wheel track in meters.
+ * @param iscratch The scratch the candidate was prepared in.
+ * @return The length of the trajectory, or a negative number if it could not be generated.
+ */
+int generatePathfinderTrajectory(TrajectoryCandidate &icandidate,
+                                 const PathfinderLimits &ilimits,
+                                 double iwheelTrack,
+                                 PathfinderScratch &iscratch);
+
+/**
+ * The header of a binary trajectory file. A trajectory file is this header followed by `sides`
+ * arrays of `length` segments each, stored back to back.
+ *
+ * The header is stored field by field in little-endian byte order: the magic number, the format
+ * version and the size in bytes of the fields which follow, then `sides` and `length` as 32-bit
+ * integers, `dt` and `wheelTrack` as doubles, and the limits in the order they are declared, each
+ * as a double except `fit`, which is one byte, and `lengthSamples`, which is a 32-bit integer.
+ * New fields are only ever added to the end and don't change the version, so a file can be read by
+ * both older and newer versions of OkapiLib: fields a reader doesn't know about are skipped, and
+ * fields missing from an older file keep their default value. A reader accepts every version from
+ * `oldestReadableVersion` to `currentVersion`; the version only changes if the layout changes in a
+ * way an older reader could not skip. Segments are
+ * stored as they are in memory, as 8 doubles each, which is little-endian on the V5 brain and on
+ * x86 hosts.
+ */
+struct TrajectoryFileHeader {
+  static constexpr std::uint32_t magicNumber = 0x54504b4f; // "OKPT" when read as bytes
+  static constexpr std::uint32_t currentVersion = 5;
+
+  // Versions before this stored the header as a raw struct, so they can't be read
+  static constexpr std::uint32_t oldestReadableVersion = 5;
+
+  std::uint32_t magic{magicNumber};
+  std::uint32_t version{currentVersion};
+  std::int32_t sides{0};  // Number of segment arrays (2 for a tank drive, 1 for a linear path)
+  std::int32_t length{0}; // Number of segments in each array
+  double dt{0};           // Time step of each segment in seconds
+  PathfinderLimits limits{0, 0, 0};
+  double wheelTrack{0}; // Wheel track in meters, or 0 if it does not apply
+};
+
+/**
+ * Writes a binary trajectory file. `isides` must point to `iheader.sides` segment arrays, each of
+ * which holds `iheader.length` segments.
+ *
+ * @param ifile The file to write to. Must be opened in binary write mode.
+ * @param iheader The header to write.
+ * @param isides The segment arrays to write.
+ * @return True if everything was written.
+ */
+bool writeTrajectoryFile(FILE *ifile,
+                         const TrajectoryFileHeader &iheader,
+                         const Segment *const *isides);
+
+/**
+ * Reads and checks the header of a binary trajectory file. The file position is left at the start
+ * of the segment data so it can be read with `readTrajectoryFileSegments()`.
+ *
+ * @param ifile The file to read from. Must be opened in binary read mode.
+ * @param oheader The header that was read.
+ * @return True if a header with a known magic number and version was read.
+ */
+bool readTrajectoryFileHeader(FILE *ifile, TrajectoryFileHeader &oheader);
+
+/**
+ * Reads the segment data which follows a header. Each segment array is read with a single read.
+ *
+ * @param ifile The file to read from, positioned after the header.
+ * @param iheader The header returned by `readTrajectoryFileHeader()`.
+ * @param osides Where to store the segments. Must point to `iheader.sides` arrays, each of which
+ * has room for `iheader.length` segments.
+ * @return True if all of the segments were read.
+ */
+bool readTrajectoryFileSegments(FILE *ifile,
+                                const TrajectoryFileHeader &iheader,
+                                Segment *const *osides);
 } // namespace okapi
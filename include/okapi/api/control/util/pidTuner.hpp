@@ -60,6 +60,9 @@ class PIDTuner {
   };
 
   std::shared_ptr<Logger> logger;
+  const std::uint16_t iterationFormat;
+  const std::uint16_t particleFormat;
+  const std::uint16_t errorFormat;
   TimeUtil timeUtil;
   std::shared_ptr<ControllerInput<double>> input;
   std::shared_ptr<ControllerOutput<double>> output;
@@ -0,0 +1,81 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include "okapi/api/control/util/pathfinderUtil.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace okapi {
+class PlaybackTrajectory {
+  public:
+  enum class encoding {
+    float32, ///< 4 bytes per step per side
+    int16    ///< 2 bytes per step per side, quantized to 1/32767 of the fastest velocity
+  };
+
+  PlaybackTrajectory() = default;
+
+  /**
+   * A trajectory which only holds what is needed to play it back: the velocity of each side at
+   * each step and one time step shared by every step. This is a fraction of the size of the full
+   * segments it is converted from, so many more paths can be kept in memory at once. Positions and
+   * headings are not kept, so a playback trajectory can not be exported or used to compute error.
+   *
+   * @param isides `isideCount` segment arrays of `ilength` segments each.
+   * @param isideCount The number of segment arrays.
+   * @param ilength The number of segments in each array.
+   * @param iencoding How to store the velocities.
+   */
+  PlaybackTrajectory(const Segment *const *isides,
+                     std::int32_t isideCount,
+                     std::int32_t ilength,
+                     encoding iencoding = encoding::float32);
+
+  /**
+   * @return The number of sides.
+   */
+  std::int32_t getSides() const;
+
+  /**
+   * @return The number of steps on each side.
+   */
+  std::int32_t getLength() const;
+
+  /**
+   * @return The time step in seconds.
+   */
+  double getDt() const;
+
+  /**
+   * @return How the velocities are stored.
+   */
+  encoding getEncoding() const;
+
+  /**
+   * @param iside The index of the side.
+   * @param istep The index of the step.
+   * @return The velocity of the side at the step in m/s.
+   */
+  double getVelocity(std::int32_t iside, std::int32_t istep) const;
+
+  /**
+   * @return The amount of memory used by the velocities in bytes.
+   */
+  std::size_t getSize() const;
+
+  protected:
+  std::int32_t sides{0};
+  std::int32_t length{0};
+  double dt{0};
+  encoding velocityEncoding{encoding::float32};
+
+  // Only the vector for the encoding in use holds data. Sides are stored back to back.
+  std::vector<float> floatVelocities{};
+  std::vector<std::int16_t> quantizedVelocities{};
+  std::vector<double> scales{}; // Velocity of one quantization step for each side in m/s
+};
+} // namespace okapi
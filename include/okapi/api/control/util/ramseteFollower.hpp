@@ -0,0 +1,60 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+namespace okapi {
+class RamseteFollower {
+  public:
+  struct Gains {
+    double b{2.0};    // How strongly to correct position errors, in rad^2/m^2. Must be positive.
+    double zeta{0.7}; // Damping of the correction, between 0 and 1
+  };
+
+  /**
+   * A pose in Pathfinder's coordinates: +x is forward, +y is left, and angles are counterclockwise
+   * from +x.
+   */
+  struct Pose {
+    double x;       // In meters
+    double y;       // In meters
+    double heading; // In radians
+  };
+
+  struct Output {
+    double linear;  // Linear velocity in m/s
+    double angular; // Angular velocity in rad/s, counterclockwise
+  };
+
+  /**
+   * A nonlinear controller which steers a differential drive robot back onto a trajectory using
+   * its measured pose. The output is the target velocity of the robot plus a correction for the
+   * difference between the target and measured poses. With no error, the output equals the target
+   * velocity.
+   *
+   * @param igains The gains.
+   */
+  explicit RamseteFollower(const Gains &igains);
+
+  /**
+   * A RamseteFollower with the default gains.
+   */
+  RamseteFollower();
+
+  /**
+   * Calculates the velocity to drive at.
+   *
+   * @param itarget The pose the robot should be at.
+   * @param ilinear The linear velocity of the trajectory in m/s.
+   * @param iangular The angular velocity of the trajectory in rad/s, counterclockwise.
+   * @param ipose The measured pose of the robot.
+   * @return The velocity to drive at.
+   */
+  Output step(const Pose &itarget, double ilinear, double iangular, const Pose &ipose) const;
+
+  protected:
+  Gains gains;
+};
+} // namespace okapi
@@ -0,0 +1,82 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+namespace okapi {
+class SCurveProfile {
+  public:
+  struct State {
+    double position;
+    double velocity;
+    double acceleration;
+  };
+
+  /**
+   * A time-optimal one dimensional motion profile which starts and ends at rest. The velocity
+   * follows an S-curve which stays within a maximum velocity, acceleration, and jerk. If the jerk
+   * is zero, it is not limited and the velocity follows a trapezoid instead. If the distance is too
+   * short to reach the maximum velocity or acceleration, the profile peaks below them.
+   *
+   * The profile is solved in closed form when it is constructed, so sampling it is cheap enough to
+   * do in every iteration of a control loop. Any consistent units can be used.
+   *
+   * @param idistance The signed distance to move.
+   * @param imaxVel The maximum velocity. Must be positive.
+   * @param imaxAccel The maximum acceleration. Must be positive.
+   * @param imaxJerk The maximum jerk, or zero for no limit.
+   */
+  SCurveProfile(double idistance, double imaxVel, double imaxAccel, double imaxJerk = 0);
+
+  /**
+   * An empty profile which is always finished.
+   */
+  SCurveProfile();
+
+  /**
+   * Samples the profile. Times before the start give the starting state and times after the end
+   * give the final state.
+   *
+   * @param itime The time since the start of the profile.
+   * @return The state at that time.
+   */
+  State sample(double itime) const;
+
+  /**
+   * @return The total time the profile takes.
+   */
+  double getDuration() const;
+
+  /**
+   * @return The signed distance the profile moves.
+   */
+  double getDistance() const;
+
+  protected:
+  double distance{0};
+  double sign{1};
+  double jerk{0};
+  double peakVel{0};
+  double peakAccel{0};
+
+  // The time spent ramping the acceleration up (and down again), at the peak acceleration, and
+  // reaching the peak velocity in total. Slowing down is the same in reverse.
+  double jerkTime{0};
+  double constAccelTime{0};
+  double accelTime{0};
+  double accelDistance{0};
+
+  double cruiseTime{0};
+  double duration{0};
+
+  /**
+   * Samples the first half of the profile while the velocity increases.
+   *
+   * @param itime The time since the start of the profile, within `[0, accelTime]`.
+   * @return The unsigned state at that time.
+   */
+  State sampleAccel(double itime) const;
+};
+} // namespace okapi
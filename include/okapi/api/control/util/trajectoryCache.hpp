@@ -0,0 +1,130 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include "okapi/api/control/util/pathfinderUtil.hpp"
+#include "okapi/api/coreProsAPI.hpp"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace okapi {
+class TrajectoryCache {
+  public:
+  struct Entry {
+    TrajectoryFileHeader header;
+    std::vector<Segment> segments;
+
+    /**
+     * @param iside The index of the segment array.
+     * @return The start of the segment array.
+     */
+    const Segment *side(std::int32_t iside) const;
+  };
+
+  /**
+   * A thread-safe cache of generated trajectories, keyed by the inputs they were generated from.
+   * Entries are kept in memory until the cache is larger than its maximum size, at which point the
+   * least recently used entries are evicted. Entries can also be persisted to a directory (for
+   * example on the SD card) so they survive across program runs.
+   *
+   * @param imaxBytes The maximum amount of segment memory to keep in the cache. Zero disables the
+   * in-memory cache.
+   */
+  explicit TrajectoryCache(std::size_t imaxBytes = 512 * 1024);
+
+  /**
+   * Computes the key of a trajectory. Every input which changes the generated trajectory must be
+   * part of the key.
+   *
+   * @param ipoints The waypoints in meters and radians.
+   * @param ilimits The limits the trajectory is generated with.
+   * @param iwheelTrack The wheel track in meters, or 0 if it does not apply.
+   * @param idt The time step in seconds.
+   * @param isides The number of segment arrays in the trajectory.
+   * @return The key.
+   */
+  static std::uint64_t makeKey(const std::vector<Waypoint> &ipoints,
+                               const PathfinderLimits &ilimits,
+                               double iwheelTrack,
+                               double idt,
+                               std::int32_t isides);
+
+  /**
+   * Looks up a trajectory. If it is not in memory but the cache has a directory, the trajectory is
+   * loaded from that directory.
+   *
+   * @param ikey The key from `makeKey()`.
+   * @return The cached trajectory, or `nullptr` if there is none.
+   */
+  std::shared_ptr<const Entry> find(std::uint64_t ikey);
+
+  /**
+   * Adds a trajectory to the cache, evicting the least recently used entries if the cache is too
+   * large. The trajectory is also written to the cache directory if there is one.
+   *
+   * @param ikey The key from `makeKey()`.
+   * @param iheader A description of the trajectory.
+   * @param isides `iheader.sides` segment arrays of `iheader.length` segments each.
+   */
+  void insert(std::uint64_t ikey,
+              const TrajectoryFileHeader &iheader,
+              const Segment *const *isides);
+
+  /**
+   * Sets the directory trajectories are persisted to. The directory must already exist. An empty
+   * string disables persistence.
+   *
+   * @param idirectory The directory, for example `/usd/paths`.
+   */
+  void setDirectory(const std::string &idirectory);
+
+  /**
+   * Sets the maximum amount of segment memory to keep in the cache, evicting entries if needed.
+   *
+   * @param imaxBytes The maximum size in bytes. Zero disables the in-memory cache.
+   */
+  void setMaxSize(std::size_t imaxBytes);
+
+  /**
+   * @return The amount of segment memory currently held by the cache in bytes.
+   */
+  std::size_t getSize();
+
+  /**
+   * Removes every entry from memory. Persisted entries are not deleted.
+   */
+  void clear();
+
+  protected:
+  struct Slot {
+    std::shared_ptr<const Entry> entry;
+    std::list<std::uint64_t>::iterator position;
+  };
+
+  // This must be locked when accessing any of the members below
+  CrossplatformMutex mutex;
+
+  std::size_t maxBytes;
+  std::size_t size{0};
+  std::string directory{""};
+
+  // Most recently used keys are at the front
+  std::list<std::uint64_t> recency{};
+  std::unordered_map<std::uint64_t, Slot> entries{};
+
+  void insertInMemory(std::uint64_t ikey, std::shared_ptr<const Entry> ientry);
+  void evict();
+
+  static std::string makeFilePath(const std::string &idirectory, std::uint64_t ikey);
+  static std::shared_ptr<const Entry> load(const std::string &idirectory, std::uint64_t ikey);
+  static void store(const std::string &idirectory, std::uint64_t ikey, const Entry &ientry);
+  static std::size_t sizeOf(const Entry &ientry);
+};
+} // namespace okapi
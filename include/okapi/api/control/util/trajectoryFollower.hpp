@@ -0,0 +1,56 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+namespace okapi {
+class TrajectoryFollower {
+  public:
+  struct Gains {
+    double kV{0}; // Output per m/s of target velocity
+    double kA{0}; // Output per m/s/s of target acceleration
+    double kS{0}; // Output needed to overcome static friction
+    double kP{0}; // Output per meter of position error
+  };
+
+  /**
+   * Follows the velocities of one side of a trajectory using feedforward and encoder feedback. The
+   * output is `kS * sgn(v) + kV * v + kA * a + kP * e`, where `e` is the distance the wheel is
+   * behind the trajectory. The output is a fraction of the maximum voltage in the range [-1, 1].
+   *
+   * @param igains The gains.
+   */
+  explicit TrajectoryFollower(const Gains &igains);
+
+  /**
+   * Calculates the output for the next `idt` seconds. The target position first advances by
+   * `itargetVelocity * idt`, so the error is how far the wheel is from where it should be at the
+   * end of that time.
+   *
+   * @param itargetVelocity The velocity of the trajectory in m/s.
+   * @param itargetAcceleration The acceleration of the trajectory in m/s/s.
+   * @param iposition The distance the wheel has traveled since the start of the trajectory in
+   * meters.
+   * @param idt The time since the last step in seconds.
+   * @return The output in the range [-1, 1].
+   */
+  double step(double itargetVelocity, double itargetAcceleration, double iposition, double idt);
+
+  /**
+   * @return The distance the wheel was behind the trajectory at the last step in meters.
+   */
+  double getError() const;
+
+  /**
+   * Moves the target back to the start of the trajectory.
+   */
+  void reset();
+
+  protected:
+  Gains gains;
+  double targetPosition{0};
+  double error{0};
+};
+} // namespace okapi
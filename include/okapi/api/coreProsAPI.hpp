@@ -13,6 +13,7 @@
 #include <cstdlib>
 #include <functional>
 #include <sstream>
+#include <string>
 
 #ifdef THREADS_STD
 #include <thread>
@@ -38,18 +39,23 @@ class CrossplatformThread {
 #ifdef THREADS_STD
   CrossplatformThread(void (*ptr)(void *),
                       void *params,
-                      const char *const = "OkapiLibCrossplatformTask")
+                      const char *const name = "OkapiLibCrossplatformTask",
+                      const std::uint32_t = 0)
 #else
   CrossplatformThread(void (*ptr)(void *),
                       void *params,
-                      const char *const name = "OkapiLibCrossplatformTask")
+                      const char *const name = "OkapiLibCrossplatformTask",
+                      const std::uint32_t priority = TASK_PRIORITY_DEFAULT)
 #endif
     :
 #ifdef THREADS_STD
-      thread(ptr, params)
+      // Name the thread from inside it, the same way the brain names a task when creating it
+      thread([ptr, params, taskName = std::string(name)]() {
+        setName(taskName.c_str());
+        ptr(params);
+      })
 #else
-      thread(
-        pros::c::task_create(ptr, params, TASK_PRIORITY_DEFAULT, TASK_STACK_DEPTH_DEFAULT, name))
+      thread(pros::c::task_create(ptr, params, priority, TASK_STACK_DEPTH_DEFAULT, name))
 #endif
   {
   }
@@ -93,16 +99,52 @@ class CrossplatformThread {
 #endif
 
   static std::string getName() {
+    return std::string(getCurrentName());
+  }
+
+  /**
+   * Gets the name of the calling task without allocating. On the brain this is the name kept by
+   * the task itself. Otherwise it is kept per thread and defaults to the ID of the thread, which
+   * is only formatted the first time.
+   *
+   * @return The name of the calling task, valid until the task ends or is renamed.
+   */
+  static const char *getCurrentName() {
 #ifdef THREADS_STD
-    std::ostringstream ss;
-    ss << std::this_thread::get_id();
-    return ss.str();
+    return currentName().c_str();
 #else
-    return std::string(pros::c::task_get_name(NULL));
+    return pros::c::task_get_name(NULL);
 #endif
   }
 
+  /**
+   * Names the calling thread in log statements. Tasks on the brain are named when they are
+   * created, so this only renames threads on other platforms.
+   *
+   * @param iname The new name.
+   */
+#ifdef THREADS_STD
+  static void setName(const char *const iname) {
+    currentName() = iname;
+  }
+#else
+  static void setName(const char *const) {
+  }
+#endif
+
   CROSSPLATFORM_THREAD_T thread;
+
+#ifdef THREADS_STD
+  protected:
+  static std::string &currentName() {
+    thread_local std::string name = []() {
+      std::ostringstream ss;
+      ss << std::this_thread::get_id();
+      return ss.str();
+    }();
+    return name;
+  }
+#endif
 };
 
 class CrossplatformMutex {
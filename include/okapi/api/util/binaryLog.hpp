@@ -0,0 +1,215 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace okapi {
+/**
+ * The blocks of a binary log written by a `Logger` with `Logger::Encoding::binary`. Each block
+ * starts with its tag byte. All numbers are little endian.
+ */
+enum class BinaryLogBlock : std::uint8_t {
+  header = 1, ///< "OKLG" and a version byte. Starts a session, forgetting all formats and threads.
+  format = 2, ///< A u16 format ID, then the format as a u16 length and that many bytes.
+  thread = 3, ///< A u8 thread ID, then the name of the thread as a u8 length and that many bytes.
+  record = 4, ///< A u8 level, u32 time in us, u16 format, u8 thread, u8 count, then the arguments.
+  dropped = 5 ///< A u32 number of log statements dropped because the buffer was full.
+};
+
+/**
+ * The type tag which starts each argument of a binary log record.
+ */
+enum class BinaryLogArg : std::uint8_t {
+  int32 = 1,   ///< A four byte signed integer.
+  int64 = 2,   ///< An eight byte signed integer.
+  float32 = 3, ///< A four byte float.
+  float64 = 4, ///< An eight byte double.
+  boolean = 5, ///< One byte which is zero for false.
+  string = 6   ///< A u16 length followed by that many bytes.
+};
+
+/**
+ * The version written in the header block of a binary log.
+ */
+constexpr std::uint8_t binaryLogVersion = 1;
+
+/**
+ * Logs written in plain text keep the format ID of this format for their message.
+ */
+constexpr std::uint16_t binaryLogTextFormat = 0;
+
+/**
+ * Fills in the `{}` placeholders of a log format with arguments, in order. Arguments without a
+ * placeholder are appended to the end.
+ *
+ * @param iformat The format.
+ * @param iargs The arguments, already converted to text.
+ * @return The formatted message.
+ */
+std::string formatLogMessage(std::string_view iformat, const std::vector<std::string> &iargs);
+
+/**
+ * Converts an argument of a binary log record to the text the decoder prints for it.
+ *
+ * @param iarg The argument.
+ * @return The text of the argument.
+ */
+template <typename T> std::string logArgToString(const T &iarg) {
+  if constexpr (std::is_same_v<T, bool>) {
+    return iarg ? "true" : "false";
+  } else if constexpr (std::is_arithmetic_v<T>) {
+    return std::to_string(iarg);
+  } else {
+    return std::string(std::string_view(iarg));
+  }
+}
+
+class BinaryLogWriter {
+  public:
+  /**
+   * Writes blocks of a binary log into a fixed buffer, so encoding a record does not allocate.
+   * Writes which would not fit are skipped, see `isValid()`.
+   *
+   * @param odata The buffer to write into.
+   * @param icapacity The size of the buffer in bytes.
+   */
+  BinaryLogWriter(std::uint8_t *odata, std::size_t icapacity) noexcept;
+
+  void putU8(std::uint8_t ivalue) noexcept;
+  void putU16(std::uint16_t ivalue) noexcept;
+  void putU32(std::uint32_t ivalue) noexcept;
+  void putU64(std::uint64_t ivalue) noexcept;
+  void putBytes(const void *idata, std::size_t isize) noexcept;
+
+  /**
+   * Writes one argument of a record with its type tag. Integers are widened to 32 or 64 bits,
+   * floats and doubles keep their size, and anything convertible to a `std::string_view` is written
+   * as a string.
+   *
+   * @param iarg The argument.
+   * @return False if the argument did not fit, in which case nothing was written.
+   */
+  template <typename T> bool putArg(const T &iarg) noexcept {
+    const std::size_t start = length;
+
+    if constexpr (std::is_same_v<T, bool>) {
+      putU8(static_cast<std::uint8_t>(BinaryLogArg::boolean));
+      putU8(iarg ? 1 : 0);
+    } else if constexpr (std::is_integral_v<T> &&
+                         (sizeof(T) < 4 || (sizeof(T) == 4 && std::is_signed_v<T>))) {
+      putU8(static_cast<std::uint8_t>(BinaryLogArg::int32));
+      putU32(static_cast<std::uint32_t>(static_cast<std::int32_t>(iarg)));
+    } else if constexpr (std::is_integral_v<T>) {
+      putU8(static_cast<std::uint8_t>(BinaryLogArg::int64));
+      putU64(static_cast<std::uint64_t>(static_cast<std::int64_t>(iarg)));
+    } else if constexpr (std::is_same_v<T, float>) {
+      putU8(static_cast<std::uint8_t>(BinaryLogArg::float32));
+      putFloat(iarg);
+    } else if constexpr (std::is_floating_point_v<T>) {
+      putU8(static_cast<std::uint8_t>(BinaryLogArg::float64));
+      putDouble(static_cast<double>(iarg));
+    } else {
+      // Strings are cut short to fit instead of being left out
+      const std::string_view text(iarg);
+      const std::size_t room = capacity - std::min(length + 3, capacity);
+      const auto size =
+        static_cast<std::uint16_t>(std::min({text.size(), room, std::size_t(0xffff)}));
+      putU8(static_cast<std::uint8_t>(BinaryLogArg::string));
+      putU16(size);
+      putBytes(text.data(), size);
+    }
+
+    if (!valid) {
+      // Take back the part of the argument which did fit
+      length = start;
+      valid = true;
+      return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * @return The number of bytes written.
+   */
+  std::size_t size() const noexcept;
+
+  /**
+   * @return False if a write did not fit since the last call.
+   */
+  bool isValid() const noexcept;
+
+  protected:
+  std::uint8_t *data;
+  std::size_t capacity;
+  std::size_t length{0};
+  bool valid{true};
+
+  void putFloat(float ivalue) noexcept;
+  void putDouble(double ivalue) noexcept;
+};
+
+class BinaryLogDecoder {
+  public:
+  /**
+   * Turns a binary log written by a `Logger` with `Logger::Encoding::binary` back into the lines
+   * a text logger would have written, with the time in ms to the microsecond.
+   */
+  BinaryLogDecoder();
+
+  /**
+   * Decodes a whole log.
+   *
+   * @param iin The binary log to read.
+   * @param iout Where to write the text.
+   * @return False if the log is damaged. Everything up to the damage is decoded.
+   */
+  bool decode(FILE *iin, FILE *iout);
+
+  protected:
+  std::unordered_map<std::uint16_t, std::string> formats{};
+  std::unordered_map<std::uint8_t, std::string> threads{};
+
+  // The time of the last record and how often the 32 bit time has wrapped around
+  std::uint32_t lastTime{0};
+  std::uint64_t wraps{0};
+
+  /**
+   * Decodes one block.
+   *
+   * @param iin The binary log to read.
+   * @param iout Where to write the text.
+   * @param itag The tag of the block, which was already read.
+   * @return False if the block is damaged.
+   */
+  bool decodeBlock(FILE *iin, FILE *iout, std::uint8_t itag);
+
+  /**
+   * Reads an argument of a record.
+   *
+   * @param iin The binary log to read.
+   * @param oarg The text of the argument.
+   * @return False if the argument is damaged.
+   */
+  static bool readArg(FILE *iin, std::string &oarg);
+
+  static bool readBytes(FILE *iin, void *odata, std::size_t isize);
+  static bool readU8(FILE *iin, std::uint8_t &ovalue);
+  static bool readU16(FILE *iin, std::uint16_t &ovalue);
+  static bool readU32(FILE *iin, std::uint32_t &ovalue);
+  static bool readU64(FILE *iin, std::uint64_t &ovalue);
+  static bool readString(FILE *iin, std::size_t ilength, std::string &ovalue);
+};
+} // namespace okapi
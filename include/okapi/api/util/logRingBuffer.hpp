@@ -0,0 +1,97 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace okapi {
+/**
+ * One log statement waiting to be written by the task which writes the log file. A binary logger
+ * only uses `message` and `length`.
+ */
+struct LogRecord {
+  long time;         // When the statement was logged in ms
+  const char *level; // The name of the level, which must be a string literal
+  char thread[32];   // The name of the task which logged the statement
+  char message[224]; // The message, cut short if it does not fit
+
+  // The number of bytes of a binary log block held in message instead of text, or 0 for text
+  std::uint16_t length;
+};
+
+class LogRingBuffer {
+  public:
+  /**
+   * A bounded queue of log records which any number of tasks can add to without locking, while one
+   * task takes them out. Records are filled in place, so adding one does not allocate. Check
+   * `getCapacity()` after constructing a buffer, it is zero if the records could not be allocated.
+   *
+   * @param icapacity The number of records the buffer holds, rounded up to a power of two.
+   */
+  explicit LogRingBuffer(std::size_t icapacity) noexcept;
+
+  /**
+   * Claims the next free record and fills it. A record only becomes visible to `tryPop()` once it
+   * has been filled, so a task which is preempted while filling its record holds up the reader but
+   * never any other writer.
+   *
+   * @param ifill A function which fills in the `LogRecord &` it is given.
+   * @return False if the buffer is full, in which case `ifill` is not called.
+   */
+  template <typename F> bool tryPush(F &&ifill) noexcept {
+    std::size_t pos = enqueuePos.load(std::memory_order_relaxed);
+
+    while (true) {
+      Cell &cell = cells[pos & mask];
+      const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+
+      if (diff == 0) {
+        // The cell is free for this position, so try to claim it
+        if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          ifill(cell.record);
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        // The reader has not taken the record from the last time around yet
+        return false;
+      } else {
+        // Another writer claimed this position first
+        pos = enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Takes the oldest record out of the buffer. Must only be called by one task.
+   *
+   * @param orecord The record to copy into.
+   * @return False if the buffer is empty.
+   */
+  bool tryPop(LogRecord &orecord) noexcept;
+
+  /**
+   * @return The number of records the buffer holds.
+   */
+  std::size_t getCapacity() const noexcept;
+
+  protected:
+  struct Cell {
+    // The position this cell is free for, or one past the position of the record in it
+    std::atomic_size_t sequence;
+    LogRecord record;
+  };
+
+  std::unique_ptr<Cell[]> cells;
+  std::size_t mask{0};
+  std::atomic_size_t enqueuePos{0};
+  std::size_t dequeuePos{0}; // Only used by the reader
+};
+} // namespace okapi
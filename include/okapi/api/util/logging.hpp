@@ -7,19 +7,66 @@
 
 #include "okapi/api/coreProsAPI.hpp"
 #include "okapi/api/util/abstractTimer.hpp"
+#include "okapi/api/util/binaryLog.hpp"
+#include "okapi/api/util/logRingBuffer.hpp"
 #include "okapi/api/util/mathUtil.hpp"
+#include <atomic>
 #include <memory>
 #include <mutex>
+#include <tuple>
+#include <vector>
 
 #if defined(THREADS_STD)
 #else
 #include "okapi/impl/util/timer.hpp"
 #endif
 
+/**
+ * The most verbose log level compiled in, as the value of a Logger::LogLevel. Log statements above
+ * it compile to nothing, so they cost neither code size nor a level check at run time, whatever
+ * level the logger is constructed with. Defaults to debug, which compiles in every statement.
+ * Define it to 2 (warn) or lower for competition builds. It must be the same for the whole build.
+ */
+#ifndef OKAPI_COMPILED_LOG_LEVEL
+#define OKAPI_COMPILED_LOG_LEVEL 4
+#endif
+
+// A compiled out statement still names its arguments inside sizeof, which does not evaluate them,
+// so variables which are only logged do not become unused
+#define OKAPI_DISCARD_LOG(msg) static_cast<void>(sizeof(msg))
+#define OKAPI_DISCARD_RECORD(...) static_cast<void>(sizeof(std::make_tuple(__VA_ARGS__)))
+
+#if OKAPI_COMPILED_LOG_LEVEL >= 4
 #define LOG_DEBUG(msg) logger->debug([=]() { return msg; })
+#define LOG_DEBUG_RECORD(...) logger->debugRecord(__VA_ARGS__)
+#else
+#define LOG_DEBUG(msg) OKAPI_DISCARD_LOG(msg)
+#define LOG_DEBUG_RECORD(...) OKAPI_DISCARD_RECORD(__VA_ARGS__)
+#endif
+
+#if OKAPI_COMPILED_LOG_LEVEL >= 3
 #define LOG_INFO(msg) logger->info([=]() { return msg; })
+#define LOG_INFO_RECORD(...) logger->infoRecord(__VA_ARGS__)
+#else
+#define LOG_INFO(msg) OKAPI_DISCARD_LOG(msg)
+#define LOG_INFO_RECORD(...) OKAPI_DISCARD_RECORD(__VA_ARGS__)
+#endif
+
+#if OKAPI_COMPILED_LOG_LEVEL >= 2
 #define LOG_WARN(msg) logger->warn([=]() { return msg; })
+#define LOG_WARN_RECORD(...) logger->warnRecord(__VA_ARGS__)
+#else
+#define LOG_WARN(msg) OKAPI_DISCARD_LOG(msg)
+#define LOG_WARN_RECORD(...) OKAPI_DISCARD_RECORD(__VA_ARGS__)
+#endif
+
+#if OKAPI_COMPILED_LOG_LEVEL >= 1
 #define LOG_ERROR(msg) logger->error([=]() { return msg; })
+#define LOG_ERROR_RECORD(...) logger->errorRecord(__VA_ARGS__)
+#else
+#define LOG_ERROR(msg) OKAPI_DISCARD_LOG(msg)
+#define LOG_ERROR_RECORD(...) OKAPI_DISCARD_RECORD(__VA_ARGS__)
+#endif
 
 #define LOG_DEBUG_S(msg) LOG_DEBUG(std::string(msg))
 #define LOG_INFO_S(msg) LOG_INFO(std::string(msg))
@@ -37,6 +84,27 @@ class Logger {
     off = 0    ///< off
   };
 
+  /**
+   * What an asynchronous logger does with a log statement when its buffer is full.
+   */
+  enum class Overflow {
+    drop, ///< Drop the statement and report how many were dropped once there is room.
+    block ///< Wait for the writer task to make room.
+  };
+
+  /**
+   * How log statements are written to the file.
+   */
+  enum class Encoding {
+    text,  ///< Lines of text, formatted by the task which logs them.
+    binary ///< Binary records, formatted later on a computer by `BinaryLogDecoder`.
+  };
+
+  struct AsyncOptions {
+    std::size_t capacity{64};          // How many log statements can wait to be written
+    Overflow overflow{Overflow::drop}; // What to do with a log statement when the buffer is full
+  };
+
   /**
    * A logger that does nothing.
    */
@@ -50,10 +118,12 @@ class Logger {
    * @param itimer A timer used to get the current time for log statements.
    * @param ifileName The name of the log file to open.
    * @param ilevel The log level. Log statements more verbose than this level will be disabled.
+   * @param iencoding How to write log statements.
    */
   Logger(std::unique_ptr<AbstractTimer> itimer,
          std::string_view ifileName,
-         const LogLevel &ilevel) noexcept;
+         const LogLevel &ilevel,
+         Encoding iencoding = Encoding::text) noexcept;
 
   /**
    * A logger that uses an existing file handle. The file will be closed when the logger is
@@ -62,81 +132,146 @@ class Logger {
    * @param itimer A timer used to get the current time for log statements.
    * @param ifile The log file to open. Will be closed by the logger!
    * @param ilevel The log level. Log statements more verbose than this level will be disabled.
+   * @param iencoding How to write log statements.
    */
-  Logger(std::unique_ptr<AbstractTimer> itimer, FILE *ifile, const LogLevel &ilevel) noexcept;
+  Logger(std::unique_ptr<AbstractTimer> itimer,
+         FILE *ifile,
+         const LogLevel &ilevel,
+         Encoding iencoding = Encoding::text) noexcept;
+
+  /**
+   * An asynchronous logger that opens the input file by name, like the synchronous constructor.
+   * Log statements are copied into a buffer instead of being written by the task which logged
+   * them, and a low priority task writes them to the file. This keeps file and serial writes out of
+   * control loops. Messages longer than a `LogRecord` holds are cut short. If the buffer can't be
+   * allocated, the logger writes synchronously instead.
+   *
+   * @param itimer A timer used to get the current time for log statements.
+   * @param ifileName The name of the log file to open.
+   * @param ilevel The log level. Log statements more verbose than this level will be disabled.
+   * @param iasync The size of the buffer and what to do when it is full.
+   * @param iencoding How to write log statements.
+   */
+  Logger(std::unique_ptr<AbstractTimer> itimer,
+         std::string_view ifileName,
+         const LogLevel &ilevel,
+         const AsyncOptions &iasync,
+         Encoding iencoding = Encoding::text) noexcept;
+
+  /**
+   * An asynchronous logger that uses an existing file handle. See the other asynchronous
+   * constructor for details. The file will be closed when the logger is destructed.
+   *
+   * @param itimer A timer used to get the current time for log statements.
+   * @param ifile The log file to open. Will be closed by the logger!
+   * @param ilevel The log level. Log statements more verbose than this level will be disabled.
+   * @param iasync The size of the buffer and what to do when it is full.
+   * @param iencoding How to write log statements.
+   */
+  Logger(std::unique_ptr<AbstractTimer> itimer,
+         FILE *ifile,
+         const LogLevel &ilevel,
+         const AsyncOptions &iasync,
+         Encoding iencoding = Encoding::text) noexcept;
 
   ~Logger();
 
+  /**
+   * @return Whether log statements are written by a separate task.
+   */
+  bool isAsync() const noexcept;
+
   constexpr bool isDebugLevelEnabled() const noexcept {
-    return toUnderlyingType(logLevel) >= toUnderlyingType(LogLevel::debug);
+    return OKAPI_COMPILED_LOG_LEVEL >= toUnderlyingType(LogLevel::debug) &&
+           toUnderlyingType(logLevel) >= toUnderlyingType(LogLevel::debug);
   }
 
   template <typename T> void debug(T ilazyMessage) noexcept {
     if (isDebugLevelEnabled() && logfile && timer) {
-      std::scoped_lock lock(logfileMutex);
-      fprintf(logfile,
-              "%ld (%s) DEBUG: %s\n",
-              static_cast<long>(timer->millis().convert(millisecond)),
-              CrossplatformThread::getName().c_str(),
-              ilazyMessage().c_str());
+      log(LogLevel::debug, "DEBUG", ilazyMessage);
+    }
+  }
+
+  template <typename... Args>
+  void debugRecord(const std::uint16_t iformat, const Args &... iargs) noexcept {
+    if (isDebugLevelEnabled() && logfile && timer) {
+      record(LogLevel::debug, "DEBUG", iformat, iargs...);
     }
   }
 
   constexpr bool isInfoLevelEnabled() const noexcept {
-    return toUnderlyingType(logLevel) >= toUnderlyingType(LogLevel::info);
+    return OKAPI_COMPILED_LOG_LEVEL >= toUnderlyingType(LogLevel::info) &&
+           toUnderlyingType(logLevel) >= toUnderlyingType(LogLevel::info);
   }
 
   template <typename T> void info(T ilazyMessage) noexcept {
     if (isInfoLevelEnabled() && logfile && timer) {
-      std::scoped_lock lock(logfileMutex);
-      fprintf(logfile,
-              "%ld (%s) INFO: %s\n",
-              static_cast<long>(timer->millis().convert(millisecond)),
-              CrossplatformThread::getName().c_str(),
-              ilazyMessage().c_str());
+      log(LogLevel::info, "INFO", ilazyMessage);
+    }
+  }
+
+  template <typename... Args>
+  void infoRecord(const std::uint16_t iformat, const Args &... iargs) noexcept {
+    if (isInfoLevelEnabled() && logfile && timer) {
+      record(LogLevel::info, "INFO", iformat, iargs...);
     }
   }
 
   constexpr bool isWarnLevelEnabled() const noexcept {
-    return toUnderlyingType(logLevel) >= toUnderlyingType(LogLevel::warn);
+    return OKAPI_COMPILED_LOG_LEVEL >= toUnderlyingType(LogLevel::warn) &&
+           toUnderlyingType(logLevel) >= toUnderlyingType(LogLevel::warn);
   }
 
   template <typename T> void warn(T ilazyMessage) noexcept {
     if (isWarnLevelEnabled() && logfile && timer) {
-      std::scoped_lock lock(logfileMutex);
-      fprintf(logfile,
-              "%ld (%s) WARN: %s\n",
-              static_cast<long>(timer->millis().convert(millisecond)),
-              CrossplatformThread::getName().c_str(),
-              ilazyMessage().c_str());
+      log(LogLevel::warn, "WARN", ilazyMessage);
+    }
+  }
+
+  template <typename... Args>
+  void warnRecord(const std::uint16_t iformat, const Args &... iargs) noexcept {
+    if (isWarnLevelEnabled() && logfile && timer) {
+      record(LogLevel::warn, "WARN", iformat, iargs...);
     }
   }
 
   constexpr bool isErrorLevelEnabled() const noexcept {
-    return toUnderlyingType(logLevel) >= toUnderlyingType(LogLevel::error);
+    return OKAPI_COMPILED_LOG_LEVEL >= toUnderlyingType(LogLevel::error) &&
+           toUnderlyingType(logLevel) >= toUnderlyingType(LogLevel::error);
   }
 
   template <typename T> void error(T ilazyMessage) noexcept {
     if (isErrorLevelEnabled() && logfile && timer) {
-      std::scoped_lock lock(logfileMutex);
-      fprintf(logfile,
-              "%ld (%s) ERROR: %s\n",
-              static_cast<long>(timer->millis().convert(millisecond)),
-              CrossplatformThread::getName().c_str(),
-              ilazyMessage().c_str());
+      log(LogLevel::error, "ERROR", ilazyMessage);
     }
   }
 
-  /**
-   * Closes the connection to the log file.
-   */
-  constexpr void close() noexcept {
-    if (logfile) {
-      fclose(logfile);
-      logfile = nullptr;
+  template <typename... Args>
+  void errorRecord(const std::uint16_t iformat, const Args &... iargs) noexcept {
+    if (isErrorLevelEnabled() && logfile && timer) {
+      record(LogLevel::error, "ERROR", iformat, iargs...);
     }
   }
 
+  /**
+   * Registers the format of a structured log record. A record is logged with a format ID and its
+   * numeric (or string) arguments instead of a message, for example
+   * `LOG_DEBUG_RECORD(errorFormat, error)`. Each `{}` in the format is replaced by the next
+   * argument. A binary logger writes the arguments as they are and leaves the formatting to
+   * `BinaryLogDecoder`, so logging a record does no string formatting. A text logger formats the
+   * record right away. Register formats once, not before every record.
+   *
+   * @param iformat The format.
+   * @return The ID to log records with.
+   */
+  std::uint16_t registerFormat(std::string_view iformat) noexcept;
+
+  /**
+   * Closes the connection to the log file. An asynchronous logger writes every log statement in
+   * its buffer first.
+   */
+  void close() noexcept;
+
   /**
    * @return The default logger.
    */
@@ -156,6 +291,146 @@ class Logger {
   FILE *logfile;
   CrossplatformMutex logfileMutex;
 
+  // Only set for an asynchronous logger
+  std::unique_ptr<LogRingBuffer> buffer{nullptr};
+  Overflow overflow{Overflow::drop};
+  std::atomic_size_t droppedCount{0};
+  std::atomic_bool writerStop{false};
+  std::atomic_bool writerDone{false};
+  CrossplatformThread *writer{nullptr};
+
+  Encoding encoding{Encoding::text};
+
+  // The registered formats indexed by ID. internMutex must be locked when accessing these, and
+  // when adding a task to threadNames.
+  CrossplatformMutex internMutex;
+  std::vector<std::string> formats{"{}"};
+
+  // The ID of each task which has logged a binary record, newest first. A node never changes once
+  // it is published, so tasks which already have an ID find it without locking.
+  struct ThreadName {
+    std::string name;
+    std::uint8_t id;
+    std::unique_ptr<const ThreadName> next;
+  };
+  std::unique_ptr<const ThreadName> threadNameList{nullptr};
+  std::atomic<const ThreadName *> threadNames{nullptr};
+
+  template <typename T>
+  void log(const LogLevel ilevel, const char *ilevelName, T &ilazyMessage) noexcept {
+    if (encoding == Encoding::binary) {
+      writeRecord(ilevel, binaryLogTextFormat, ilazyMessage());
+      return;
+    }
+
+    const long time = static_cast<long>(timer->millis().convert(millisecond));
+    const char *const thread = CrossplatformThread::getCurrentName();
+
+    if (buffer) {
+      enqueue(ilevelName, time, thread, ilazyMessage());
+    } else {
+      // Build the message before locking so other tasks only wait for the write
+      const std::string message = ilazyMessage();
+      std::scoped_lock lock(logfileMutex);
+      fprintf(logfile, "%ld (%s) %s: %s\n", time, thread, ilevelName, message.c_str());
+    }
+  }
+
+  template <typename... Args>
+  void record(const LogLevel ilevel,
+              const char *ilevelName,
+              const std::uint16_t iformat,
+              const Args &... iargs) noexcept {
+    if (encoding == Encoding::binary) {
+      writeRecord(ilevel, iformat, iargs...);
+      return;
+    }
+
+    // Nothing will decode the record later, so format it now
+    auto message = [&]() {
+      return formatLogMessage(getFormat(iformat), {logArgToString(iargs)...});
+    };
+    log(ilevel, ilevelName, message);
+  }
+
+  template <typename... Args>
+  void
+  writeRecord(const LogLevel ilevel, const std::uint16_t iformat, const Args &... iargs) noexcept {
+    std::uint8_t data[sizeof(LogRecord::message)];
+    BinaryLogWriter block(data, sizeof(data));
+    block.putU8(static_cast<std::uint8_t>(BinaryLogBlock::record));
+    block.putU8(static_cast<std::uint8_t>(toUnderlyingType(ilevel)));
+    block.putU32(getMicros());
+    block.putU16(iformat);
+    block.putU8(getThreadId());
+    const std::size_t countIndex = block.size();
+    block.putU8(0);
+
+    // Leave out an argument which does not fit and every argument after it, so no argument ends up
+    // in the wrong placeholder
+    std::uint8_t count = 0;
+    bool fits = true;
+    ((fits = fits && block.putArg(iargs), count += fits ? 1 : 0), ...);
+    data[countIndex] = count;
+
+    writeBlock(data, block.size(), false);
+  }
+
+  /**
+   * Copies a log statement into the buffer, dropping it or waiting for room if the buffer is full.
+   *
+   * @param ilevel The name of the level.
+   * @param itime When the statement was logged in ms.
+   * @param ithread The name of the task which logged the statement.
+   * @param imessage The message.
+   */
+  void enqueue(const char *ilevel,
+               long itime,
+               std::string_view ithread,
+               std::string_view imessage) noexcept;
+
+  /**
+   * Writes a block of a binary log, through the buffer if the logger is asynchronous.
+   *
+   * @param idata The block.
+   * @param isize The size of the block in bytes, at most the size of `LogRecord::message`.
+   * @param iblock Whether to wait for room in the buffer even if the logger drops statements.
+   * Blocks which later records depend on must not be dropped.
+   */
+  void writeBlock(const std::uint8_t *idata, std::size_t isize, bool iblock) noexcept;
+
+  /**
+   * Writes the header block which starts a binary log. Does nothing for a text logger.
+   */
+  void writeHeader() noexcept;
+
+  /**
+   * @param iformat The ID of a registered format.
+   * @return The format, or an empty string if there is no format with that ID.
+   */
+  std::string getFormat(std::uint16_t iformat) noexcept;
+
+  /**
+   * Finds the ID of the calling task in binary records, writing its name to the log the first
+   * time the task logs. Only that first time locks or allocates.
+   *
+   * @return The ID of the calling task.
+   */
+  std::uint8_t getThreadId() noexcept;
+
+  /**
+   * @return The current time in microseconds, wrapping around every 71 minutes.
+   */
+  std::uint32_t getMicros() const noexcept;
+
+  /**
+   * Stops the writer task once it has written everything in the buffer.
+   */
+  void stopWriter() noexcept;
+
+  static void writerTrampoline(void *context);
+  void writerLoop() noexcept;
+
   static bool isSerialStream(std::string_view filename);
 };
 
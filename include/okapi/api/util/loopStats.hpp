@@ -0,0 +1,123 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include "okapi/api/units/QTime.hpp"
+#include "okapi/api/util/abstractRate.hpp"
+#include "okapi/api/util/abstractTimer.hpp"
+#include "okapi/api/util/logging.hpp"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace okapi {
+class LoopStats {
+  public:
+  /**
+   * The number of buckets in the histogram of iteration durations. Each bucket is one millisecond
+   * wide, except the last one, which also holds every longer iteration.
+   */
+  static constexpr std::size_t histogramSize = 16;
+
+  struct Summary {
+    std::size_t iterations{0}; // The number of iterations recorded
+    std::size_t overruns{0};   // The number of iterations which took at least their whole period
+    QTime meanDuration{0_ms};  // The mean time spent running an iteration, not counting the delay
+    QTime maxDuration{0_ms};   // The longest time spent running an iteration
+    QTime meanJitter{0_ms};    // The mean difference between the actual and the requested period
+    QTime maxJitter{0_ms};     // The largest difference between the actual and requested period
+
+    // The number of iterations by their duration in ms
+    std::array<std::size_t, histogramSize> histogram{};
+  };
+
+  /**
+   * Measures a control loop: how long each iteration takes, how far the time between iterations
+   * strays from the period the loop asked for, and how often an iteration overran that period.
+   * Nothing is measured until `setEnabled(true)` is called. Only the task running the loop writes
+   * the statistics, without locking, so any task can read them while the loop runs.
+   *
+   * @param iname The name of the loop, used when logging the statistics.
+   * @param itimer The timer to measure the loop with. If it is `nullptr` the loop can't be
+   * measured and `setEnabled()` does nothing.
+   */
+  LoopStats(std::string iname, std::unique_ptr<AbstractTimer> itimer);
+
+  LoopStats(const LoopStats &) = delete;
+  LoopStats &operator=(const LoopStats &) = delete;
+
+  /**
+   * Turns measuring on or off. The statistics are kept while measuring is off.
+   *
+   * @param ienabled Whether to measure the loop.
+   */
+  void setEnabled(bool ienabled) noexcept;
+
+  /**
+   * @return Whether the loop is being measured.
+   */
+  bool isEnabled() const noexcept;
+
+  /**
+   * Ends an iteration of the loop by calling `irate.delayUntil(iperiod)`, measuring the iteration
+   * and the delay if measuring is on. Must only be called by the task running the loop.
+   *
+   * @param irate The rate the loop delays with.
+   * @param iperiod The period of the loop.
+   */
+  void delayUntil(AbstractRate &irate, QTime iperiod);
+
+  /**
+   * Reads the statistics. The loop keeps running while they are read, so the numbers can be one
+   * iteration apart from each other.
+   *
+   * @return The statistics since the last reset.
+   */
+  Summary getSummary() const noexcept;
+
+  /**
+   * Clears the statistics. An iteration which is being recorded at the same time may be lost.
+   */
+  void reset() noexcept;
+
+  /**
+   * Logs the statistics at the info level.
+   *
+   * @param logger The logger to log to.
+   */
+  void log(const std::shared_ptr<Logger> &logger) const;
+
+  protected:
+  const std::string name;
+  const std::unique_ptr<AbstractTimer> timer;
+  std::atomic_bool enabled{false};
+
+  // Written only by the loop task. Times are in microseconds.
+  std::atomic_size_t iterations{0};
+  std::atomic_size_t overruns{0};
+  std::atomic<std::uint64_t> totalDuration{0};
+  std::atomic<std::uint32_t> maxDuration{0};
+  std::atomic<std::uint64_t> totalJitter{0};
+  std::atomic<std::uint32_t> maxJitter{0};
+  std::array<std::atomic_size_t, histogramSize> histogram{};
+
+  // Only used by the loop task
+  QTime lastWake{0_ms};
+  bool hasLastWake{false};
+
+  /**
+   * Records one iteration.
+   *
+   * @param iduration The time spent running the iteration.
+   * @param iperiod The period the loop asked for.
+   * @param iactualPeriod The time between the start of the iteration and the start of the next.
+   */
+  void record(QTime iduration, QTime iperiod, QTime iactualPeriod) noexcept;
+
+  static std::uint32_t toMicros(QTime itime) noexcept;
+};
+} // namespace okapi
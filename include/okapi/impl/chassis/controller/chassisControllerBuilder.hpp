@@ -311,6 +311,19 @@ class ChassisControllerBuilder {
     std::unique_ptr<Filter> iturnFilter = std::make_unique<PassthroughFilter>(),
     std::unique_ptr<Filter> iangleFilter = std::make_unique<PassthroughFilter>());
 
+  /**
+   * Makes the ChassisControllerPID turn along a time-optimal profile with these limits. See
+   * `ChassisControllerPID::setTurnProfile()`. Has no effect unless gains were also passed.
+   *
+   * @param imaxVel The maximum angular velocity of the robot.
+   * @param imaxAccel The maximum angular acceleration of the robot.
+   * @param imaxJerk The maximum angular jerk of the robot, or zero for no limit.
+   * @return An ongoing builder.
+   */
+  ChassisControllerBuilder &withTurnProfile(QAngularSpeed imaxVel,
+                                            QAngularAcceleration imaxAccel,
+                                            QAngularJerk imaxJerk = QAngularJerk(0.0));
+
   /**
    * Sets the chassis dimensions.
    *
@@ -470,6 +483,10 @@ class ChassisControllerBuilder {
   std::unique_ptr<Filter> angleFilter = std::make_unique<PassthroughFilter>();
   IterativePosPIDController::Gains turnGains;
   std::unique_ptr<Filter> turnFilter = std::make_unique<PassthroughFilter>();
+  bool hasTurnProfile{false};
+  QAngularSpeed turnMaxVel;
+  QAngularAcceleration turnMaxAccel;
+  QAngularJerk turnMaxJerk;
   TimeUtilFactory chassisControllerTimeUtilFactory = TimeUtilFactory();
   TimeUtilFactory closedLoopControllerTimeUtilFactory = TimeUtilFactory();
   TimeUtilFactory odometryTimeUtilFactory = TimeUtilFactory();
@@ -6,6 +6,7 @@
 #pragma once
 
 #include "okapi/api/chassis/controller/chassisController.hpp"
+#include "okapi/api/control/async/asyncHolonomicMotionProfileController.hpp"
 #include "okapi/api/control/async/asyncLinearMotionProfileController.hpp"
 #include "okapi/api/control/async/asyncMotionProfileController.hpp"
 #include "okapi/api/util/logging.hpp"
@@ -63,7 +64,8 @@ class AsyncMotionProfileControllerBuilder {
              const AbstractMotor::GearsetRatioPair &ipair);
 
   /**
-   * Sets the output. This must be used with buildMotionProfileController().
+   * Sets the output. This must be used with buildMotionProfileController() or
+   * buildHolonomicMotionProfileController().
    *
    * @param icontroller The chassis controller to use.
    * @return An ongoing builder.
@@ -71,7 +73,8 @@ class AsyncMotionProfileControllerBuilder {
   AsyncMotionProfileControllerBuilder &withOutput(ChassisController &icontroller);
 
   /**
-   * Sets the output. This must be used with buildMotionProfileController().
+   * Sets the output. This must be used with buildMotionProfileController() or
+   * buildHolonomicMotionProfileController().
    *
    * @param icontroller The chassis controller to use.
    * @return An ongoing builder.
@@ -80,7 +83,8 @@ class AsyncMotionProfileControllerBuilder {
   withOutput(const std::shared_ptr<ChassisController> &icontroller);
 
   /**
-   * Sets the output. This must be used with buildMotionProfileController().
+   * Sets the output. This must be used with buildMotionProfileController() or
+   * buildHolonomicMotionProfileController().
    *
    * @param imodel The chassis model to use.
    * @param iscales The chassis dimensions.
@@ -99,6 +103,26 @@ class AsyncMotionProfileControllerBuilder {
    */
   AsyncMotionProfileControllerBuilder &withLimits(const PathfinderLimits &ilimits);
 
+  /**
+   * Sets the limits of the heading in rad/s, rad/s/s, and rad/s/s/s. This must be used with
+   * buildHolonomicMotionProfileController().
+   *
+   * @param iturnLimits The limits of the heading.
+   * @return An ongoing builder.
+   */
+  AsyncMotionProfileControllerBuilder &withTurnLimits(const PathfinderLimits &iturnLimits);
+
+  /**
+   * Follows paths with feedforward and encoder feedback. This only applies to
+   * `buildMotionProfileController()`. See `AsyncMotionProfileController::setFollowerGains()`.
+   *
+   * @param igains The follower gains.
+   * @param iperiod How often to update the wheel voltages.
+   * @return An ongoing builder.
+   */
+  AsyncMotionProfileControllerBuilder &withFollowerGains(const TrajectoryFollower::Gains &igains,
+                                                         QTime iperiod = 5_ms);
+
   /**
    * Sets the TimeUtilFactory used when building the controller. The default is the static
    * TimeUtilFactory.
@@ -155,12 +179,27 @@ class AsyncMotionProfileControllerBuilder {
    */
   std::shared_ptr<AsyncMotionProfileController> buildMotionProfileController();
 
+  /**
+   * Builds the AsyncHolonomicMotionProfileController. The output must be an `XDriveModel` (or a
+   * subclass of it, like `ThreeEncoderXDriveModel`).
+   *
+   * @return A fully built AsyncHolonomicMotionProfileController.
+   */
+  std::shared_ptr<AsyncHolonomicMotionProfileController> buildHolonomicMotionProfileController();
+
   private:
   std::shared_ptr<Logger> logger;
 
   bool hasLimits{false};
   PathfinderLimits limits;
 
+  bool hasTurnLimits{false};
+  PathfinderLimits turnLimits;
+
+  bool hasFollowerGains{false};
+  TrajectoryFollower::Gains followerGains;
+  QTime followerPeriod{5_ms};
+
   bool hasOutput{false};
   std::shared_ptr<ControllerOutput<double>> output;
   QLength diameter;
@@ -13,6 +13,14 @@ CAPI void pf_fit_hermite_pre(Waypoint a, Waypoint b, Spline *s);
 CAPI void pf_fit_hermite_cubic(Waypoint a, Waypoint b, Spline *s);
 CAPI void pf_fit_hermite_quintic(Waypoint a, Waypoint b, Spline *s);
 
+// Quintic Hermite spline with the given signed curvature at each end
+CAPI void pf_fit_hermite_quintic_curvature(Waypoint a, Waypoint b, double a_curvature, double b_curvature, Spline *s);
+
+// Fits `path_length - 1` quintic splines whose curvature matches at every waypoint, so the
+// wheel velocities of a tank drive do not jump at waypoints. Pass NULL as the fit function when
+// preparing splines fitted this way.
+CAPI void pf_fit_hermite_curvature_continuous(Waypoint *path, int path_length, Spline *splines);
+
 #define FIT_HERMITE_CUBIC   &pf_fit_hermite_cubic
 #define FIT_HERMITE_QUINTIC &pf_fit_hermite_quintic
 
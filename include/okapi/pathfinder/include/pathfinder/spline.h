@@ -12,8 +12,26 @@ CAPI Coord pf_spline_coords(Spline s, double percentage);
 CAPI double pf_spline_deriv(Spline s, double percentage);
 CAPI double pf_spline_deriv_2(double a, double b, double c, double d, double e, double k, double p);
 CAPI double pf_spline_angle(Spline s, double percentage);
+CAPI double pf_spline_deriv_second(Spline s, double percentage);
+// Signed curvature in 1/units, positive when the spline turns counterclockwise
+CAPI double pf_spline_curvature(Spline s, double percentage);
 
 CAPI double pf_spline_distance(Spline *s, int sample_count);
 CAPI double pf_spline_progress_for_distance(Spline s, double distance, int sample_count);
 
+// Cumulative arc length lookup. `table` must hold `sample_count + 1` doubles. Looking up progress in
+// a table is a binary search instead of a walk over every sample.
+CAPI void pf_spline_distance_table(Spline s, int sample_count, double *table);
+CAPI double pf_spline_progress_for_distance_table(Spline s, double distance, int sample_count, const double *table);
+
+// Arc length by adaptive Gauss-Kronrod quadrature instead of a fixed number of samples. `tolerance`
+// is the largest acceptable error in the length, in the units of the spline.
+CAPI double pf_spline_distance_gauss(Spline *s, double tolerance);
+CAPI double pf_spline_progress_for_distance_gauss(Spline s, double distance, double tolerance);
+// Starts the search at a known point, `*from` percent and `*from_distance` along the spline, and
+// moves the known point to the result. Walking along a spline this way only integrates each part
+// of it once.
+CAPI double pf_spline_progress_for_distance_gauss_from(Spline s, double distance, double tolerance,
+        double *from, double *from_distance);
+
 #endif
\ No newline at end of file
@@ -23,6 +23,7 @@ CAPI typedef struct {
 CAPI typedef struct {
     double dt, max_v, max_a, max_j, src_v, src_theta, dest_pos, dest_v, dest_theta;
     int sample_count;
+    double tolerance; // Use Gauss-Kronrod arc lengths with this tolerance if positive
 } TrajectoryConfig;
 
 CAPI typedef struct {
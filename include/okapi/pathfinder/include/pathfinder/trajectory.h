@@ -13,12 +13,51 @@ CAPI int pathfinder_prepare(Waypoint *path, int path_length, void (*fit)(Waypoin
         double max_velocity, double max_acceleration, double max_jerk, TrajectoryCandidate *cand);
 CAPI int pathfinder_generate(TrajectoryCandidate *c, Segment *segments);
 
+// Variants which use caller-provided memory instead of allocating. `splines` and `spline_lengths`
+// must hold `path_length - 1` elements and stay alive until generation is done. `buffer` must hold
+// `c->length` doubles. `fit` may be NULL if `splines` already holds the fitted splines.
+CAPI int pathfinder_prepare_into(Waypoint *path, int path_length, void (*fit)(Waypoint,Waypoint,Spline*), int sample_count, double dt,
+        double max_velocity, double max_acceleration, double max_jerk, TrajectoryCandidate *cand,
+        Spline *splines, double *spline_lengths);
+CAPI int pathfinder_generate_into(TrajectoryCandidate *c, Segment *segments, double *buffer);
+
+// Same as pathfinder_prepare_into, but measures splines with adaptive Gauss-Kronrod quadrature to
+// within `tolerance` instead of a fixed number of samples. Any of the generate functions can
+// generate the candidate, and they will use the same quadrature to place segments on the splines.
+CAPI int pathfinder_prepare_gauss_into(Waypoint *path, int path_length, void (*fit)(Waypoint,Waypoint,Spline*), double tolerance, double dt,
+        double max_velocity, double max_acceleration, double max_jerk, TrajectoryCandidate *cand,
+        Spline *splines, double *spline_lengths);
+
+// Same as pathfinder_prepare_gauss_into, but the splines are already fitted. Splines whose entry in
+// `spline_lengths` is positive keep that length instead of being measured again, so splines kept
+// from an earlier path cost nothing to prepare. Other entries must be zero.
+CAPI int pathfinder_prepare_fitted_into(Waypoint *path, int path_length, double tolerance, double dt,
+        double max_velocity, double max_acceleration, double max_jerk, TrajectoryCandidate *cand,
+        Spline *splines, double *spline_lengths);
+
+// Same as pathfinder_generate_into, but builds an arc length table for each spline once and looks
+// up every segment in it. `table` must hold `c->config.sample_count + 1` doubles. This gives the
+// same trajectory as the other generate functions in a fraction of the time.
+CAPI int pathfinder_generate_lut(TrajectoryCandidate *c, Segment *segments, double *buffer, double *table);
+
+// Fills in the x, y and heading of `length` segments from their positions along the splines of a
+// prepared candidate. The positions must not decrease. If `curvatures` is not NULL, it must hold
+// `length` doubles and is filled with the curvature of the path at each segment.
+CAPI void pathfinder_place_on_splines(TrajectoryCandidate *c, Segment *segments, int length, double *curvatures);
+
+// Same as pathfinder_place_on_splines, but looks segments up in an arc length table like
+// pathfinder_generate_lut. `table` must hold `c->config.sample_count + 1` doubles.
+CAPI void pathfinder_place_on_splines_lut(TrajectoryCandidate *c, Segment *segments, int length, double *curvatures, double *table);
+
 CAPI void pf_trajectory_copy(Segment *src, Segment *dest, int length);
 
 CAPI TrajectoryInfo pf_trajectory_prepare(TrajectoryConfig c);
 CAPI int pf_trajectory_create(TrajectoryInfo info, TrajectoryConfig c, Segment *seg);
 CAPI int pf_trajectory_fromSecondOrderFilter(int filter_1_l, int filter_2_l, 
         double dt, double u, double v, double impulse, int len, Segment *t);
+CAPI int pf_trajectory_create_into(TrajectoryInfo info, TrajectoryConfig c, Segment *seg, double *buffer);
+CAPI int pf_trajectory_fromSecondOrderFilter_into(int filter_1_l, int filter_2_l, 
+        double dt, double u, double v, double impulse, int len, Segment *t, double *f1_buffer);
 
 #ifdef __cplusplus
 }
@@ -4,6 +4,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 #include "okapi/api/chassis/controller/chassisControllerPid.hpp"
+#include "okapi/api/units/QSpeed.hpp"
 #include "okapi/api/util/mathUtil.hpp"
 #include <cmath>
 #include <utility>
@@ -51,6 +52,12 @@ void ChassisControllerPID::loop() {
   modeType pastMode = none;
   auto rate = timeUtil.getRate();
 
+  // The loop keeps its own copy of the turn profile so it doesn't need the lock every iteration
+  SCurveProfile profile{};
+  bool profiled = false;
+  QTime profileTime = 0_ms;
+  const double ticksPerRadian = (1_rad).convert(degree) * scales.turn * gearsetRatioPair.ratio;
+
   while (!dtorCalled.load(std::memory_order_acquire) && !task->notifyTake(0)) {
     /**
      * doneLooping is set to false by moveDistanceAsync and turnAngleAsync and then set to true by
@@ -62,6 +69,11 @@ void ChassisControllerPID::loop() {
       if (mode != pastMode || newMovement.load(std::memory_order_acquire)) {
         encStartVals = chassisModel->getSensorVals();
         newMovement.store(false, std::memory_order_release);
+
+        std::scoped_lock lock(turnProfileMutex);
+        profile = turnProfile;
+        profiled = turnProfiled;
+        profileTime = 0_ms;
       }
 
       switch (mode) {
@@ -85,12 +97,34 @@ void ChassisControllerPID::loop() {
         encVals = chassisModel->getSensorVals() - encStartVals;
         angleChange = (encVals[0] - encVals[1]) / 2.0;
 
-        turnPid->step(angleChange);
-
-        if (velocityMode) {
-          chassisModel->driveVector(0, turnPid->getOutput());
+        if (profiled) {
+          // Track where the profile is now and drive at its velocity, with the turn controller
+          // correcting for any error
+          const double elapsed = profileTime.convert(second);
+          const auto setpoint = profile.sample(elapsed);
+          turnPid->setTarget(setpoint.position * ticksPerRadian);
+          turnPid->step(angleChange);
+
+          const double output = turnPid->getOutput() + turnFeedforward(setpoint.velocity);
+          if (velocityMode) {
+            chassisModel->driveVector(0, output);
+          } else {
+            chassisModel->driveVectorVoltage(0, output);
+          }
+
+          // Only finish once the target has reached the end of the profile
+          if (elapsed >= profile.getDuration()) {
+            turnProfileDone.store(true, std::memory_order_release);
+          }
+          profileTime += threadSleepTime;
         } else {
-          chassisModel->driveVectorVoltage(0, turnPid->getOutput());
+          turnPid->step(angleChange);
+
+          if (velocityMode) {
+            chassisModel->driveVector(0, turnPid->getOutput());
+          } else {
+            chassisModel->driveVectorVoltage(0, turnPid->getOutput());
+          }
         }
 
         break;
@@ -102,7 +136,7 @@ void ChassisControllerPID::loop() {
       pastMode = mode;
     }
 
-    rate->delayUntil(threadSleepTime);
+    loopStats.delayUntil(*rate, threadSleepTime);
   }
 
   stop();
@@ -167,7 +201,26 @@ void ChassisControllerPID::turnAngleAsync(const QAngle idegTarget) {
 
   LOG_INFO("ChassisControllerPID: turning " + std::to_string(newTarget) + " motor ticks");
 
-  turnPid->setTarget(newTarget);
+  {
+    std::scoped_lock lock(turnProfileMutex);
+    turnProfiled = turnMaxVel > 0;
+
+    if (turnProfiled) {
+      // The loop moves the target along the profile, starting from where the robot is now
+      turnProfile = SCurveProfile(idegTarget.convert(radian) * boolToSign(normalTurns),
+                                  turnMaxVel,
+                                  turnMaxAccel,
+                                  turnMaxJerk);
+      turnProfileDone.store(false, std::memory_order_release);
+      turnPid->setTarget(0);
+
+      LOG_INFO("ChassisControllerPID: turn profile takes " +
+               std::to_string(turnProfile.getDuration()) + " seconds");
+    } else {
+      turnProfileDone.store(true, std::memory_order_release);
+      turnPid->setTarget(newTarget);
+    }
+  }
 
   doneLooping.store(false, std::memory_order_release);
   newMovement.store(true, std::memory_order_release);
@@ -198,7 +251,7 @@ bool ChassisControllerPID::isSettled() {
     return distancePid->isSettled() && anglePid->isSettled();
 
   case angle:
-    return turnPid->isSettled();
+    return turnPid->isSettled() && turnProfileDone.load(std::memory_order_acquire);
 
   default:
     return true;
@@ -265,7 +318,7 @@ bool ChassisControllerPID::waitForAngleSettled() {
   LOG_INFO_S("ChassisControllerPID: Waiting to settle in angle mode");
 
   auto rate = timeUtil.getRate();
-  while (!turnPid->isSettled()) {
+  while (!(turnPid->isSettled() && turnProfileDone.load(std::memory_order_acquire))) {
     if (mode == distance) {
       // False will cause the loop to re-enter the switch
       LOG_WARN_S("ChassisControllerPID: Mode changed to distance while waiting in angle!");
@@ -286,6 +339,17 @@ void ChassisControllerPID::stopAfterSettled() {
   chassisModel->stop();
 }
 
+double ChassisControllerPID::turnFeedforward(const double ivelocity) const {
+  const QSpeed wheelSpeed = ivelocity * scales.wheelTrack / 2 / second;
+  const QAngularSpeed motorSpeed =
+    wheelSpeed * (360_deg / (scales.wheelDiameter * 1_pi)) * gearsetRatioPair.ratio;
+
+  // In voltage mode the output is roughly proportional to the speed the motors reach
+  const double maxSpeed = velocityMode ? chassisModel->getMaxVelocity()
+                                       : toUnderlyingType(gearsetRatioPair.internalGearset);
+  return motorSpeed.convert(rpm) / maxSpeed;
+}
+
 ChassisScales ChassisControllerPID::getChassisScales() const {
   return scales;
 }
@@ -298,6 +362,27 @@ void ChassisControllerPID::setVelocityMode(bool ivelocityMode) {
   velocityMode = ivelocityMode;
 }
 
+void ChassisControllerPID::setTurnProfile(const QAngularSpeed imaxVel,
+                                          const QAngularAcceleration imaxAccel,
+                                          const QAngularJerk imaxJerk) {
+  if (imaxVel.convert(radps) <= 0 || imaxAccel.getValue() <= 0 || imaxJerk.getValue() < 0) {
+    std::string msg("ChassisControllerPID: The turn profile's velocity and acceleration must be "
+                    "positive and its jerk must not be negative.");
+    LOG_ERROR(msg);
+    throw std::invalid_argument(msg);
+  }
+
+  std::scoped_lock lock(turnProfileMutex);
+  turnMaxVel = imaxVel.convert(radps);
+  turnMaxAccel = imaxAccel.getValue();
+  turnMaxJerk = imaxJerk.getValue();
+}
+
+void ChassisControllerPID::disableTurnProfile() {
+  std::scoped_lock lock(turnProfileMutex);
+  turnMaxVel = 0;
+}
+
 void ChassisControllerPID::setGains(const okapi::IterativePosPIDController::Gains &idistanceGains,
                                     const okapi::IterativePosPIDController::Gains &iturnGains,
                                     const okapi::IterativePosPIDController::Gains &iangleGains) {
@@ -323,6 +408,10 @@ CrossplatformThread *ChassisControllerPID::getThread() const {
   return task;
 }
 
+LoopStats &ChassisControllerPID::getLoopStats() {
+  return loopStats;
+}
+
 void ChassisControllerPID::stop() {
   LOG_INFO_S("ChassisControllerPID: Stopping");
 
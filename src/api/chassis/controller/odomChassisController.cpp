@@ -72,7 +72,7 @@ void OdomChassisController::loop() {
   auto rate = timeUtil.getRate();
   while (!dtorCalled.load(std::memory_order_acquire) && !odomTask->notifyTake(0)) {
     odom->step();
-    rate->delayUntil(10_ms);
+    loopStats.delayUntil(*rate, 10_ms);
   }
 
   odomTaskRunning = false;
@@ -86,4 +86,8 @@ CrossplatformThread *OdomChassisController::getOdomThread() const {
 std::shared_ptr<Odometry> OdomChassisController::getOdometry() {
   return odom;
 }
+
+LoopStats &OdomChassisController::getLoopStats() {
+  return loopStats;
+}
 } // namespace okapi
@@ -0,0 +1,488 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/async/asyncHolonomicMotionProfileController.hpp"
+#include "okapi/api/util/mathUtil.hpp"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <numeric>
+
+namespace okapi {
+AsyncHolonomicMotionProfileController::AsyncHolonomicMotionProfileController(
+  const TimeUtil &itimeUtil,
+  const PathfinderLimits &ilimits,
+  const PathfinderLimits &iturnLimits,
+  const std::shared_ptr<XDriveModel> &imodel,
+  const ChassisScales &iscales,
+  const AbstractMotor::GearsetRatioPair &ipair,
+  const std::shared_ptr<Logger> &ilogger)
+  : logger(ilogger),
+    limits(ilimits),
+    turnLimits(iturnLimits),
+    model(imodel),
+    scales(iscales),
+    pair(ipair),
+    timeUtil(itimeUtil) {
+  if (ipair.ratio == 0) {
+    std::string msg(
+      "AsyncHolonomicMotionProfileController: The gear ratio cannot be zero! Check if you are "
+      "using integer division.");
+    LOG_ERROR(msg);
+    throw std::invalid_argument(msg);
+  }
+}
+
+AsyncHolonomicMotionProfileController::~AsyncHolonomicMotionProfileController() {
+  dtorCalled.store(true, std::memory_order_release);
+
+  // Deleting a task on the brain does not wait for it, so it could be killed while holding
+  // currentPathMutex or driving the motors. Let it see dtorCalled and finish first.
+  if (task) {
+    auto rate = timeUtil.getRate();
+    while (!taskDone.load(std::memory_order_acquire)) {
+      rate->delayUntil(1_ms);
+    }
+    delete task;
+  }
+
+  std::scoped_lock lock(currentPathMutex);
+  paths.clear();
+}
+
+void AsyncHolonomicMotionProfileController::generatePath(
+  std::initializer_list<PathfinderPoint> iwaypoints,
+  const QAngle iheading,
+  const std::string &ipathId) {
+  generatePath(iwaypoints, iheading, ipathId, limits, turnLimits);
+}
+
+void AsyncHolonomicMotionProfileController::generatePath(
+  std::initializer_list<PathfinderPoint> iwaypoints,
+  const QAngle iheading,
+  const std::string &ipathId,
+  const PathfinderLimits &ilimits,
+  const PathfinderLimits &iturnLimits) {
+  if (iwaypoints.size() == 0) {
+    // No point in generating a path
+    LOG_WARN_S("AsyncHolonomicMotionProfileController: Not generating a path because no "
+               "waypoints were given.");
+    return;
+  }
+
+  std::vector<Waypoint> points;
+  points.reserve(iwaypoints.size());
+  for (auto &point : iwaypoints) {
+    points.push_back(
+      Waypoint{point.x.convert(meter), point.y.convert(meter), point.theta.convert(radian)});
+  }
+
+  std::unique_lock lock(scratchMutex);
+  auto path = std::make_shared<const HolonomicPath>(
+    generateHolonomicPath(points, iheading.convert(radian), ipathId, ilimits, iturnLimits));
+  lock.unlock();
+
+  // Free the old path before overwriting it
+  forceRemovePath(ipathId);
+
+  std::scoped_lock pathLock(currentPathMutex);
+  paths.insert_or_assign(ipathId, path);
+
+  LOG_INFO("AsyncHolonomicMotionProfileController: Completely done generating path " + ipathId);
+  LOG_DEBUG("AsyncHolonomicMotionProfileController: Path length: " +
+            std::to_string(path->length));
+}
+
+int AsyncHolonomicMotionProfileController::generateTrajectory(std::vector<Waypoint> &points,
+                                                               const std::string &ipathId,
+                                                               const PathfinderLimits &ilimits,
+                                                               const double idt) {
+  TrajectoryCandidate candidate{};
+  const int status = preparePathfinderCandidate(points, ilimits, idt, scratch, candidate);
+
+  if (status < 0) {
+    std::string message = "AsyncHolonomicMotionProfileController: Length was negative. " +
+                          getPathErrorMessage(points, ipathId, status);
+
+    LOG_ERROR(message);
+    throw std::runtime_error(message);
+  }
+
+  // The wheel limits are not used because each wheel's speed depends on the heading too
+  const int length = generatePathfinderTrajectory(candidate, ilimits, 0, scratch);
+
+  if (length < 0) {
+    std::string message = "AsyncHolonomicMotionProfileController: Could not generate trajectory. " +
+                          getPathErrorMessage(points, ipathId, length);
+
+    LOG_ERROR(message);
+    throw std::runtime_error(message);
+  }
+
+  return length;
+}
+
+AsyncHolonomicMotionProfileController::HolonomicPath
+AsyncHolonomicMotionProfileController::generateHolonomicPath(const std::vector<Waypoint> &points,
+                                                             const double iheading,
+                                                             const std::string &ipathId,
+                                                             const PathfinderLimits &ilimits,
+                                                             const PathfinderLimits &iturnLimits) {
+  LOG_INFO_S("AsyncHolonomicMotionProfileController: Generating path");
+
+  // A wheel can't be clamped on its own without changing the direction the robot drives in. So if
+  // a wheel would need more than its top speed, both profiles are slowed down by the same factor.
+  // That scales every wheel speed by the factor but keeps the path, the heading along it and how
+  // the two line up. Rounding to whole time steps can leave the fastest wheel a little too fast,
+  // so this is repeated a few times.
+  constexpr int maxRescales = 3;
+  constexpr double commandTolerance = 1e-3;
+
+  double peakCommand = 0;
+  HolonomicPath path =
+    combineProfiles(points, iheading, ipathId, ilimits, iturnLimits, peakCommand);
+
+  double scale = 1;
+  for (int i = 0; i < maxRescales && peakCommand > 1 + commandTolerance; ++i) {
+    scale /= peakCommand;
+    path = combineProfiles(points,
+                           iheading,
+                           ipathId,
+                           scaleLimits(ilimits, scale),
+                           scaleLimits(iturnLimits, scale),
+                           peakCommand);
+  }
+
+  if (peakCommand > 1 + commandTolerance) {
+    LOG_WARN("AsyncHolonomicMotionProfileController: Path " + ipathId +
+             " is faster than the motors can follow. Lower the limits or the turn limits.");
+  } else if (scale < 1) {
+    LOG_INFO("AsyncHolonomicMotionProfileController: Slowed path " + ipathId + " to " +
+             std::to_string(scale * 100) + "% of its limits so no wheel is faster than its motor");
+  }
+
+  return path;
+}
+
+AsyncHolonomicMotionProfileController::HolonomicPath
+AsyncHolonomicMotionProfileController::combineProfiles(std::vector<Waypoint> points,
+                                                       const double iheading,
+                                                       const std::string &ipathId,
+                                                       const PathfinderLimits &ilimits,
+                                                       const PathfinderLimits &iturnLimits,
+                                                       double &opeakCommand) {
+  constexpr double dt = 0.010;
+
+  // The scratch is reused for the heading, so keep the velocity and direction of the path
+  const int pathLength = generateTrajectory(points, ipathId, ilimits, dt);
+  std::vector<Segment> translation(scratch.segments(), scratch.segments() + pathLength);
+
+  // The heading is a straight 1D profile from zero to the final heading
+  int headingLength = 0;
+  std::vector<Segment> rotation;
+  if (std::abs(iheading) > 1e-9) {
+    std::vector<Waypoint> headingPoints{Waypoint{0, 0, 0}, Waypoint{std::abs(iheading), 0, 0}};
+    headingLength = generateTrajectory(headingPoints, ipathId, iturnLimits, dt);
+    rotation.assign(scratch.segments(), scratch.segments() + headingLength);
+  }
+
+  const double headingSign = iheading < 0 ? -1 : 1;
+  const double gearset = toUnderlyingType(pair.internalGearset);
+  const double halfTrack = scales.wheelTrack.convert(meter) / 2;
+
+  HolonomicPath path{std::max(pathLength, headingLength), dt, {}};
+  path.commands.resize(4 * static_cast<std::size_t>(path.length));
+  opeakCommand = 0;
+
+  for (int i = 0; i < path.length; ++i) {
+    // Whichever profile finishes first holds its final state until the other is done
+    const double speed = i < pathLength ? translation[i].velocity : 0;
+    const double direction = i < pathLength ? translation[i].heading : 0;
+    const double heading = i < headingLength ? headingSign * rotation[i].position : iheading;
+    const double angular = i < headingLength ? headingSign * rotation[i].velocity : 0;
+
+    // Move the velocity into the frame of the robot. Pathfinder has +y to the left and
+    // counterclockwise angles, xArcade() strafes and yaws to the right.
+    const double forward = speed * std::cos(direction - heading);
+    const double strafe = -speed * std::sin(direction - heading);
+    const double yaw = -angular * halfTrack;
+
+    const double wheels[] = {forward + strafe + yaw,
+                             forward - strafe - yaw,
+                             forward + strafe - yaw,
+                             forward - strafe + yaw};
+
+    for (std::size_t wheel = 0; wheel < 4; ++wheel) {
+      const double command =
+        convertLinearToRotational(wheels[wheel] * mps).convert(rpm) / gearset;
+      opeakCommand = std::max(opeakCommand, std::abs(command));
+      path.commands[4 * i + wheel] = static_cast<float>(command);
+    }
+  }
+
+  return path;
+}
+
+PathfinderLimits AsyncHolonomicMotionProfileController::scaleLimits(const PathfinderLimits &ilimits,
+                                                                    const double iscale) {
+  // Slowing a profile down in time by iscale scales each derivative by another power of iscale
+  PathfinderLimits scaled = ilimits;
+  scaled.maxVel *= iscale;
+  scaled.maxAccel *= iscale * iscale;
+  scaled.maxJerk *= iscale * iscale * iscale;
+  scaled.maxWheelVel *= iscale;
+  scaled.maxWheelAccel *= iscale * iscale;
+  scaled.startVel *= iscale;
+  scaled.endVel *= iscale;
+  return scaled;
+}
+
+std::string
+AsyncHolonomicMotionProfileController::getPathErrorMessage(const std::vector<Waypoint> &points,
+                                                           const std::string &ipathId,
+                                                           const int length) {
+  auto pointToString = [](Waypoint point) {
+    return "PathfinderPoint{x=" + std::to_string(point.x) + ", y=" + std::to_string(point.y) +
+           ", theta=" + std::to_string(point.angle) + "}";
+  };
+
+  return "The path (id " + ipathId + ", length " + std::to_string(length) +
+         ") is impossible with waypoints: " +
+         std::accumulate(std::next(points.begin()),
+                         points.end(),
+                         pointToString(points.at(0)),
+                         [&](std::string a, Waypoint b) { return a + ", " + pointToString(b); });
+}
+
+bool AsyncHolonomicMotionProfileController::removePath(const std::string &ipathId) {
+  std::scoped_lock lock(currentPathMutex);
+
+  auto oldPath = paths.find(ipathId);
+  if (oldPath == paths.end()) {
+    return true;
+  }
+
+  if (!isDisabled() && isRunning.load(std::memory_order_acquire) && currentPath == ipathId) {
+    LOG_WARN("AsyncHolonomicMotionProfileController: Attempted to remove currently running path " +
+             ipathId);
+    return false;
+  }
+
+  paths.erase(oldPath);
+
+  // A return value of true provides no feedback about whether the path was actually removed but
+  // instead tells us that the path does not exist at this moment
+  return true;
+}
+
+std::vector<std::string> AsyncHolonomicMotionProfileController::getPaths() {
+  std::scoped_lock lock(currentPathMutex);
+  std::vector<std::string> keys;
+
+  for (const auto &path : paths) {
+    keys.push_back(path.first);
+  }
+
+  return keys;
+}
+
+void AsyncHolonomicMotionProfileController::setTarget(std::string ipathId) {
+  setTarget(ipathId, false);
+}
+
+void AsyncHolonomicMotionProfileController::setTarget(std::string ipathId, const bool imirrored) {
+  LOG_INFO("AsyncHolonomicMotionProfileController: Set target to: " + ipathId +
+           " (imirrored=" + std::to_string(imirrored) + ")");
+
+  std::scoped_lock lock(currentPathMutex);
+  currentPath = ipathId;
+  mirrored.store(imirrored, std::memory_order_release);
+  isRunning.store(true, std::memory_order_release);
+}
+
+void AsyncHolonomicMotionProfileController::controllerSet(std::string ivalue) {
+  setTarget(ivalue);
+}
+
+std::string AsyncHolonomicMotionProfileController::getTarget() {
+  std::scoped_lock lock(currentPathMutex);
+  return currentPath;
+}
+
+std::string AsyncHolonomicMotionProfileController::getProcessValue() const {
+  std::scoped_lock lock(currentPathMutex);
+  return currentPath;
+}
+
+void AsyncHolonomicMotionProfileController::loop() {
+  LOG_INFO_S("Started AsyncHolonomicMotionProfileController task.");
+
+  auto rate = timeUtil.getRate();
+
+  while (!dtorCalled.load(std::memory_order_acquire) && !task->notifyTake(0)) {
+    if (isRunning.load(std::memory_order_acquire) && !isDisabled()) {
+      std::unique_lock lock(currentPathMutex);
+      const std::string pathId = currentPath;
+      const auto found = paths.find(pathId);
+      const auto path = found == paths.end() ? nullptr : found->second;
+      lock.unlock();
+
+      LOG_INFO("AsyncHolonomicMotionProfileController: Running with path: " + pathId);
+
+      if (path == nullptr) {
+        LOG_WARN(
+          "AsyncHolonomicMotionProfileController: Target was set to non-existent path with name: " +
+          pathId);
+      } else {
+        LOG_DEBUG("AsyncHolonomicMotionProfileController: Path length is " +
+                  std::to_string(path->length));
+
+        executeSinglePath(*path, timeUtil.getRate());
+
+        // Stop after the path because the heading might still be turning
+        model->stop();
+
+        LOG_INFO_S("AsyncHolonomicMotionProfileController: Done moving");
+      }
+
+      isRunning.store(false, std::memory_order_release);
+    }
+
+    loopStats.delayUntil(*rate, 10_ms);
+  }
+
+  LOG_INFO_S("Stopped AsyncHolonomicMotionProfileController task.");
+  taskDone.store(true, std::memory_order_release);
+}
+
+void AsyncHolonomicMotionProfileController::executeSinglePath(const HolonomicPath &path,
+                                                              std::unique_ptr<AbstractRate> rate) {
+  // Mirroring the path negates the strafe and the yaw, which swaps the wheels on each diagonal
+  const bool followMirrored = mirrored.load(std::memory_order_acquire);
+  const std::size_t topLeft = followMirrored ? 1 : 0;
+  const std::size_t topRight = followMirrored ? 0 : 1;
+  const std::size_t bottomRight = followMirrored ? 3 : 2;
+  const std::size_t bottomLeft = followMirrored ? 2 : 3;
+
+  const double maxVelocity = model->getMaxVelocity();
+  const auto move = [&](AbstractMotor &imotor, const double icommand) {
+    imotor.moveVelocity(static_cast<std::int16_t>(std::clamp(icommand, -1.0, 1.0) * maxVelocity));
+  };
+
+  const QTime segDT = path.dt * second;
+  const float *commands = path.commands.data();
+
+  for (int i = 0; i < path.length && !isDisabled() && !dtorCalled.load(std::memory_order_acquire);
+       ++i) {
+    const float *step = commands + 4 * i;
+    move(*model->getTopLeftMotor(), step[topLeft]);
+    move(*model->getTopRightMotor(), step[topRight]);
+    move(*model->getBottomRightMotor(), step[bottomRight]);
+    move(*model->getBottomLeftMotor(), step[bottomLeft]);
+
+    loopStats.delayUntil(*rate, segDT);
+  }
+}
+
+QAngularSpeed
+AsyncHolonomicMotionProfileController::convertLinearToRotational(QSpeed linear) const {
+  return (linear * (360_deg / (scales.wheelDiameter * 1_pi))) * pair.ratio;
+}
+
+void AsyncHolonomicMotionProfileController::trampoline(void *context) {
+  if (context) {
+    static_cast<AsyncHolonomicMotionProfileController *>(context)->loop();
+  }
+}
+
+void AsyncHolonomicMotionProfileController::waitUntilSettled() {
+  LOG_INFO_S("AsyncHolonomicMotionProfileController: Waiting to settle");
+
+  auto rate = timeUtil.getRate();
+  while (!isSettled()) {
+    rate->delayUntil(10_ms);
+  }
+
+  LOG_INFO_S("AsyncHolonomicMotionProfileController: Done waiting to settle");
+}
+
+void AsyncHolonomicMotionProfileController::moveTo(
+  std::initializer_list<PathfinderPoint> iwaypoints,
+  const QAngle iheading,
+  const bool imirrored) {
+  // Every call reuses one ID, which is removed again once the path has been driven
+  const std::string name = "__moveTo";
+  generatePath(iwaypoints, iheading, name);
+  setTarget(name, imirrored);
+  waitUntilSettled();
+  forceRemovePath(name);
+}
+
+PathfinderPoint AsyncHolonomicMotionProfileController::getError() const {
+  return PathfinderPoint{0_m, 0_m, 0_deg};
+}
+
+bool AsyncHolonomicMotionProfileController::isSettled() {
+  return isDisabled() || !isRunning.load(std::memory_order_acquire);
+}
+
+void AsyncHolonomicMotionProfileController::reset() {
+  // Interrupt executeSinglePath() by disabling the controller
+  flipDisable(true);
+
+  LOG_INFO_S("AsyncHolonomicMotionProfileController: Waiting to reset");
+
+  auto rate = timeUtil.getRate();
+  while (isRunning.load(std::memory_order_acquire)) {
+    rate->delayUntil(1_ms);
+  }
+
+  flipDisable(false);
+}
+
+void AsyncHolonomicMotionProfileController::flipDisable() {
+  flipDisable(!disabled.load(std::memory_order_acquire));
+}
+
+void AsyncHolonomicMotionProfileController::flipDisable(const bool iisDisabled) {
+  LOG_INFO("AsyncHolonomicMotionProfileController: flipDisable " + std::to_string(iisDisabled));
+  disabled.store(iisDisabled, std::memory_order_release);
+  // loop() will stop the chassis when executeSinglePath() is done
+  // the default implementation of executeSinglePath() breaks when disabled
+}
+
+bool AsyncHolonomicMotionProfileController::isDisabled() const {
+  return disabled.load(std::memory_order_acquire);
+}
+
+void AsyncHolonomicMotionProfileController::tarePosition() {
+}
+
+void AsyncHolonomicMotionProfileController::setMaxVelocity(std::int32_t) {
+}
+
+void AsyncHolonomicMotionProfileController::startThread() {
+  if (!task) {
+    task = new CrossplatformThread(trampoline, this, "AsyncHolonomicMPController");
+  }
+}
+
+CrossplatformThread *AsyncHolonomicMotionProfileController::getThread() const {
+  return task;
+}
+
+LoopStats &AsyncHolonomicMotionProfileController::getLoopStats() {
+  return loopStats;
+}
+
+void AsyncHolonomicMotionProfileController::forceRemovePath(const std::string &ipathId) {
+  if (!removePath(ipathId)) {
+    LOG_WARN("AsyncHolonomicMotionProfileController: Disabling controller to remove path " +
+             ipathId);
+    flipDisable(true);
+    removePath(ipathId);
+  }
+}
+} // namespace okapi
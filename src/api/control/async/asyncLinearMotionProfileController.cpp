@@ -5,6 +5,7 @@
  */
 #include "okapi/api/control/async/asyncLinearMotionProfileController.hpp"
 #include "okapi/api/util/mathUtil.hpp"
+#include <cstring>
 #include <mutex>
 #include <numeric>
 
@@ -62,34 +63,50 @@ void AsyncLinearMotionProfileController::generatePath(std::initializer_list<QLen
     points.push_back(Waypoint{point.convert(meter), 0, 0});
   }
 
-  LOG_INFO_S("AsyncLinearMotionProfileController: Preparing trajectory");
+  constexpr double dt = 0.010;
+  const auto key = TrajectoryCache::makeKey(points, ilimits, 0, dt, 1);
 
-  TrajectoryPtr candidate(new TrajectoryCandidate, [](TrajectoryCandidate *c) {
-    if (c->laptr) {
-      free(c->laptr);
-    }
+  if (auto cached = trajectoryCache.find(key)) {
+    const auto &header = cached->header;
+    // Guard against a hash collision or a stale file in the cache directory
+    if (header.sides == 1 && header.dt == dt && header.limits == ilimits) {
+      const int length = header.length;
+      SegmentPtr trajectory(static_cast<Segment *>(malloc(length * sizeof(Segment))), free);
+
+      if (trajectory != nullptr) {
+        LOG_INFO("AsyncLinearMotionProfileController: Using cached trajectory for path " +
+                 ipathId);
+        memcpy(trajectory.get(), cached->side(0), sizeof(Segment) * length);
 
-    if (c->saptr) {
-      free(c->saptr);
+        // Free the old path before overwriting it
+        forceRemovePath(ipathId);
+
+        paths.emplace(ipathId, TrajectoryPair{std::move(trajectory), length});
+        return;
+      }
     }
+  }
+
+  LOG_INFO_S("AsyncLinearMotionProfileController: Preparing trajectory");
+
+  TrajectoryCandidate candidate{};
+  const int status = preparePathfinderCandidate(points, ilimits, dt, scratch, candidate);
+
+  if (status < 0) {
+    std::string message = "AsyncLinearMotionProfileController: Length was negative. " +
+                          getPathErrorMessage(points, ipathId, status);
 
-    delete c;
-  });
+    LOG_ERROR(message);
+    throw std::runtime_error(message);
+  }
 
-  pathfinder_prepare(points.data(),
-                     static_cast<int>(points.size()),
-                     FIT_HERMITE_CUBIC,
-                     PATHFINDER_SAMPLES_FAST,
-                     0.010,
-                     ilimits.maxVel,
-                     ilimits.maxAccel,
-                     ilimits.maxJerk,
-                     candidate.get());
+  LOG_INFO_S("AsyncLinearMotionProfileController: Generating path");
 
-  const int length = candidate->length;
+  // There are no wheels to offset, so the wheel track is zero
+  const int length = generatePathfinderTrajectory(candidate, ilimits, 0, scratch);
 
   if (length < 0) {
-    std::string message = "AsyncLinearMotionProfileController: Length was negative. " +
+    std::string message = "AsyncLinearMotionProfileController: Could not generate trajectory. " +
                           getPathErrorMessage(points, ipathId, length);
 
     LOG_ERROR(message);
@@ -106,9 +123,15 @@ void AsyncLinearMotionProfileController::generatePath(std::initializer_list<QLen
     throw std::runtime_error(message);
   }
 
-  LOG_INFO_S("AsyncLinearMotionProfileController: Generating path");
+  memcpy(trajectory.get(), scratch.segments(), length * sizeof(Segment));
 
-  pathfinder_generate(candidate.get(), trajectory.get());
+  TrajectoryFileHeader header;
+  header.sides = 1;
+  header.length = length;
+  header.dt = dt;
+  header.limits = ilimits;
+  const Segment *sides[] = {trajectory.get()};
+  trajectoryCache.insert(key, header, sides);
 
   // Free the old path before overwriting it
   forceRemovePath(ipathId);
@@ -119,6 +142,10 @@ void AsyncLinearMotionProfileController::generatePath(std::initializer_list<QLen
   LOG_DEBUG("AsyncLinearMotionProfileController: Path length: " + std::to_string(length));
 }
 
+TrajectoryCache &AsyncLinearMotionProfileController::getTrajectoryCache() {
+  return trajectoryCache;
+}
+
 std::string
 AsyncLinearMotionProfileController::getPathErrorMessage(const std::vector<Waypoint> &points,
                                                         const std::string &ipathId,
@@ -218,9 +245,7 @@ void AsyncLinearMotionProfileController::loop() {
 
         executeSinglePath(path->second, timeUtil.getRate());
 
-        // Set 0 after the path because:
-        // 1. We only support an exit velocity of zero
-        // 2. Because of (1), we should make sure the system is stopped
+        // Stop after the path because it might not end at zero velocity
         output->controllerSet(0);
 
         LOG_INFO_S("AsyncLinearMotionProfileController: Done moving");
@@ -229,7 +254,7 @@ void AsyncLinearMotionProfileController::loop() {
       isRunning.store(false, std::memory_order_release);
     }
 
-    rate->delayUntil(10_ms);
+    loopStats.delayUntil(*rate, 10_ms);
   }
 
   LOG_INFO_S("Stopped AsyncLinearMotionProfileController task.");
@@ -255,7 +280,7 @@ void AsyncLinearMotionProfileController::executeSinglePath(const TrajectoryPair
     // Unlock before the delay to be nice to other tasks
     currentPathMutex.unlock();
 
-    rate->delayUntil(segDT);
+    loopStats.delayUntil(*rate, segDT);
   }
 }
 
@@ -350,7 +375,7 @@ bool AsyncLinearMotionProfileController::isDisabled() const {
 
 void AsyncLinearMotionProfileController::startThread() {
   if (!task) {
-    task = new CrossplatformThread(trampoline, this, "AsyncLinearMotionProfileController");
+    task = new CrossplatformThread(trampoline, this, "AsyncLinearMPController");
   }
 }
 
@@ -358,6 +383,10 @@ CrossplatformThread *AsyncLinearMotionProfileController::getThread() const {
   return task;
 }
 
+LoopStats &AsyncLinearMotionProfileController::getLoopStats() {
+  return loopStats;
+}
+
 void AsyncLinearMotionProfileController::tarePosition() {
 }
 
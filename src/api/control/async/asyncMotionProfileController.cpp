@@ -6,6 +6,8 @@
 #include "okapi/api/control/async/asyncMotionProfileController.hpp"
 #include "okapi/api/util/mathUtil.hpp"
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 #include <mutex>
 #include <numeric>
@@ -35,28 +37,275 @@ AsyncMotionProfileController::AsyncMotionProfileController(
 AsyncMotionProfileController::~AsyncMotionProfileController() {
   dtorCalled.store(true, std::memory_order_release);
 
-  // Free paths before deleting the task
-  std::scoped_lock lock(currentPathMutex);
-  paths.clear();
+  // Deleting a task on the brain does not wait for it, so it could be killed while holding a mutex
+  // or the scratch. Let both tasks see dtorCalled and finish what they are doing first.
+  auto rate = timeUtil.getRate();
+  if (generationTask) {
+    while (!generationDone.load(std::memory_order_acquire)) {
+      rate->delayUntil(1_ms);
+    }
+    delete generationTask;
+  }
+
+  if (task) {
+    while (!taskDone.load(std::memory_order_acquire)) {
+      rate->delayUntil(1_ms);
+    }
+    delete task;
+  }
 
-  delete task;
+  // Both tasks are gone, so nothing can be reading the table
+  retiredPathTables.clear();
+  delete pathTable.load();
 }
 
-void AsyncMotionProfileController::generatePath(std::initializer_list<PathfinderPoint> iwaypoints,
-                                                const std::string &ipathId) {
-  generatePath(iwaypoints, ipathId, limits);
+AsyncMotionProfileController::PathHandle
+AsyncMotionProfileController::generatePath(std::initializer_list<PathfinderPoint> iwaypoints,
+                                           const std::string &ipathId) {
+  return generatePath(iwaypoints, ipathId, limits);
 }
 
-void AsyncMotionProfileController::generatePath(std::initializer_list<PathfinderPoint> iwaypoints,
-                                                const std::string &ipathId,
-                                                const PathfinderLimits &ilimits) {
+AsyncMotionProfileController::PathHandle
+AsyncMotionProfileController::generatePath(std::initializer_list<PathfinderPoint> iwaypoints,
+                                           const std::string &ipathId,
+                                           const PathfinderLimits &ilimits) {
   if (iwaypoints.size() == 0) {
     // No point in generating a path
     LOG_WARN_S(
       "AsyncMotionProfileController: Not generating a path because no waypoints were given.");
-    return;
+    return getPathHandle(ipathId);
+  }
+
+  std::unique_lock lock(scratchMutex);
+  auto path = generateValidatedTrajectory(toWaypoints(iwaypoints), ipathId, ilimits, scratch);
+  lock.unlock();
+
+  const int length = path.length;
+  const PathHandle handle = insertPath(ipathId, std::move(path));
+
+  LOG_INFO("AsyncMotionProfileController: Completely done generating path " + ipathId);
+  LOG_DEBUG("AsyncMotionProfileController: Path length: " + std::to_string(length));
+
+  return handle;
+}
+
+std::vector<std::string>
+AsyncMotionProfileController::generatePaths(const std::vector<PathSpec> &ispecs) {
+  PathBatch batch{ispecs, std::vector<std::optional<TrajectoryPair>>(ispecs.size()),
+                  std::vector<std::string>(ispecs.size())};
+
+  LOG_INFO("AsyncMotionProfileController: Generating a batch of " +
+           std::to_string(ispecs.size()) + " paths");
+
+#ifdef THREADS_STD
+  // The calling task is one of the workers
+  const std::size_t workerCount =
+    std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1u), ispecs.size());
+  PathBatchWorker worker{this, &batch};
+  std::vector<std::unique_ptr<CrossplatformThread>> workers;
+  for (std::size_t i = 1; i < workerCount; ++i) {
+    workers.push_back(std::make_unique<CrossplatformThread>(
+      batchTrampoline, &worker, "AsyncMotionProfileController Batch"));
+  }
+
+  generateBatch(batch);
+
+  // Wait for the other workers to finish
+  workers.clear();
+#else
+  // User code only gets one core on the brain, so more tasks would not be any faster
+  generateBatch(batch);
+#endif
+
+  // The old paths are replaced in place in one snapshot. The controller only has to stop if it is
+  // following one of them, in which case it is disabled just like forceRemovePath() would.
+  std::size_t generated = 0;
+  {
+    std::scoped_lock lock(pathWriteMutex);
+    auto table = std::make_shared<PathTable>(*loadPathTable());
+
+    // A target which is waiting for its path to be generated is not running yet
+    const PathHandle target = getTargetHandle();
+    const bool running = !isDisabled() && isRunning.load(std::memory_order_acquire) &&
+                         findPath(*table, target) != nullptr;
+    bool replacesRunningPath = false;
+
+    for (std::size_t i = 0; i < ispecs.size(); ++i) {
+      if (batch.paths[i]) {
+        const PathHandle handle =
+          setPath(*table,
+                  ispecs[i].pathId,
+                  std::make_shared<const TrajectoryPair>(std::move(*batch.paths[i])));
+        replacesRunningPath |= running && handle == target;
+        ++generated;
+      }
+    }
+
+    if (replacesRunningPath) {
+      LOG_WARN_S("AsyncMotionProfileController: Disabling controller to replace the running path");
+      flipDisable(true);
+    }
+
+    storePathTable(std::move(table));
+  }
+
+  LOG_INFO("AsyncMotionProfileController: Generated " + std::to_string(generated) + " of " +
+           std::to_string(ispecs.size()) + " paths in the batch");
+
+  return std::move(batch.errors);
+}
+
+void AsyncMotionProfileController::batchTrampoline(void *context) {
+  if (context) {
+    auto worker = static_cast<PathBatchWorker *>(context);
+    worker->controller->generateBatch(*worker->batch);
+  }
+}
+
+void AsyncMotionProfileController::generateBatch(PathBatch &ibatch) {
+  // Each worker has its own scratch so workers never wait on each other
+  PathfinderScratch workerScratch;
+
+  for (std::size_t i = ibatch.next.fetch_add(1); i < ibatch.specs.size();
+       i = ibatch.next.fetch_add(1)) {
+    const PathSpec &spec = ibatch.specs[i];
+
+    if (spec.waypoints.empty()) {
+      ibatch.errors[i] = "No waypoints were given.";
+      LOG_WARN("AsyncMotionProfileController: Not generating path " + spec.pathId +
+               " because no waypoints were given.");
+      continue;
+    }
+
+    try {
+      ibatch.paths[i] = generateValidatedTrajectory(toWaypoints(spec.waypoints),
+                                                    spec.pathId,
+                                                    spec.limits.value_or(limits),
+                                                    workerScratch);
+      computeCommands(*ibatch.paths[i]);
+    } catch (const std::exception &e) {
+      // generateValidatedTrajectory() already logged the reason
+      ibatch.errors[i] = e.what();
+    }
+  }
+}
+
+AsyncMotionProfileController::PathHandle AsyncMotionProfileController::generatePathAsync(
+  std::initializer_list<PathfinderPoint> iwaypoints,
+  const std::string &ipathId) {
+  return generatePathAsync(iwaypoints, ipathId, limits);
+}
+
+AsyncMotionProfileController::PathHandle AsyncMotionProfileController::generatePathAsync(
+  std::initializer_list<PathfinderPoint> iwaypoints,
+  const std::string &ipathId,
+  const PathfinderLimits &ilimits) {
+  const PathHandle handle = getPathHandle(ipathId);
+
+  if (iwaypoints.size() == 0) {
+    // No point in generating a path
+    LOG_WARN_S(
+      "AsyncMotionProfileController: Not generating a path because no waypoints were given.");
+    return handle;
+  }
+
+  LOG_INFO("AsyncMotionProfileController: Queueing path " + ipathId + " for generation");
+
+  std::scoped_lock lock(generationMutex);
+  generationQueue.push_back(PathGenerationJob{toWaypoints(iwaypoints), ipathId, handle, ilimits});
+
+  if (!generationTask) {
+    generationTask =
+      new CrossplatformThread(generationTrampoline, this, "Motion Profile Generator");
   }
 
+  return handle;
+}
+
+bool AsyncMotionProfileController::isGeneratingPath(const std::string &ipathId) {
+  return isGeneratingPath(findPathHandle(ipathId));
+}
+
+bool AsyncMotionProfileController::isGeneratingPath(const PathHandle ipath) {
+  // generatingPath is invalid when nothing is being generated
+  if (!ipath.isValid()) {
+    return false;
+  }
+
+  std::scoped_lock lock(generationMutex);
+
+  if (generatingPath == ipath) {
+    return true;
+  }
+
+  return std::any_of(generationQueue.begin(),
+                     generationQueue.end(),
+                     [&](const PathGenerationJob &job) { return job.path == ipath; });
+}
+
+bool AsyncMotionProfileController::waitUntilPathGenerated(const std::string &ipathId) {
+  auto rate = timeUtil.getRate();
+  while (isGeneratingPath(ipathId)) {
+    rate->delayUntil(10_ms);
+  }
+
+  return findPath(ipathId) != nullptr;
+}
+
+void AsyncMotionProfileController::generationTrampoline(void *context) {
+  if (context) {
+    static_cast<AsyncMotionProfileController *>(context)->generationLoop();
+  }
+}
+
+void AsyncMotionProfileController::generationLoop() {
+  LOG_INFO_S("Started AsyncMotionProfileController generation task.");
+
+  auto rate = timeUtil.getRate();
+
+  // The generation task has its own scratch so it never waits on generatePath()
+  PathfinderScratch taskScratch;
+
+  while (!dtorCalled.load(std::memory_order_acquire)) {
+    generationMutex.lock();
+    if (generationQueue.empty()) {
+      generationMutex.unlock();
+      rate->delayUntil(10_ms);
+      continue;
+    }
+
+    PathGenerationJob job = std::move(generationQueue.front());
+    generationQueue.pop_front();
+    generatingPath = job.path;
+    generationMutex.unlock();
+
+    try {
+      auto path = generateValidatedTrajectory(job.points, job.pathId, job.limits, taskScratch);
+      const int length = path.length;
+      insertPath(job.pathId, std::move(path));
+
+      LOG_INFO("AsyncMotionProfileController: Completely done generating path " + job.pathId);
+      LOG_DEBUG("AsyncMotionProfileController: Path length: " + std::to_string(length));
+    } catch (const std::exception &) {
+      // generateValidatedTrajectory() already logged the reason
+      LOG_WARN("AsyncMotionProfileController: Failed to generate path " + job.pathId);
+    }
+
+    std::scoped_lock lock(generationMutex);
+    generatingPath = PathHandle();
+  }
+
+  LOG_INFO_S("Stopped AsyncMotionProfileController generation task.");
+  generationDone.store(true, std::memory_order_release);
+}
+
+std::vector<Waypoint>
+AsyncMotionProfileController::toWaypoints(std::initializer_list<PathfinderPoint> iwaypoints) {
+  return toWaypoints(std::vector<PathfinderPoint>(iwaypoints));
+}
+
+std::vector<Waypoint>
+AsyncMotionProfileController::toWaypoints(const std::vector<PathfinderPoint> &iwaypoints) {
   std::vector<Waypoint> points;
   points.reserve(iwaypoints.size());
   for (auto &point : iwaypoints) {
@@ -64,43 +313,96 @@ void AsyncMotionProfileController::generatePath(std::initializer_list<Pathfinder
       Waypoint{point.x.convert(meter), point.y.convert(meter), point.theta.convert(radian)});
   }
 
-  LOG_INFO_S("AsyncMotionProfileController: Preparing trajectory");
+  return points;
+}
 
-  TrajectoryPtr candidate(new TrajectoryCandidate, [](TrajectoryCandidate *c) {
-    if (c->laptr) {
-      free(c->laptr);
-    }
+AsyncMotionProfileController::TrajectoryPair
+AsyncMotionProfileController::allocateTrajectoryPair(const int ilength,
+                                                     const PathfinderLimits &ilimits) {
+  // Both sides share one allocation, see TrajectoryPair
+  return TrajectoryPair{
+    SegmentPtr(static_cast<Segment *>(malloc(2 * std::max(ilength, 0) * sizeof(Segment))), free),
+    ilength,
+    ilimits};
+}
 
-    if (c->saptr) {
-      free(c->saptr);
+AsyncMotionProfileController::TrajectoryPair
+AsyncMotionProfileController::generateTrajectory(std::vector<Waypoint> points,
+                                                 const std::string &ipathId,
+                                                 const PathfinderLimits &ilimits,
+                                                 PathfinderScratch &iscratch) {
+  constexpr double dt = 0.010;
+  const double wheelTrack = scales.wheelTrack.convert(meter);
+  const auto key = TrajectoryCache::makeKey(points, ilimits, wheelTrack, dt, 2);
+
+  if (auto cached = trajectoryCache.find(key)) {
+    const auto &header = cached->header;
+    // Guard against a hash collision or a stale file in the cache directory
+    if (header.sides == 2 && header.dt == dt && header.wheelTrack == wheelTrack &&
+        header.limits == ilimits) {
+      auto path = allocateTrajectoryPair(header.length, ilimits);
+
+      if (path.segments != nullptr) {
+        LOG_INFO("AsyncMotionProfileController: Using cached trajectory for path " + ipathId);
+        // The cache stores the sides back to back too, so this copies both at once
+        memcpy(path.left(), cached->side(0), 2 * sizeof(Segment) * header.length);
+        path.waypoints = std::move(points);
+        return path;
+      }
     }
+  }
+
+  LOG_INFO_S("AsyncMotionProfileController: Preparing trajectory");
 
-    delete c;
-  });
+  TrajectoryCandidate candidate{};
+  const int status = preparePathfinderCandidate(points, ilimits, dt, iscratch, candidate);
+  auto path = generateTrajectory(points, ipathId, ilimits, status, candidate, iscratch);
 
-  pathfinder_prepare(points.data(),
-                     static_cast<int>(points.size()),
-                     FIT_HERMITE_CUBIC,
-                     PATHFINDER_SAMPLES_FAST,
-                     0.010,
-                     ilimits.maxVel,
-                     ilimits.maxAccel,
-                     ilimits.maxJerk,
-                     candidate.get());
+  TrajectoryFileHeader header;
+  header.sides = 2;
+  header.length = path.length;
+  header.dt = dt;
+  header.limits = ilimits;
+  header.wheelTrack = wheelTrack;
+  const Segment *sides[] = {path.left(), path.right()};
+  trajectoryCache.insert(key, header, sides);
+
+  return path;
+}
 
-  const int length = candidate->length;
+AsyncMotionProfileController::TrajectoryPair
+AsyncMotionProfileController::generateTrajectory(std::vector<Waypoint> &points,
+                                                 const std::string &ipathId,
+                                                 const PathfinderLimits &ilimits,
+                                                 const int istatus,
+                                                 TrajectoryCandidate &icandidate,
+                                                 PathfinderScratch &iscratch) {
+  const double wheelTrack = scales.wheelTrack.convert(meter);
+
+  if (istatus < 0) {
+    std::string message = "AsyncMotionProfileController: " + describePathProblem(points, ilimits) +
+                          " " + getPathErrorMessage(points, ipathId, istatus);
+
+    LOG_ERROR(message);
+    throw std::runtime_error(message);
+  }
+
+  LOG_INFO_S("AsyncMotionProfileController: Generating path");
+
+  // The center trajectory is only needed until it is split into left and right
+  const int length = generatePathfinderTrajectory(icandidate, ilimits, wheelTrack, iscratch);
 
   if (length < 0) {
-    std::string message = "AsyncMotionProfileController: Length was negative. " +
+    std::string message = "AsyncMotionProfileController: Could not generate trajectory. " +
                           getPathErrorMessage(points, ipathId, length);
 
     LOG_ERROR(message);
     throw std::runtime_error(message);
   }
 
-  SegmentPtr trajectory(static_cast<Segment *>(malloc(length * sizeof(Segment))), free);
+  auto path = allocateTrajectoryPair(length, ilimits);
 
-  if (trajectory == nullptr) {
+  if (path.segments == nullptr) {
     std::string message = "AsyncMotionProfileController: Could not allocate trajectory. " +
                           getPathErrorMessage(points, ipathId, length);
 
@@ -108,42 +410,378 @@ void AsyncMotionProfileController::generatePath(std::initializer_list<Pathfinder
     throw std::runtime_error(message);
   }
 
-  LOG_INFO_S("AsyncMotionProfileController: Generating path");
+  LOG_INFO_S("AsyncMotionProfileController: Modifying for tank drive");
+  pathfinder_modify_tank(iscratch.segments(), length, path.left(), path.right(), wheelTrack);
 
-  pathfinder_generate(candidate.get(), trajectory.get());
+  const int splineCount = icandidate.path_length - 1;
+  path.splines.assign(icandidate.saptr, icandidate.saptr + splineCount);
+  path.splineLengths.assign(icandidate.laptr, icandidate.laptr + splineCount);
+  path.waypoints = std::move(points);
 
-  SegmentPtr leftTrajectory((Segment *)malloc(sizeof(Segment) * length), free);
-  SegmentPtr rightTrajectory((Segment *)malloc(sizeof(Segment) * length), free);
+  return path;
+}
 
-  if (leftTrajectory == nullptr || rightTrajectory == nullptr) {
-    std::string message = "AsyncMotionProfileController: Could not allocate left and/or right "
-                          "trajectories. " +
-                          getPathErrorMessage(points, ipathId, length);
+AsyncMotionProfileController::TrajectoryPair
+AsyncMotionProfileController::generateValidatedTrajectory(std::vector<Waypoint> points,
+                                                          const std::string &ipathId,
+                                                          const PathfinderLimits &ilimits,
+                                                          PathfinderScratch &iscratch) {
+  auto path = generateTrajectory(std::move(points), ipathId, ilimits, iscratch);
+
+  const auto rescaled = applyPathValidation(path, ipathId, false);
+  if (!rescaled) {
+    return path;
+  }
+
+  path = generateTrajectory(std::move(path.waypoints), ipathId, *rescaled, iscratch);
+  applyPathValidation(path, ipathId, true);
+  return path;
+}
+
+std::optional<PathfinderLimits>
+AsyncMotionProfileController::applyPathValidation(const TrajectoryPair &ipath,
+                                                  const std::string &ipathId,
+                                                  const bool irescaled) const {
+  const PathReport report = validatePath(ipath);
+  const double gearset = toUnderlyingType(pair.internalGearset);
+
+  LOG_INFO("AsyncMotionProfileController: Path " + ipathId + " takes " +
+           std::to_string(report.duration.convert(second)) + " s, needs up to " +
+           std::to_string(report.maxWheelRpm) + " rpm and " +
+           std::to_string(report.maxWheelAccel) + " m/s/s from the wheels, and has " +
+           std::to_string(report.hotSpots.size()) + " hot spots");
+
+  if (report.feasible) {
+    return std::nullopt;
+  }
+
+  const auto validation = pathValidation.load(std::memory_order_acquire);
+  if (validation == PathValidation::warn) {
+    // computeCommands() warns when the path is saved
+    return std::nullopt;
+  }
+
+  // A path which is still too fast after rescaling can't be slowed down any further
+  if (validation == PathValidation::reject || irescaled) {
+    std::string message = "AsyncMotionProfileController: Path " + ipathId +
+                          " needs the motors to turn at " + std::to_string(report.maxWheelRpm) +
+                          " rpm but the gearset only reaches " + std::to_string(gearset) +
+                          " rpm. Lower the limits or set PathfinderLimits::maxWheelVel.";
 
     LOG_ERROR(message);
     throw std::runtime_error(message);
   }
 
-  LOG_INFO_S("AsyncMotionProfileController: Modifying for tank drive");
-  pathfinder_modify_tank(trajectory.get(),
-                         length,
-                         leftTrajectory.get(),
-                         rightTrajectory.get(),
-                         scales.wheelTrack.convert(meter));
+  // Leave some headroom so the fastest wheel does not land right on the top speed
+  const double topSpeed = 0.98 * gearset / convertLinearToRotational(1_mps).convert(rpm);
+  PathfinderLimits rescaled = ipath.limits;
+  rescaled.maxWheelVel =
+    rescaled.maxWheelVel > 0 ? std::min(rescaled.maxWheelVel, topSpeed) : topSpeed;
+
+  LOG_WARN("AsyncMotionProfileController: Path " + ipathId + " needs the motors to turn at " +
+           std::to_string(report.maxWheelRpm) + " rpm, generating it again with the wheels " +
+           "limited to " + std::to_string(rescaled.maxWheelVel) + " m/s");
+
+  return rescaled;
+}
+
+AsyncMotionProfileController::PathReport
+AsyncMotionProfileController::validatePath(const TrajectoryPair &ipath) const {
+  PathReport report;
+  const int length = ipath.length;
+  if (length <= 0) {
+    return report;
+  }
+
+  const double dt = ipath.isCompact() ? ipath.playback.getDt() : ipath.left()[0].dt;
+  const double rpmPerMps = convertLinearToRotational(1_mps).convert(rpm);
+
+  // A turn this tight has a radius of half the wheel track, so the inner wheel stops
+  const double hotSpotCurvature = 2 / scales.wheelTrack.convert(meter);
+
+  const auto velocity = [&](const int iside, const int istep) {
+    if (ipath.isCompact()) {
+      return ipath.playback.getVelocity(iside, istep);
+    }
+
+    return (iside == 0 ? ipath.left() : ipath.right())[istep].velocity;
+  };
+
+  // The tightest point so far of the hot spot the path is in
+  std::optional<HotSpot> hotSpot{};
+
+  for (int i = 0; i < length; ++i) {
+    for (int side = 0; side < 2; ++side) {
+      report.maxWheelRpm = std::max(report.maxWheelRpm, std::abs(velocity(side, i)) * rpmPerMps);
+      if (i > 0) {
+        report.maxWheelAccel =
+          std::max(report.maxWheelAccel, std::abs(velocity(side, i) - velocity(side, i - 1)) / dt);
+      }
+    }
+
+    // Compacted paths do not keep their poses
+    if (ipath.isCompact() || i == 0) {
+      continue;
+    }
+
+    const auto from = plannedPose(ipath, i - 1);
+    const auto to = plannedPose(ipath, i);
+    const double distance = std::hypot(to.x - from.x, to.y - from.y);
+    if (distance < 1e-6) {
+      // The curvature is too noisy to measure where the robot barely moves
+      continue;
+    }
+
+    const double curvature = std::remainder(to.heading - from.heading, 2 * pi) / distance;
+    report.maxCurvature = std::max(report.maxCurvature, std::abs(curvature));
+
+    if (std::abs(curvature) >= hotSpotCurvature) {
+      if (!hotSpot || std::abs(curvature) > std::abs(hotSpot->curvature)) {
+        hotSpot = HotSpot{i * dt * second,
+                          PathfinderPoint{to.x * meter, to.y * meter, to.heading * radian},
+                          curvature};
+      }
+    } else if (hotSpot) {
+      report.hotSpots.push_back(*hotSpot);
+      hotSpot.reset();
+    }
+  }
+
+  if (hotSpot) {
+    report.hotSpots.push_back(*hotSpot);
+  }
+
+  report.duration = length * dt * second;
+  report.feasible = report.maxWheelRpm <= toUnderlyingType(pair.internalGearset);
+  return report;
+}
+
+std::string AsyncMotionProfileController::describePathProblem(const std::vector<Waypoint> &points,
+                                                              const PathfinderLimits &ilimits) {
+  if (points.size() < 2) {
+    return "A path needs at least two waypoints.";
+  }
+
+  // Written so NaN limits fail too
+  if (!(ilimits.maxVel > 0) || !(ilimits.maxAccel > 0) || !(ilimits.maxJerk > 0)) {
+    return "The maximum velocity, acceleration, and jerk must be positive.";
+  }
+
+  return "Length was negative.";
+}
+
+std::shared_ptr<const AsyncMotionProfileController::PathTable>
+AsyncMotionProfileController::loadPathTable() const {
+  // Counting this reader first means a store which swaps the holder out afterwards sees it
+  pathTableReaders.fetch_add(1);
+  auto table = pathTable.load()->table;
+  pathTableReaders.fetch_sub(1);
+  return table;
+}
+
+void AsyncMotionProfileController::storePathTable(std::shared_ptr<const PathTable> itable) {
+  retiredPathTables.emplace_back(pathTable.exchange(new PathTableHolder{std::move(itable)}));
+
+  // A reader which comes in now loads the new holder, so the retired ones are only in use if a
+  // reader is counted. Otherwise they, and the paths nobody else is using, are freed here.
+  if (pathTableReaders.load() == 0) {
+    retiredPathTables.clear();
+  }
+}
+
+std::shared_ptr<const AsyncMotionProfileController::TrajectoryPair>
+AsyncMotionProfileController::findPath(const std::string &ipathId) const {
+  const auto table = loadPathTable();
+
+  const auto slot = table->slots.find(ipathId);
+  if (slot == table->slots.end()) {
+    return nullptr;
+  }
+
+  return table->paths[slot->second];
+}
+
+std::shared_ptr<const AsyncMotionProfileController::TrajectoryPair>
+AsyncMotionProfileController::findPath(const PathTable &itable, const PathHandle ipath) {
+  if (ipath.slot >= itable.paths.size()) {
+    return nullptr;
+  }
+
+  return itable.paths[ipath.slot];
+}
+
+AsyncMotionProfileController::PathHandle
+AsyncMotionProfileController::findPathHandle(const std::string &ipathId) const {
+  const auto table = loadPathTable();
+
+  const auto slot = table->slots.find(ipathId);
+  if (slot == table->slots.end()) {
+    return PathHandle();
+  }
+
+  return PathHandle(static_cast<std::uint32_t>(slot->second));
+}
+
+AsyncMotionProfileController::PathHandle
+AsyncMotionProfileController::getPathHandle(const std::string &ipathId) {
+  if (const PathHandle handle = findPathHandle(ipathId); handle.isValid()) {
+    return handle;
+  }
+
+  // Another task might have interned the ID since it was looked up, which setPath() handles
+  std::scoped_lock lock(pathWriteMutex);
+  auto table = std::make_shared<PathTable>(*loadPathTable());
+  const auto slot = table->slots.find(ipathId);
+  const PathHandle handle =
+    slot == table->slots.end()
+      ? setPath(*table, ipathId, nullptr)
+      : PathHandle(static_cast<std::uint32_t>(slot->second));
+  storePathTable(std::move(table));
+
+  return handle;
+}
+
+std::string AsyncMotionProfileController::getPathId(const PathHandle ipath) const {
+  const auto table = loadPathTable();
+  return ipath.slot < table->names.size() ? table->names[ipath.slot] : "";
+}
+
+AsyncMotionProfileController::PathHandle
+AsyncMotionProfileController::setPath(PathTable &itable,
+                                      const std::string &ipathId,
+                                      std::shared_ptr<const TrajectoryPair> ipath) {
+  const auto [slot, added] = itable.slots.try_emplace(ipathId, itable.names.size());
+  if (added) {
+    itable.names.push_back(ipathId);
+    itable.paths.emplace_back();
+  }
+
+  itable.paths[slot->second] = std::move(ipath);
+  return PathHandle(static_cast<std::uint32_t>(slot->second));
+}
+
+std::uint32_t AsyncMotionProfileController::packTarget(const Target &itarget) {
+  return (itarget.path.slot << 2) | (itarget.backwards ? 2u : 0u) | (itarget.mirrored ? 1u : 0u);
+}
+
+AsyncMotionProfileController::Target
+AsyncMotionProfileController::unpackTarget(const std::uint32_t ipacked) {
+  return Target{PathHandle(ipacked >> 2), (ipacked & 2u) != 0, (ipacked & 1u) != 0};
+}
+
+AsyncMotionProfileController::PathHandle
+AsyncMotionProfileController::insertPath(const std::string &ipathId, TrajectoryPair &&ipath) {
+  computeCommands(ipath);
+  auto path = std::make_shared<const TrajectoryPair>(std::move(ipath));
 
   // Free the old path before overwriting it
   forceRemovePath(ipathId);
 
-  paths.emplace(ipathId,
-                TrajectoryPair{std::move(leftTrajectory), std::move(rightTrajectory), length});
+  std::scoped_lock lock(pathWriteMutex);
+  auto table = std::make_shared<PathTable>(*loadPathTable());
+  const PathHandle handle = setPath(*table, ipathId, std::move(path));
+  storePathTable(std::move(table));
 
-  LOG_INFO("AsyncMotionProfileController: Completely done generating path " + ipathId);
-  LOG_DEBUG("AsyncMotionProfileController: Path length: " + std::to_string(length));
+  return handle;
+}
+
+bool AsyncMotionProfileController::compactPath(const std::string &ipathId,
+                                               const PlaybackTrajectory::encoding iencoding) {
+  std::scoped_lock lock(pathWriteMutex);
+
+  const auto path = findPath(ipathId);
+  if (path == nullptr) {
+    LOG_WARN("AsyncMotionProfileController: Controller was asked to compact non-existent path " +
+             ipathId);
+    return false;
+  }
+
+  if (path->isCompact()) {
+    return true;
+  }
+
+  // Paths in the table never change, so the compact copy replaces the path. A task which is
+  // following the old path keeps it until it is done.
+  const Segment *sides[] = {path->left(), path->right()};
+  auto compact = std::make_shared<TrajectoryPair>(
+    TrajectoryPair{SegmentPtr(nullptr, free),
+                   path->length,
+                   path->limits,
+                   PlaybackTrajectory(sides, 2, path->length, iencoding)});
+
+  // The commands are not copied because executeSinglePath() derives them from the velocities
+  const std::size_t size = sizeof(TrajectoryPair) + compact->playback.getSize();
+
+  auto table = std::make_shared<PathTable>(*loadPathTable());
+  setPath(*table, ipathId, std::move(compact));
+  storePathTable(std::move(table));
+  LOG_INFO("AsyncMotionProfileController: Compacted path " + ipathId + " to " +
+           std::to_string(size) + " bytes");
+
+  return true;
+}
+
+void AsyncMotionProfileController::setFollowerGains(const TrajectoryFollower::Gains &igains,
+                                                    const QTime iperiod) {
+  std::scoped_lock lock(currentPathMutex);
+  followerGains = igains;
+  followerPeriod = iperiod;
+}
+
+void AsyncMotionProfileController::clearFollowerGains() {
+  std::scoped_lock lock(currentPathMutex);
+  followerGains.reset();
+}
+
+void AsyncMotionProfileController::setRamseteFollower(const std::shared_ptr<Odometry> &iodometry,
+                                                      const RamseteFollower::Gains &igains) {
+  std::scoped_lock lock(currentPathMutex);
+  odometry = iodometry;
+  ramseteGains = igains;
+}
+
+void AsyncMotionProfileController::clearRamseteFollower() {
+  std::scoped_lock lock(currentPathMutex);
+  odometry = nullptr;
+}
+
+TrajectoryCache &AsyncMotionProfileController::getTrajectoryCache() {
+  return trajectoryCache;
+}
+
+void AsyncMotionProfileController::setPathValidation(const PathValidation ivalidation) {
+  pathValidation.store(ivalidation, std::memory_order_release);
+}
+
+AsyncMotionProfileController::PathReport
+AsyncMotionProfileController::previewPath(std::initializer_list<PathfinderPoint> iwaypoints) {
+  return previewPath(iwaypoints, limits);
+}
+
+AsyncMotionProfileController::PathReport
+AsyncMotionProfileController::previewPath(std::initializer_list<PathfinderPoint> iwaypoints,
+                                          const PathfinderLimits &ilimits) {
+  std::scoped_lock lock(scratchMutex);
+  return validatePath(generateTrajectory(toWaypoints(iwaypoints), "preview", ilimits, scratch));
+}
+
+std::optional<AsyncMotionProfileController::PathReport>
+AsyncMotionProfileController::getPathReport(const std::string &ipathId) const {
+  const auto path = findPath(ipathId);
+  if (path == nullptr) {
+    return std::nullopt;
+  }
+
+  return validatePath(*path);
 }
 
 std::string AsyncMotionProfileController::getPathErrorMessage(const std::vector<Waypoint> &points,
                                                               const std::string &ipathId,
                                                               int length) {
+  if (points.empty()) {
+    return "The path (id " + ipathId + ") has no waypoints.";
+  }
+
   auto pointToString = [](Waypoint point) {
     return "PathfinderPoint{x=" + std::to_string(point.x) + ", y=" + std::to_string(point.y) +
            ", theta=" + std::to_string(point.angle) + "}";
@@ -158,17 +796,24 @@ std::string AsyncMotionProfileController::getPathErrorMessage(const std::vector<
 }
 
 bool AsyncMotionProfileController::removePath(const std::string &ipathId) {
-  if (!isDisabled() && isRunning.load(std::memory_order_acquire) && getTarget() == ipathId) {
+  std::scoped_lock lock(pathWriteMutex);
+
+  if (findPath(ipathId) == nullptr) {
+    // A target which is waiting for its path to be generated is not running yet, so there is
+    // nothing to protect
+    return true;
+  }
+
+  if (!isDisabled() && isRunning.load(std::memory_order_acquire) &&
+      getTargetHandle() == findPathHandle(ipathId)) {
     LOG_WARN("AsyncMotionProfileController: Attempted to remove currently running path " + ipathId);
     return false;
   }
 
-  std::scoped_lock lock(currentPathMutex);
-
-  auto oldPath = paths.find(ipathId);
-  if (oldPath != paths.end()) {
-    paths.erase(ipathId);
-  }
+  // The slot stays interned so the ID gets the same slot if it is saved again
+  auto table = std::make_shared<PathTable>(*loadPathTable());
+  setPath(*table, ipathId, nullptr);
+  storePathTable(std::move(table));
 
   // A return value of true provides no feedback about whether the path was actually removed but
   // instead tells us that the path does not exist at this moment
@@ -176,12 +821,17 @@ bool AsyncMotionProfileController::removePath(const std::string &ipathId) {
 }
 
 std::vector<std::string> AsyncMotionProfileController::getPaths() {
+  const auto table = loadPathTable();
   std::vector<std::string> keys;
 
-  for (const auto &path : paths) {
-    keys.push_back(path.first);
+  for (std::size_t i = 0; i < table->paths.size(); ++i) {
+    if (table->paths[i]) {
+      keys.push_back(table->names[i]);
+    }
   }
 
+  // Keep the paths sorted by ID regardless of the order they were first saved in
+  std::sort(keys.begin(), keys.end());
   return keys;
 }
 
@@ -192,25 +842,58 @@ void AsyncMotionProfileController::setTarget(std::string ipathId) {
 void AsyncMotionProfileController::setTarget(std::string ipathId,
                                              const bool ibackwards,
                                              const bool imirrored) {
-  LOG_INFO("AsyncMotionProfileController: Set target to: " + ipathId + " (ibackwards=" +
-           std::to_string(ibackwards) + ", imirrored=" + std::to_string(imirrored) + ")");
+  setTarget(getPathHandle(ipathId), ibackwards, imirrored);
+}
+
+void AsyncMotionProfileController::setTarget(const PathHandle ipath,
+                                             const bool ibackwards,
+                                             const bool imirrored) {
+  LOG_INFO("AsyncMotionProfileController: Set target to: " + getPathId(ipath) +
+           " (ibackwards=" + std::to_string(ibackwards) +
+           ", imirrored=" + std::to_string(imirrored) + ")");
 
-  currentPath = ipathId;
-  direction.store(boolToSign(!ibackwards), std::memory_order_release);
-  mirrored.store(imirrored, std::memory_order_release);
+  target.store(packTarget(Target{ipath, ibackwards, imirrored}), std::memory_order_release);
   isRunning.store(true, std::memory_order_release);
 }
 
+void AsyncMotionProfileController::queueTarget(const std::string &ipathId,
+                                               const bool ibackwards,
+                                               const bool imirrored) {
+  queueTarget(getPathHandle(ipathId), ibackwards, imirrored);
+}
+
+void AsyncMotionProfileController::queueTarget(const PathHandle ipath,
+                                               const bool ibackwards,
+                                               const bool imirrored) {
+  // loop() checks the queue with this locked before it stops running, so a path queued here is
+  // never dropped
+  std::unique_lock lock(currentPathMutex);
+  if (!isRunning.load(std::memory_order_acquire)) {
+    lock.unlock();
+    setTarget(ipath, ibackwards, imirrored);
+    return;
+  }
+
+  LOG_INFO("AsyncMotionProfileController: Queued target: " + getPathId(ipath) +
+           " (ibackwards=" + std::to_string(ibackwards) +
+           ", imirrored=" + std::to_string(imirrored) + ")");
+  targetQueue.push_back(Target{ipath, ibackwards, imirrored});
+}
+
 void AsyncMotionProfileController::controllerSet(std::string ivalue) {
   setTarget(ivalue);
 }
 
 std::string AsyncMotionProfileController::getTarget() {
-  return currentPath;
+  return getPathId(getTargetHandle());
+}
+
+AsyncMotionProfileController::PathHandle AsyncMotionProfileController::getTargetHandle() const {
+  return unpackTarget(target.load(std::memory_order_acquire)).path;
 }
 
 std::string AsyncMotionProfileController::getProcessValue() const {
-  return currentPath;
+  return getPathId(getTargetHandle());
 }
 
 void AsyncMotionProfileController::loop() {
@@ -220,53 +903,174 @@ void AsyncMotionProfileController::loop() {
 
   while (!dtorCalled.load(std::memory_order_acquire) && !task->notifyTake(0)) {
     if (isRunning.load(std::memory_order_acquire) && !isDisabled()) {
-      LOG_INFO("AsyncMotionProfileController: Running with path: " + currentPath);
+      // Read the whole target at once so the path and how to follow it always match
+      const Target current = unpackTarget(target.load(std::memory_order_acquire));
+
+      if (isGeneratingPath(current.path)) {
+        // Wait for the generation task to finish the path before following it
+        loopStats.delayUntil(*rate, 10_ms);
+        continue;
+      }
+
+      direction.store(boolToSign(!current.backwards), std::memory_order_release);
+      mirrored.store(current.mirrored, std::memory_order_release);
+
+      // Holding the path keeps it alive even if it is removed or replaced while it is followed
+      const auto path = findPath(*loadPathTable(), current.path);
 
-      auto path = paths.find(currentPath);
-      if (path == paths.end()) {
+      LOG_INFO("AsyncMotionProfileController: Running with path: " + getPathId(current.path));
+
+      if (path == nullptr) {
         LOG_WARN("AsyncMotionProfileController: Target was set to non-existent path with name: " +
-                 currentPath);
+                 getPathId(current.path));
       } else {
         LOG_DEBUG("AsyncMotionProfileController: Path length is " +
-                  std::to_string(path->second.length));
+                  std::to_string(path->length));
+
+        std::unique_lock followingLock(currentPathMutex);
+        auto following = path;
+        followingPath = following;
+        replacementPath = nullptr;
+        hasReplacement.store(false, std::memory_order_release);
+        followingLock.unlock();
+
+        while (following != nullptr) {
+          executeSinglePath(*following, timeUtil.getRate());
+
+          // A path from replan() takes over right away, without stopping in between
+          followingLock.lock();
+          following = isDisabled() ? nullptr : std::move(replacementPath);
+          replacementPath = nullptr;
+          followingPath = following;
+          hasReplacement.store(false, std::memory_order_release);
+          followingLock.unlock();
+
+          if (following != nullptr) {
+            LOG_INFO_S("AsyncMotionProfileController: Switching to the replanned path");
+          }
+        }
+
+        std::unique_lock lock(currentPathMutex);
+        const bool handOff = !isDisabled() && !targetQueue.empty();
+        lock.unlock();
+
+        if (handOff) {
+          // The next path starts where this one ended, so keep driving
+          LOG_INFO_S("AsyncMotionProfileController: Handing off to the next path");
+        } else {
+          // Stop the chassis after the last path because it might not end at zero velocity
+          model->stop();
+
+          LOG_INFO_S("AsyncMotionProfileController: Done moving");
+        }
+      }
 
-        executeSinglePath(path->second, timeUtil.getRate());
+      std::scoped_lock lock(currentPathMutex);
+      if (isDisabled()) {
+        targetQueue.clear();
+      }
 
-        // Stop the chassis after the path because:
-        // 1. We only support an exit velocity of zero
-        // 2. Because of (1), we should make sure the system is stopped
-        model->stop();
+      if (targetQueue.empty()) {
+        isRunning.store(false, std::memory_order_release);
+      } else {
+        target.store(packTarget(targetQueue.front()), std::memory_order_release);
+        targetQueue.pop_front();
 
-        LOG_INFO_S("AsyncMotionProfileController: Done moving");
+        // Start the next path right away
+        continue;
       }
-
-      isRunning.store(false, std::memory_order_release);
     }
 
-    rate->delayUntil(10_ms);
+    loopStats.delayUntil(*rate, 10_ms);
   }
 
   LOG_INFO_S("Stopped AsyncMotionProfileController task.");
+  taskDone.store(true, std::memory_order_release);
 }
 
 void AsyncMotionProfileController::executeSinglePath(const TrajectoryPair &path,
                                                      std::unique_ptr<AbstractRate> rate) {
+  std::unique_lock gainsLock(currentPathMutex);
+  const auto gains = followerGains;
+  const QTime period = followerPeriod;
+  const auto pathOdometry = odometry;
+  const auto pathRamseteGains = ramseteGains;
+  gainsLock.unlock();
+
+  if (pathOdometry) {
+    if (!path.isCompact()) {
+      followSinglePathWithOdometry(path, pathOdometry, pathRamseteGains, std::move(rate));
+      return;
+    }
+
+    LOG_WARN_S("AsyncMotionProfileController: Following a compacted path without odometry.");
+  }
+
+  if (gains) {
+    followSinglePath(path, *gains, period, std::move(rate));
+    return;
+  }
+
   const int reversed = direction.load(std::memory_order_acquire);
   const bool followMirrored = mirrored.load(std::memory_order_acquire);
-  const int pathLength = getPathLength(path);
+  const int pathLength = path.length;
+  if (pathLength <= 0) {
+    return;
+  }
 
-  for (int i = 0; i < pathLength && !isDisabled(); ++i) {
-    // This mutex is used to combat an edge case of an edge case
-    // if a running path is asked to be removed at the moment this loop is executing
-    std::scoped_lock lock(currentPathMutex);
+  const QTime segDT = (path.isCompact() ? path.playback.getDt() : path.left()[0].dt) * second;
 
-    const auto segDT = path.left.get()[i].dt * second;
-    const auto leftRPM = convertLinearToRotational(path.left.get()[i].velocity * mps).convert(rpm);
-    const auto rightRPM =
-      convertLinearToRotational(path.right.get()[i].velocity * mps).convert(rpm);
+  // Compacted paths only keep their velocities. Converting a velocity to a command is a single
+  // multiplication, so they are converted as they are followed.
+  const double commandPerVelocity =
+    convertLinearToRotational(1_mps).convert(rpm) / toUnderlyingType(pair.internalGearset);
+  const auto command = [&](const int istep, const int iside) {
+    if (path.isCompact()) {
+      return path.playback.getVelocity(iside, istep) * commandPerVelocity;
+    }
+    return static_cast<double>(path.commands[2 * istep + iside]);
+  };
+
+  // Each step is chosen from the time since the path started, so a late tick skips ahead instead
+  // of delaying the rest of the path. A tick always moves forward at least one step so the path
+  // still finishes if the timer is coarse.
+  auto timer = timeUtil.getTimer();
+  const QTime start = timer->millis();
+  int lastStep = -1;
+  int skippedSteps = 0;
+
+  while (!isInterrupted()) {
+    const double elapsedSteps = ((timer->millis() - start) / segDT).getValue();
+    int step = static_cast<int>(elapsedSteps);
+    double fraction = elapsedSteps - step;
+    if (step <= lastStep) {
+      step = lastStep + 1;
+      fraction = 0;
+    }
+
+    if (step >= pathLength) {
+      break;
+    }
+
+    skippedSteps += step - lastStep - 1;
+    lastStep = step;
+
+    if (!path.isCompact()) {
+      // Without feedback the robot is assumed to be where the path says it is
+      publishProgress(path,
+                      step,
+                      plannedPose(path, step),
+                      (path.left()[step].velocity + path.right()[step].velocity) / 2);
+    }
+
+    // Late ticks land between two steps, so interpolate to where the path is right now
+    const int nextStep = std::min(step + 1, pathLength - 1);
+
+    const double leftSpeed =
+      (command(step, 0) + fraction * (command(nextStep, 0) - command(step, 0))) * reversed;
+    const double rightSpeed =
+      (command(step, 1) + fraction * (command(nextStep, 1) - command(step, 1))) * reversed;
 
-    const double rightSpeed = rightRPM / toUnderlyingType(pair.internalGearset) * reversed;
-    const double leftSpeed = leftRPM / toUnderlyingType(pair.internalGearset) * reversed;
     if (followMirrored) {
       model->left(rightSpeed);
       model->right(leftSpeed);
@@ -275,16 +1079,240 @@ void AsyncMotionProfileController::executeSinglePath(const TrajectoryPair &path,
       model->right(rightSpeed);
     }
 
-    // Unlock before the delay to be nice to other tasks
-    currentPathMutex.unlock();
+    loopStats.delayUntil(*rate, segDT);
+  }
 
-    rate->delayUntil(segDT);
+  if (skippedSteps > 0) {
+    LOG_WARN("AsyncMotionProfileController: Skipped " + std::to_string(skippedSteps) +
+             " late steps while following the path");
   }
 }
 
-int AsyncMotionProfileController::getPathLength(const TrajectoryPair &path) {
-  std::scoped_lock lock(currentPathMutex);
-  return path.length;
+void AsyncMotionProfileController::computeCommands(TrajectoryPair &ipath) const {
+  const int length = ipath.length;
+  ipath.commands.resize(2 * static_cast<std::size_t>(std::max(length, 0)));
+
+  const double gearset = toUnderlyingType(pair.internalGearset);
+  bool saturated = false;
+
+  for (int i = 0; i < length; ++i) {
+    const double leftSpeed =
+      convertLinearToRotational(ipath.left()[i].velocity * mps).convert(rpm) / gearset;
+    const double rightSpeed =
+      convertLinearToRotational(ipath.right()[i].velocity * mps).convert(rpm) / gearset;
+    saturated = saturated || std::abs(leftSpeed) > 1 || std::abs(rightSpeed) > 1;
+
+    ipath.commands[2 * i] = static_cast<float>(leftSpeed);
+    ipath.commands[2 * i + 1] = static_cast<float>(rightSpeed);
+  }
+
+  if (saturated) {
+    LOG_WARN_S("AsyncMotionProfileController: A path is faster than the motors can follow. "
+               "Lower the limits or set PathfinderLimits::maxWheelVel.");
+  }
+}
+
+void AsyncMotionProfileController::followSinglePathWithOdometry(
+  const TrajectoryPair &path,
+  const std::shared_ptr<Odometry> &iodometry,
+  const RamseteFollower::Gains &igains,
+  std::unique_ptr<AbstractRate> rate) {
+  const int reversed = direction.load(std::memory_order_acquire);
+  const bool followMirrored = mirrored.load(std::memory_order_acquire);
+  const int pathLength = path.length;
+  const double wheelTrack = scales.wheelTrack.convert(meter);
+
+  // Odometry has +y to the right and clockwise angles, Pathfinder has +y to the left and
+  // counterclockwise angles
+  const auto toPose = [](const OdomState &istate) {
+    return RamseteFollower::Pose{
+      istate.x.convert(meter), -istate.y.convert(meter), -istate.theta.convert(radian)};
+  };
+
+  // Following a path backwards negates x and the heading, mirroring it negates y and the heading.
+  // The robot is followed in the frame of the path with the same flips.
+  const double flipX = reversed;
+  const double flipY = followMirrored ? -1 : 1;
+  const double flipHeading = flipX * flipY;
+
+  const RamseteFollower follower(igains);
+  const auto start = toPose(iodometry->getState());
+  const auto origin = plannedPose(path, 0);
+  std::optional<RamseteFollower::Pose> lastPose{};
+
+  for (int i = 0; i < pathLength && !isInterrupted(); ++i) {
+    const Segment &left = path.left()[i];
+    const Segment &right = path.right()[i];
+    const QTime segDT = left.dt * second;
+    const auto planned = plannedPose(path, i);
+    const double linear = (left.velocity + right.velocity) / 2;
+    const double angular = (right.velocity - left.velocity) / wheelTrack;
+
+    // Move the displacement since the start of the path into the frame of the path
+    const auto current = toPose(iodometry->getState());
+    const double dx = current.x - start.x;
+    const double dy = current.y - start.y;
+    const double forward = flipX * (std::cos(start.heading) * dx + std::sin(start.heading) * dy);
+    const double lateral = flipY * (-std::sin(start.heading) * dx + std::cos(start.heading) * dy);
+    const RamseteFollower::Pose pose{
+      origin.x + std::cos(origin.heading) * forward - std::sin(origin.heading) * lateral,
+      origin.y + std::sin(origin.heading) * forward + std::cos(origin.heading) * lateral,
+      origin.heading + flipHeading * (current.heading - start.heading)};
+
+    // The measured velocity is how far the robot moved along its heading since the last step
+    const double measuredLinear =
+      lastPose ? (std::cos(pose.heading) * (pose.x - lastPose->x) +
+                  std::sin(pose.heading) * (pose.y - lastPose->y)) /
+                   left.dt
+               : linear;
+    lastPose = pose;
+    publishProgress(path, i, pose, measuredLinear);
+
+    const auto output = follower.step(planned, linear, angular, pose);
+
+    // Undo the flips to get the velocity of the robot itself
+    const double robotLinear = flipX * output.linear;
+    const double robotAngular = flipHeading * output.angular;
+
+    const auto leftRPM =
+      convertLinearToRotational((robotLinear - robotAngular * wheelTrack / 2) * mps).convert(rpm);
+    const auto rightRPM =
+      convertLinearToRotational((robotLinear + robotAngular * wheelTrack / 2) * mps).convert(rpm);
+
+    model->left(leftRPM / toUnderlyingType(pair.internalGearset));
+    model->right(rightRPM / toUnderlyingType(pair.internalGearset));
+
+    loopStats.delayUntil(*rate, segDT);
+  }
+}
+
+void AsyncMotionProfileController::followSinglePath(const TrajectoryPair &path,
+                                                    const TrajectoryFollower::Gains &igains,
+                                                    const QTime iperiod,
+                                                    std::unique_ptr<AbstractRate> rate) {
+  const int reversed = direction.load(std::memory_order_acquire);
+  const bool followMirrored = mirrored.load(std::memory_order_acquire);
+  const int pathLength = path.length;
+
+  // A mirrored path is followed by swapping the sides of the robot
+  const std::size_t leftSensor = followMirrored ? 1 : 0;
+  const std::size_t rightSensor = followMirrored ? 0 : 1;
+  const auto start = model->getSensorVals();
+  const auto distance = [&](const std::valarray<std::int32_t> &ivals, const std::size_t iside) {
+    return reversed * (ivals[iside] - start[iside]) / scales.straight;
+  };
+
+  const auto velocityAt = [&](const int istep, const int iside) {
+    if (path.isCompact()) {
+      return path.playback.getVelocity(iside, istep);
+    }
+    return (iside == 0 ? path.left() : path.right())[istep].velocity;
+  };
+
+  TrajectoryFollower left(igains);
+  TrajectoryFollower right(igains);
+  double lastDistance = 0;
+
+  for (int i = 0; i < pathLength && !isInterrupted(); ++i) {
+    const double dt = path.isCompact() ? path.playback.getDt() : path.left()[i].dt;
+    const double leftVelocity = velocityAt(i, 0);
+    const double rightVelocity = velocityAt(i, 1);
+
+    // The compact form does not keep accelerations, so both forms use the change in velocity. The
+    // first step uses the change into the second step. A path which starts moving, like a chained
+    // or replanned one, would otherwise start with a huge acceleration.
+    const int from = i > 0 ? i - 1 : 0;
+    const int to = i > 0 ? i : std::min(1, pathLength - 1);
+    const double leftAcceleration = (velocityAt(to, 0) - velocityAt(from, 0)) / dt;
+    const double rightAcceleration = (velocityAt(to, 1) - velocityAt(from, 1)) / dt;
+
+    const int steps = std::max(static_cast<int>(std::round(dt / iperiod.convert(second))), 1);
+    const double stepDt = dt / steps;
+
+    for (int step = 0; step < steps && !isInterrupted(); ++step) {
+      const auto sensors = model->getSensorVals();
+
+      if (!path.isCompact()) {
+        // The encoders can't tell where the robot is, only how fast it is going
+        const double centerDistance =
+          (distance(sensors, leftSensor) + distance(sensors, rightSensor)) / 2;
+        const double velocity = i == 0 && step == 0 ? (leftVelocity + rightVelocity) / 2
+                                                    : (centerDistance - lastDistance) / stepDt;
+        publishProgress(path, i, plannedPose(path, i), velocity);
+        lastDistance = centerDistance;
+      }
+
+      const double leftOutput =
+        left.step(leftVelocity, leftAcceleration, distance(sensors, leftSensor), stepDt);
+      const double rightOutput =
+        right.step(rightVelocity, rightAcceleration, distance(sensors, rightSensor), stepDt);
+
+      if (followMirrored) {
+        model->tank(rightOutput * reversed, leftOutput * reversed);
+      } else {
+        model->tank(leftOutput * reversed, rightOutput * reversed);
+      }
+
+      loopStats.delayUntil(*rate, stepDt * second);
+    }
+  }
+
+  LOG_DEBUG("AsyncMotionProfileController: Finished following with errors of " +
+            std::to_string(left.getError()) + " m and " + std::to_string(right.getError()) +
+            " m");
+}
+
+void AsyncMotionProfileController::publishProgress(const TrajectoryPair &ipath,
+                                                   const int istep,
+                                                   const RamseteFollower::Pose &ipose,
+                                                   const double ivelocity) {
+  // Readers retry if the sequence was odd or changed while they read
+  const std::uint32_t sequence = progressSequence.load(std::memory_order_relaxed);
+  progressSequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  progressPath.store(&ipath, std::memory_order_relaxed);
+  progressStep.store(istep, std::memory_order_relaxed);
+  progressX.store(ipose.x, std::memory_order_relaxed);
+  progressY.store(ipose.y, std::memory_order_relaxed);
+  progressHeading.store(ipose.heading, std::memory_order_relaxed);
+  progressVelocity.store(ivelocity, std::memory_order_relaxed);
+
+  progressSequence.store(sequence + 2, std::memory_order_release);
+}
+
+AsyncMotionProfileController::Progress AsyncMotionProfileController::loadProgress() const {
+  // Only made if a read has to be retried, and then reused for every retry
+  std::unique_ptr<AbstractRate> rate;
+
+  while (true) {
+    const std::uint32_t sequence = progressSequence.load(std::memory_order_acquire);
+    const Progress progress{progressPath.load(std::memory_order_relaxed),
+                            progressStep.load(std::memory_order_relaxed),
+                            {progressX.load(std::memory_order_relaxed),
+                             progressY.load(std::memory_order_relaxed),
+                             progressHeading.load(std::memory_order_relaxed)},
+                            progressVelocity.load(std::memory_order_relaxed)};
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if (sequence % 2 == 0 && progressSequence.load(std::memory_order_relaxed) == sequence) {
+      return progress;
+    }
+
+    // Let the follower finish writing in case it was interrupted by this task
+    if (!rate) {
+      rate = timeUtil.getRate();
+    }
+    rate->delayUntil(1_ms);
+  }
+}
+
+RamseteFollower::Pose AsyncMotionProfileController::plannedPose(const TrajectoryPair &ipath,
+                                                                const int istep) {
+  // The center of the robot is halfway between the wheels
+  const Segment &left = ipath.left()[istep];
+  const Segment &right = ipath.right()[istep];
+  return RamseteFollower::Pose{(left.x + right.x) / 2, (left.y + right.y) / 2, left.heading};
 }
 
 QAngularSpeed AsyncMotionProfileController::convertLinearToRotational(QSpeed linear) const {
@@ -318,14 +1346,124 @@ void AsyncMotionProfileController::moveTo(std::initializer_list<PathfinderPoint>
                                           const PathfinderLimits &ilimits,
                                           const bool ibackwards,
                                           const bool imirrored) {
-  static int moveToCount = 0;
-  std::string name = "__moveTo" + std::to_string(moveToCount++);
+  // Path IDs keep their slot forever, so every call reuses one ID instead of making a new one
+  const std::string name = "__moveTo";
   generatePath(iwaypoints, name, ilimits);
   setTarget(name, ibackwards, imirrored);
   waitUntilSettled();
   forceRemovePath(name);
 }
 
+bool AsyncMotionProfileController::replan() {
+  std::unique_lock lock(currentPathMutex);
+  const auto path = followingPath;
+  lock.unlock();
+
+  if (path == nullptr) {
+    LOG_WARN_S("AsyncMotionProfileController: Can't replan because no path is being followed.");
+    return false;
+  }
+
+  if (path->waypoints.empty() || path->isCompact()) {
+    LOG_WARN_S("AsyncMotionProfileController: Can't replan a path which was loaded or compacted.");
+    return false;
+  }
+
+  Progress now = loadProgress();
+
+  if (now.path != path.get()) {
+    // The follower hasn't taken its first step yet
+    now = Progress{path.get(), 0, plannedPose(*path, 0), path->limits.startVel};
+  }
+
+  // Skip the waypoints the robot has passed, which are the ones behind it along their heading
+  const auto &waypoints = path->waypoints;
+  const auto isPast = [&](const Waypoint &iwaypoint) {
+    return std::cos(iwaypoint.angle) * (now.pose.x - iwaypoint.x) +
+             std::sin(iwaypoint.angle) * (now.pose.y - iwaypoint.y) >=
+           0;
+  };
+
+  std::size_t next = 1;
+  while (next < waypoints.size() && isPast(waypoints[next])) {
+    ++next;
+  }
+
+  if (next == waypoints.size()) {
+    LOG_INFO_S("AsyncMotionProfileController: Not replanning because the robot is past the last "
+               "waypoint.");
+    return false;
+  }
+
+  // A waypoint right in front of the robot would need a very tight spline, so skip it unless it
+  // is the goal
+  constexpr double minWaypointDistance = 0.05;
+  if (next + 1 < waypoints.size() &&
+      std::hypot(waypoints[next].x - now.pose.x, waypoints[next].y - now.pose.y) <
+        minWaypointDistance) {
+    ++next;
+  }
+
+  std::vector<Waypoint> points{Waypoint{now.pose.x, now.pose.y, now.pose.heading}};
+  points.insert(points.end(), waypoints.begin() + next, waypoints.end());
+
+  // Only the spline from the robot to the next waypoint is new
+  const int cachedSplines =
+    path->splines.empty() ? 0 : static_cast<int>(waypoints.size() - 1 - next);
+  const Spline *splines = path->splines.data() + (path->splines.size() - cachedSplines);
+  const double *splineLengths =
+    path->splineLengths.data() + (path->splineLengths.size() - cachedSplines);
+
+  PathfinderLimits replanLimits = path->limits;
+  replanLimits.startVel = std::clamp(now.velocity, 0.0, replanLimits.maxVel);
+
+  LOG_INFO("AsyncMotionProfileController: Replanning from step " + std::to_string(now.step) +
+           " to " + std::to_string(points.size() - 1) + " waypoints");
+
+  const auto generate = [&](const PathfinderLimits &ilimits) {
+    // generateTrajectory() moves the waypoints into the path, so each attempt gets a copy
+    std::vector<Waypoint> attemptPoints = points;
+    TrajectoryCandidate candidate{};
+    const int status = preparePathfinderCandidate(attemptPoints,
+                                                  ilimits,
+                                                  path->left()[0].dt,
+                                                  splines,
+                                                  splineLengths,
+                                                  cachedSplines,
+                                                  scratch,
+                                                  candidate);
+    return generateTrajectory(attemptPoints, "replanned path", ilimits, status, candidate, scratch);
+  };
+
+  // The new path starts at the robot's velocity, so it is validated again like a generated path
+  std::optional<TrajectoryPair> replanned{};
+  try {
+    std::scoped_lock scratchLock(scratchMutex);
+    replanned.emplace(generate(replanLimits));
+    if (const auto rescaled = applyPathValidation(*replanned, "replanned path", false)) {
+      replanned.emplace(generate(*rescaled));
+      applyPathValidation(*replanned, "replanned path", true);
+    }
+  } catch (const std::runtime_error &) {
+    // The error was already logged and the robot keeps following the old path
+    return false;
+  }
+
+  computeCommands(*replanned);
+  auto replacement = std::make_shared<const TrajectoryPair>(std::move(*replanned));
+
+  lock.lock();
+  if (followingPath != path) {
+    LOG_WARN_S("AsyncMotionProfileController: Not replanning because the path finished or changed "
+               "while the new path was generated.");
+    return false;
+  }
+
+  replacementPath = std::move(replacement);
+  hasReplacement.store(true, std::memory_order_release);
+  return true;
+}
+
 PathfinderPoint AsyncMotionProfileController::getError() const {
   return PathfinderPoint{0_m, 0_m, 0_deg};
 }
@@ -363,6 +1501,11 @@ bool AsyncMotionProfileController::isDisabled() const {
   return disabled.load(std::memory_order_acquire);
 }
 
+bool AsyncMotionProfileController::isInterrupted() const {
+  return isDisabled() || hasReplacement.load(std::memory_order_acquire) ||
+         dtorCalled.load(std::memory_order_acquire);
+}
+
 void AsyncMotionProfileController::tarePosition() {
 }
 
@@ -379,8 +1522,28 @@ CrossplatformThread *AsyncMotionProfileController::getThread() const {
   return task;
 }
 
+LoopStats &AsyncMotionProfileController::getLoopStats() {
+  return loopStats;
+}
+
 void AsyncMotionProfileController::storePath(const std::string &idirectory,
                                              const std::string &ipathId) {
+  std::string filePath = makeFilePath(idirectory, ipathId + ".traj");
+  FILE *pathFile = fopen(filePath.c_str(), "wb");
+
+  // Make sure we can open the file successfully
+  if (pathFile == NULL) {
+    LOG_WARN("AsyncMotionProfileController: Couldn't open file " + filePath + " for writing");
+    return;
+  }
+
+  internalStorePathBinary(pathFile, ipathId);
+
+  fclose(pathFile);
+}
+
+void AsyncMotionProfileController::storePathCsv(const std::string &idirectory,
+                                                const std::string &ipathId) {
   std::string leftFilePath = makeFilePath(idirectory, ipathId + ".left.csv");
   std::string rightFilePath = makeFilePath(idirectory, ipathId + ".right.csv");
   FILE *leftPathFile = fopen(leftFilePath.c_str(), "w");
@@ -408,6 +1571,21 @@ void AsyncMotionProfileController::storePath(const std::string &idirectory,
 
 void AsyncMotionProfileController::loadPath(const std::string &idirectory,
                                             const std::string &ipathId) {
+  std::string filePath = makeFilePath(idirectory, ipathId + ".traj");
+  FILE *pathFile = fopen(filePath.c_str(), "rb");
+
+  // Prefer the binary file because it can be loaded without parsing
+  if (pathFile != NULL) {
+    const bool loaded = internalLoadPathBinary(pathFile, ipathId);
+    fclose(pathFile);
+
+    if (loaded) {
+      return;
+    }
+
+    LOG_WARN("AsyncMotionProfileController: Couldn't load " + filePath + ", trying CSV files");
+  }
+
   std::string leftFilePath = makeFilePath(idirectory, ipathId + ".left.csv");
   std::string rightFilePath = makeFilePath(idirectory, ipathId + ".right.csv");
   FILE *leftPathFile = fopen(leftFilePath.c_str(), "r");
@@ -436,19 +1614,22 @@ void AsyncMotionProfileController::loadPath(const std::string &idirectory,
 void AsyncMotionProfileController::internalStorePath(FILE *leftPathFile,
                                                      FILE *rightPathFile,
                                                      const std::string &ipathId) {
-  auto pathData = this->paths.find(ipathId);
+  const auto pathData = findPath(ipathId);
 
   // Make sure path exists
-  if (pathData == paths.end()) {
+  if (pathData == nullptr) {
     LOG_WARN("AsyncMotionProfileController: Controller was asked to serialize non-existent path " +
              ipathId);
     // Do nothing- can't serialize nonexistent path
+  } else if (pathData->isCompact()) {
+    LOG_WARN("AsyncMotionProfileController: Controller was asked to serialize compacted path " +
+             ipathId);
   } else {
-    int len = pathData->second.length;
+    int len = pathData->length;
 
     // Serialize paths
-    pathfinder_serialize_csv(leftPathFile, pathData->second.left.get(), len);
-    pathfinder_serialize_csv(rightPathFile, pathData->second.right.get(), len);
+    pathfinder_serialize_csv(leftPathFile, pathData->left(), len);
+    pathfinder_serialize_csv(rightPathFile, pathData->right(), len);
   }
 }
 
@@ -466,16 +1647,83 @@ void AsyncMotionProfileController::internalLoadPath(FILE *leftPathFile,
   rewind(leftPathFile);
 
   // Allocate memory
-  SegmentPtr leftTrajectory((Segment *)malloc(sizeof(Segment) * count), free);
-  SegmentPtr rightTrajectory((Segment *)malloc(sizeof(Segment) * count), free);
+  auto path = allocateTrajectoryPair(count, limits);
 
-  pathfinder_deserialize_csv(leftPathFile, leftTrajectory.get());
-  pathfinder_deserialize_csv(rightPathFile, rightTrajectory.get());
+  pathfinder_deserialize_csv(leftPathFile, path.left());
+  pathfinder_deserialize_csv(rightPathFile, path.right());
 
   // Remove the old path if it exists
-  forceRemovePath(ipathId);
-  paths.emplace(ipathId,
-                TrajectoryPair{std::move(leftTrajectory), std::move(rightTrajectory), count});
+  insertPath(ipathId, std::move(path));
+}
+
+bool AsyncMotionProfileController::internalStorePathBinary(FILE *pathFile,
+                                                           const std::string &ipathId) {
+  const auto pathData = findPath(ipathId);
+
+  // Make sure path exists
+  if (pathData == nullptr) {
+    LOG_WARN("AsyncMotionProfileController: Controller was asked to serialize non-existent path " +
+             ipathId);
+    return false;
+  }
+
+  const TrajectoryPair &path = *pathData;
+
+  if (path.isCompact()) {
+    LOG_WARN("AsyncMotionProfileController: Controller was asked to serialize compacted path " +
+             ipathId);
+    return false;
+  }
+
+  TrajectoryFileHeader header;
+  header.sides = 2;
+  header.length = path.length;
+  header.dt = path.length > 0 ? path.left()[0].dt : 0;
+  header.limits = path.limits;
+  header.wheelTrack = scales.wheelTrack.convert(meter);
+
+  const Segment *sides[] = {path.left(), path.right()};
+  if (!writeTrajectoryFile(pathFile, header, sides)) {
+    LOG_WARN("AsyncMotionProfileController: Couldn't write all of path " + ipathId);
+    return false;
+  }
+
+  return true;
+}
+
+bool AsyncMotionProfileController::internalLoadPathBinary(FILE *pathFile,
+                                                          const std::string &ipathId) {
+  TrajectoryFileHeader header;
+  if (!readTrajectoryFileHeader(pathFile, header) || header.sides != 2) {
+    LOG_WARN("AsyncMotionProfileController: Path file for " + ipathId +
+             " is not a tank drive trajectory file written by this version of OkapiLib");
+    return false;
+  }
+
+  if (std::abs(header.wheelTrack - scales.wheelTrack.convert(meter)) > 1e-6) {
+    LOG_WARN("AsyncMotionProfileController: Path " + ipathId +
+             " was generated for a wheel track of " + std::to_string(header.wheelTrack) +
+             " meters");
+  }
+
+  // Allocate memory
+  auto path = allocateTrajectoryPair(header.length, header.limits);
+
+  if (header.length > 0 && path.segments == nullptr) {
+    LOG_WARN("AsyncMotionProfileController: Could not allocate path " + ipathId);
+    return false;
+  }
+
+  Segment *sides[] = {path.left(), path.right()};
+  if (!readTrajectoryFileSegments(pathFile, header, sides)) {
+    LOG_WARN("AsyncMotionProfileController: Path file for " + ipathId + " is truncated");
+    return false;
+  }
+
+  // Remove the old path if it exists
+  insertPath(ipathId, std::move(path));
+
+  return true;
 }
 
 std::string AsyncMotionProfileController::makeFilePath(const std::string &directory,
@@ -49,7 +49,7 @@ AsyncPosPIDController::AsyncPosPIDController(
                                                   ikBias,
                                                   itimeUtil,
                                                   std::move(iderivativeFilter)),
-      itimeUtil.getRateSupplier(),
+      itimeUtil,
       iratio,
       ilogger),
     offsettableInput(iinput),
@@ -29,7 +29,7 @@ AsyncVelPIDController::AsyncVelPIDController(
                                                   std::move(ivelMath),
                                                   itimeUtil,
                                                   std::move(iderivativeFilter)),
-      itimeUtil.getRateSupplier(),
+      itimeUtil,
       iratio,
       ilogger),
     internalController(std::static_pointer_cast<IterativeVelPIDController>(controller)) {
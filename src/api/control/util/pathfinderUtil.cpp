@@ -0,0 +1,514 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/pathfinderUtil.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace okapi {
+bool PathfinderLimits::operator==(const PathfinderLimits &other) const {
+  return maxVel == other.maxVel && maxAccel == other.maxAccel && maxJerk == other.maxJerk &&
+         fit == other.fit && maxWheelVel == other.maxWheelVel &&
+         maxWheelAccel == other.maxWheelAccel && startVel == other.startVel &&
+         endVel == other.endVel && lengthTolerance == other.lengthTolerance &&
+         lengthSamples == other.lengthSamples;
+}
+
+bool PathfinderLimits::operator!=(const PathfinderLimits &other) const {
+  return !(*this == other);
+}
+
+void PathfinderScratch::reserve(const int ipathLength,
+                                const int itrajectoryLength,
+                                const int isampleCount) {
+  const auto splineCount = static_cast<std::size_t>(std::max(ipathLength - 1, 0));
+  if (splineData.size() < splineCount) {
+    splineData.resize(splineCount);
+    splineLengthData.resize(splineCount);
+  }
+
+  const auto segmentCount = static_cast<std::size_t>(std::max(itrajectoryLength, 0));
+  if (segmentData.size() < segmentCount) {
+    segmentData.resize(segmentCount);
+    bufferData.resize(segmentCount);
+  }
+
+  // The table holds one entry per sample, including both ends of the spline
+  const auto tableCount = static_cast<std::size_t>(isampleCount > 0 ? isampleCount + 1 : 0);
+  if (tableData.size() < tableCount) {
+    tableData.resize(tableCount);
+  }
+}
+
+void PathfinderScratch::reserveProfile(const int igridLength) {
+  const auto gridCount = static_cast<std::size_t>(std::max(igridLength, 0));
+  if (gridData.size() < gridCount) {
+    gridData.resize(gridCount);
+    // Curvature, velocity, and time at each grid point
+    profileData.resize(3 * gridCount);
+  }
+}
+
+Spline *PathfinderScratch::splines() {
+  return splineData.data();
+}
+
+double *PathfinderScratch::splineLengths() {
+  return splineLengthData.data();
+}
+
+Segment *PathfinderScratch::segments() {
+  return segmentData.data();
+}
+
+double *PathfinderScratch::buffer() {
+  return bufferData.data();
+}
+
+double *PathfinderScratch::table() {
+  return tableData.data();
+}
+
+Segment *PathfinderScratch::grid() {
+  return gridData.data();
+}
+
+double *PathfinderScratch::profile() {
+  return profileData.data();
+}
+
+int preparePathfinderCandidate(std::vector<Waypoint> &ipoints,
+                               const PathfinderLimits &ilimits,
+                               const double idt,
+                               PathfinderScratch &iscratch,
+                               TrajectoryCandidate &ocandidate) {
+  const int pathLength = static_cast<int>(ipoints.size());
+  if (pathLength < 2) {
+    return -1;
+  }
+
+  iscratch.reserve(pathLength, 0);
+
+  void (*fit)(Waypoint, Waypoint, Spline *) = nullptr;
+  switch (ilimits.fit) {
+  case PathfinderFit::hermiteCubic:
+    fit = FIT_HERMITE_CUBIC;
+    break;
+  case PathfinderFit::hermiteQuintic:
+    fit = FIT_HERMITE_QUINTIC;
+    break;
+  case PathfinderFit::curvatureContinuous:
+    // These splines depend on their neighbors, so they are all fitted up front
+    pf_fit_hermite_curvature_continuous(ipoints.data(), pathLength, iscratch.splines());
+    break;
+  }
+
+  int status = -1;
+  if (ilimits.lengthTolerance > 0) {
+    status = pathfinder_prepare_gauss_into(ipoints.data(),
+                                           pathLength,
+                                           fit,
+                                           ilimits.lengthTolerance,
+                                           idt,
+                                           ilimits.maxVel,
+                                           ilimits.maxAccel,
+                                           ilimits.maxJerk,
+                                           &ocandidate,
+                                           iscratch.splines(),
+                                           iscratch.splineLengths());
+  } else if (ilimits.lengthSamples > 0) {
+    status = pathfinder_prepare_into(ipoints.data(),
+                                     pathLength,
+                                     fit,
+                                     ilimits.lengthSamples,
+                                     idt,
+                                     ilimits.maxVel,
+                                     ilimits.maxAccel,
+                                     ilimits.maxJerk,
+                                     &ocandidate,
+                                     iscratch.splines(),
+                                     iscratch.splineLengths());
+  }
+
+  return status < 0 ? status : ocandidate.length;
+}
+
+int preparePathfinderCandidate(std::vector<Waypoint> &ipoints,
+                               const PathfinderLimits &ilimits,
+                               const double idt,
+                               const Spline *icachedSplines,
+                               const double *icachedLengths,
+                               const int icachedCount,
+                               PathfinderScratch &iscratch,
+                               TrajectoryCandidate &ocandidate) {
+  const int pathLength = static_cast<int>(ipoints.size());
+  // Cached lengths were measured with quadrature, so sample-based paths are measured from scratch
+  if (ilimits.fit == PathfinderFit::curvatureContinuous || ilimits.lengthTolerance <= 0 ||
+      icachedCount <= 0) {
+    return preparePathfinderCandidate(ipoints, ilimits, idt, iscratch, ocandidate);
+  }
+
+  if (pathLength < 2 || icachedCount > pathLength - 1) {
+    return -1;
+  }
+
+  iscratch.reserve(pathLength, 0);
+  Spline *splines = iscratch.splines();
+  double *lengths = iscratch.splineLengths();
+
+  const int fitted = pathLength - 1 - icachedCount;
+  for (int i = 0; i < fitted; ++i) {
+    if (ilimits.fit == PathfinderFit::hermiteCubic) {
+      pf_fit_hermite_cubic(ipoints[i], ipoints[i + 1], &splines[i]);
+    } else {
+      pf_fit_hermite_quintic(ipoints[i], ipoints[i + 1], &splines[i]);
+    }
+
+    // Zero makes Pathfinder measure the new splines
+    lengths[i] = 0;
+  }
+
+  std::copy(icachedSplines, icachedSplines + icachedCount, splines + fitted);
+  std::copy(icachedLengths, icachedLengths + icachedCount, lengths + fitted);
+
+  const int status = pathfinder_prepare_fitted_into(ipoints.data(),
+                                                    pathLength,
+                                                    ilimits.lengthTolerance,
+                                                    idt,
+                                                    ilimits.maxVel,
+                                                    ilimits.maxAccel,
+                                                    ilimits.maxJerk,
+                                                    &ocandidate,
+                                                    splines,
+                                                    lengths);
+
+  return status < 0 ? status : ocandidate.length;
+}
+
+int generatePathfinderTrajectory(TrajectoryCandidate &icandidate,
+                                 const PathfinderLimits &ilimits,
+                                 const double iwheelTrack,
+                                 PathfinderScratch &iscratch) {
+  if (ilimits.maxWheelVel <= 0 && ilimits.maxWheelAccel <= 0 && ilimits.startVel == 0 &&
+      ilimits.endVel == 0) {
+    // Candidates measured with quadrature don't use the table
+    iscratch.reserve(icandidate.path_length, icandidate.length, icandidate.config.sample_count);
+    const int status = pathfinder_generate_lut(
+      &icandidate, iscratch.segments(), iscratch.buffer(), iscratch.table());
+    return status < 0 ? status : icandidate.length;
+  }
+
+  if (ilimits.maxVel <= 0 || ilimits.maxAccel <= 0) {
+    return -1;
+  }
+
+  // Divide the path into steps of about a centimeter and find the curvature at each point
+  constexpr double gridSpacing = 0.01;
+  const double totalLength = icandidate.totalLength;
+  const int steps = std::max(static_cast<int>(std::ceil(totalLength / gridSpacing)), 1);
+  const double ds = totalLength / steps;
+
+  iscratch.reserve(icandidate.path_length, 0, icandidate.config.sample_count);
+  iscratch.reserveProfile(steps + 1);
+  Segment *grid = iscratch.grid();
+  double *curvature = iscratch.profile();
+  double *velocity = curvature + (steps + 1);
+  double *time = velocity + (steps + 1);
+
+  for (int i = 0; i <= steps; ++i) {
+    grid[i].position = i * ds;
+  }
+  pathfinder_place_on_splines_lut(&icandidate, grid, steps + 1, curvature, iscratch.table());
+
+  // The outer wheel moves (1 + |k| * w / 2) times faster than the center of the robot. The
+  // acceleration caused by changing curvature is small enough to ignore.
+  const auto scale = [&](const int i) { return 1 + std::abs(curvature[i]) * iwheelTrack / 2; };
+  const auto maxVelAt = [&](const int i) {
+    return ilimits.maxWheelVel > 0 ? std::min(ilimits.maxVel, ilimits.maxWheelVel / scale(i))
+                                   : ilimits.maxVel;
+  };
+  const auto maxAccelAt = [&](const int i) {
+    const auto accelAt = [&](const int j) {
+      return ilimits.maxWheelAccel > 0
+               ? std::min(ilimits.maxAccel, ilimits.maxWheelAccel / scale(j))
+               : ilimits.maxAccel;
+    };
+    return std::min(accelAt(i), accelAt(i + 1));
+  };
+
+  // Accelerate as hard as allowed from the start, then decelerate as hard as allowed to the end
+  velocity[0] = std::clamp(ilimits.startVel, 0.0, maxVelAt(0));
+  for (int i = 0; i < steps; ++i) {
+    velocity[i + 1] =
+      std::min(maxVelAt(i + 1), std::sqrt(velocity[i] * velocity[i] + 2 * maxAccelAt(i) * ds));
+  }
+  velocity[steps] = std::clamp(ilimits.endVel, 0.0, velocity[steps]);
+  for (int i = steps - 1; i >= 0; --i) {
+    velocity[i] =
+      std::min(velocity[i], std::sqrt(velocity[i + 1] * velocity[i + 1] + 2 * maxAccelAt(i) * ds));
+  }
+
+  // Each step has a constant acceleration, so its average velocity is the mean of its ends
+  time[0] = 0;
+  for (int i = 0; i < steps; ++i) {
+    const double average = (velocity[i] + velocity[i + 1]) / 2;
+    if (average <= 0) {
+      return -1;
+    }
+    time[i + 1] = time[i] + ds / average;
+  }
+
+  const double dt = icandidate.config.dt;
+  const int length = static_cast<int>(std::ceil(time[steps] / dt));
+  iscratch.reserve(icandidate.path_length, length);
+  Segment *segments = iscratch.segments();
+
+  int step = 0;
+  for (int k = 0; k < length; ++k) {
+    // Line the segments up with the end of the path so the last step is a whole time step long,
+    // otherwise the wheel velocities at the end would be too low after pathfinder_modify_tank()
+    const double t = std::max(time[steps] - (length - 1 - k) * dt, 0.0);
+    while (step < steps - 1 && time[step + 1] < t) {
+      ++step;
+    }
+
+    const double accel =
+      (velocity[step + 1] * velocity[step + 1] - velocity[step] * velocity[step]) / (2 * ds);
+    const double elapsed = t - time[step];
+
+    Segment &seg = segments[k];
+    seg.dt = dt;
+    seg.position = std::min(step * ds + velocity[step] * elapsed + accel * elapsed * elapsed / 2,
+                            totalLength);
+    seg.velocity = std::max(velocity[step] + accel * elapsed, 0.0);
+    // The first segment may already be moving, so it takes its acceleration from the profile
+    seg.acceleration = k > 0 ? (seg.velocity - segments[k - 1].velocity) / dt : accel;
+    seg.jerk = k > 0 ? (seg.acceleration - segments[k - 1].acceleration) / dt : 0;
+  }
+
+  pathfinder_place_on_splines_lut(&icandidate, segments, length, nullptr, iscratch.table());
+  icandidate.length = length;
+
+  return length;
+}
+
+namespace {
+// The size of the magic number, version and field size which start every header
+constexpr std::size_t trajectoryFilePrefixSize = 12;
+
+// Room for the fields written by this version, which writeTrajectoryFile() measures as it writes
+constexpr std::size_t trajectoryFileMaxWrittenFieldsSize = 256;
+
+// sides, length and dt must always be present
+constexpr std::size_t trajectoryFileMinFieldsSize = 2 * 4 + 8;
+
+// Larger field sizes are taken to mean the file is damaged
+constexpr std::size_t trajectoryFileMaxFieldsSize = 4096;
+
+static_assert(sizeof(Segment) == 8 * sizeof(double), "Segments are stored as 8 doubles");
+
+/**
+ * Writes fixed-width little-endian fields into a buffer.
+ */
+class FieldWriter {
+  public:
+  explicit FieldWriter(std::uint8_t *ibuffer) : start(ibuffer), pos(ibuffer) {
+  }
+
+  void put(const std::uint64_t ivalue, const std::size_t isize) {
+    for (std::size_t i = 0; i < isize; ++i) {
+      *pos++ = static_cast<std::uint8_t>(ivalue >> (8 * i));
+    }
+  }
+
+  void putU8(const std::uint8_t ivalue) {
+    put(ivalue, 1);
+  }
+
+  void putU32(const std::uint32_t ivalue) {
+    put(ivalue, 4);
+  }
+
+  void putF64(const double ivalue) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &ivalue, sizeof(bits));
+    put(bits, 8);
+  }
+
+  /**
+   * @return The number of bytes written so far.
+   */
+  std::size_t size() const {
+    return static_cast<std::size_t>(pos - start);
+  }
+
+  protected:
+  std::uint8_t *const start;
+  std::uint8_t *pos;
+};
+
+/**
+ * Reads fixed-width little-endian fields from a buffer. Reading past the end of the buffer leaves
+ * the value untouched, so fields missing from older files keep their default.
+ */
+class FieldReader {
+  public:
+  FieldReader(const std::uint8_t *ibuffer, const std::size_t isize)
+    : pos(ibuffer), end(ibuffer + isize) {
+  }
+
+  bool get(std::uint64_t &ovalue, const std::size_t isize) {
+    if (static_cast<std::size_t>(end - pos) < isize) {
+      pos = end;
+      return false;
+    }
+
+    ovalue = 0;
+    for (std::size_t i = 0; i < isize; ++i) {
+      ovalue |= static_cast<std::uint64_t>(*pos++) << (8 * i);
+    }
+
+    return true;
+  }
+
+  void getU32(std::uint32_t &ovalue) {
+    if (std::uint64_t value; get(value, 4)) {
+      ovalue = static_cast<std::uint32_t>(value);
+    }
+  }
+
+  void getI32(std::int32_t &ovalue) {
+    if (std::uint64_t value; get(value, 4)) {
+      ovalue = static_cast<std::int32_t>(static_cast<std::uint32_t>(value));
+    }
+  }
+
+  void getF64(double &ovalue) {
+    if (std::uint64_t value; get(value, 8)) {
+      std::memcpy(&ovalue, &value, sizeof(ovalue));
+    }
+  }
+
+  // Returns false if the fit is not one this version knows
+  bool getFit(PathfinderFit &ovalue) {
+    std::uint64_t value;
+    if (!get(value, 1)) {
+      return true;
+    }
+
+    if (value > static_cast<std::uint64_t>(PathfinderFit::curvatureContinuous)) {
+      return false;
+    }
+
+    ovalue = static_cast<PathfinderFit>(value);
+    return true;
+  }
+
+  protected:
+  const std::uint8_t *pos;
+  const std::uint8_t *const end;
+};
+} // namespace
+
+bool writeTrajectoryFile(FILE *ifile,
+                         const TrajectoryFileHeader &iheader,
+                         const Segment *const *isides) {
+  // The fields are written first so the prefix can hold their size
+  std::uint8_t buffer[trajectoryFilePrefixSize + trajectoryFileMaxWrittenFieldsSize];
+  FieldWriter writer(buffer + trajectoryFilePrefixSize);
+
+  // New fields go at the end so older readers can skip them
+  writer.putU32(static_cast<std::uint32_t>(iheader.sides));
+  writer.putU32(static_cast<std::uint32_t>(iheader.length));
+  writer.putF64(iheader.dt);
+  writer.putF64(iheader.wheelTrack);
+  writer.putF64(iheader.limits.maxVel);
+  writer.putF64(iheader.limits.maxAccel);
+  writer.putF64(iheader.limits.maxJerk);
+  writer.putU8(static_cast<std::uint8_t>(iheader.limits.fit));
+  writer.putF64(iheader.limits.maxWheelVel);
+  writer.putF64(iheader.limits.maxWheelAccel);
+  writer.putF64(iheader.limits.startVel);
+  writer.putF64(iheader.limits.endVel);
+  writer.putF64(iheader.limits.lengthTolerance);
+  writer.putU32(static_cast<std::uint32_t>(iheader.limits.lengthSamples));
+
+  const std::size_t fieldsSize = writer.size();
+  FieldWriter prefixWriter(buffer);
+  prefixWriter.putU32(TrajectoryFileHeader::magicNumber);
+  prefixWriter.putU32(TrajectoryFileHeader::currentVersion);
+  prefixWriter.putU32(static_cast<std::uint32_t>(fieldsSize));
+
+  if (fwrite(buffer, trajectoryFilePrefixSize + fieldsSize, 1, ifile) != 1) {
+    return false;
+  }
+
+  for (std::int32_t i = 0; i < iheader.sides; ++i) {
+    const auto count = static_cast<std::size_t>(iheader.length);
+    if (fwrite(isides[i], sizeof(Segment), count, ifile) != count) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool readTrajectoryFileHeader(FILE *ifile, TrajectoryFileHeader &oheader) {
+  std::uint8_t prefix[trajectoryFilePrefixSize];
+  if (fread(prefix, sizeof(prefix), 1, ifile) != 1) {
+    return false;
+  }
+
+  std::uint32_t fieldsSize = 0;
+  FieldReader prefixReader(prefix, sizeof(prefix));
+  prefixReader.getU32(oheader.magic);
+  prefixReader.getU32(oheader.version);
+  prefixReader.getU32(fieldsSize);
+
+  if (oheader.magic != TrajectoryFileHeader::magicNumber ||
+      oheader.version < TrajectoryFileHeader::oldestReadableVersion ||
+      oheader.version > TrajectoryFileHeader::currentVersion ||
+      fieldsSize < trajectoryFileMinFieldsSize || fieldsSize > trajectoryFileMaxFieldsSize) {
+    return false;
+  }
+
+  std::vector<std::uint8_t> fields(fieldsSize);
+  if (fread(fields.data(), fieldsSize, 1, ifile) != 1) {
+    return false;
+  }
+
+  FieldReader reader(fields.data(), fields.size());
+  reader.getI32(oheader.sides);
+  reader.getI32(oheader.length);
+  reader.getF64(oheader.dt);
+  reader.getF64(oheader.wheelTrack);
+  reader.getF64(oheader.limits.maxVel);
+  reader.getF64(oheader.limits.maxAccel);
+  reader.getF64(oheader.limits.maxJerk);
+  const bool knownFit = reader.getFit(oheader.limits.fit);
+  reader.getF64(oheader.limits.maxWheelVel);
+  reader.getF64(oheader.limits.maxWheelAccel);
+  reader.getF64(oheader.limits.startVel);
+  reader.getF64(oheader.limits.endVel);
+  reader.getF64(oheader.limits.lengthTolerance);
+  reader.getI32(oheader.limits.lengthSamples);
+
+  return knownFit && oheader.sides > 0 && oheader.length >= 0;
+}
+
+bool readTrajectoryFileSegments(FILE *ifile,
+                                const TrajectoryFileHeader &iheader,
+                                Segment *const *osides) {
+  for (std::int32_t i = 0; i < iheader.sides; ++i) {
+    const auto count = static_cast<std::size_t>(iheader.length);
+    if (fread(osides[i], sizeof(Segment), count, ifile) != count) {
+      return false;
+    }
+  }
+
+  return true;
+}
+} // namespace okapi
@@ -27,6 +27,9 @@ PIDTuner::PIDTuner(const std::shared_ptr<ControllerInput<double>> &iinput,
                    double ikITAE,
                    const std::shared_ptr<Logger> &ilogger)
   : logger(ilogger),
+    iterationFormat(logger->registerFormat("PIDTuner: Iteration number {}")),
+    particleFormat(logger->registerFormat("PIDTuner: Particle number {}")),
+    errorFormat(logger->registerFormat("PIDTuner: New error is {}")),
     timeUtil(itimeUtil),
     input(iinput),
     output(ioutput),
@@ -80,12 +83,12 @@ PIDTuner::Output PIDTuner::autotune() {
 
   // Run the optimization
   for (std::size_t iteration = 0; iteration < numIterations; iteration++) {
-    LOG_INFO("PIDTuner: Iteration number " + std::to_string(iteration));
+    LOG_INFO_RECORD(iterationFormat, iteration);
 
     bool firstGoal = true;
 
     for (std::size_t particleIndex = 0; particleIndex < numParticles; particleIndex++) {
-      LOG_INFO("PIDTuner: Particle number " + std::to_string(particleIndex));
+      LOG_INFO_RECORD(particleFormat, particleIndex);
 
       testController.setGains({particles.at(particleIndex).kP.pos,
                                particles.at(particleIndex).kI.pos,
@@ -126,7 +129,7 @@ PIDTuner::Output PIDTuner::autotune() {
 
       const double error = kSettle * settleTime.convert(millisecond) + kITAE * itae;
 
-      LOG_DEBUG("PIDTuner: New error is " + std::to_string(error));
+      LOG_DEBUG_RECORD(errorFormat, error);
 
       if (error < particles.at(particleIndex).bestError) {
         particles.at(particleIndex).kP.best = particles.at(particleIndex).kP.pos;
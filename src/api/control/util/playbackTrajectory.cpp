@@ -0,0 +1,81 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/playbackTrajectory.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace okapi {
+PlaybackTrajectory::PlaybackTrajectory(const Segment *const *isides,
+                                       const std::int32_t isideCount,
+                                       const std::int32_t ilength,
+                                       const encoding iencoding)
+  : sides(isideCount), length(ilength), velocityEncoding(iencoding) {
+  // Pathfinder uses the same time step for every segment
+  dt = sides > 0 && length > 0 ? isides[0][0].dt : 0;
+
+  const auto count = static_cast<std::size_t>(sides) * length;
+
+  if (velocityEncoding == encoding::float32) {
+    floatVelocities.reserve(count);
+    for (std::int32_t side = 0; side < sides; ++side) {
+      for (std::int32_t step = 0; step < length; ++step) {
+        floatVelocities.push_back(static_cast<float>(isides[side][step].velocity));
+      }
+    }
+  } else {
+    constexpr double maxQuantized = std::numeric_limits<std::int16_t>::max();
+
+    quantizedVelocities.reserve(count);
+    scales.reserve(sides);
+    for (std::int32_t side = 0; side < sides; ++side) {
+      double maxVelocity = 0;
+      for (std::int32_t step = 0; step < length; ++step) {
+        maxVelocity = std::max(maxVelocity, std::abs(isides[side][step].velocity));
+      }
+
+      const double scale = maxVelocity > 0 ? maxVelocity / maxQuantized : 1;
+      scales.push_back(scale);
+
+      for (std::int32_t step = 0; step < length; ++step) {
+        quantizedVelocities.push_back(
+          static_cast<std::int16_t>(std::lround(isides[side][step].velocity / scale)));
+      }
+    }
+  }
+}
+
+std::int32_t PlaybackTrajectory::getSides() const {
+  return sides;
+}
+
+std::int32_t PlaybackTrajectory::getLength() const {
+  return length;
+}
+
+double PlaybackTrajectory::getDt() const {
+  return dt;
+}
+
+PlaybackTrajectory::encoding PlaybackTrajectory::getEncoding() const {
+  return velocityEncoding;
+}
+
+double PlaybackTrajectory::getVelocity(const std::int32_t iside, const std::int32_t istep) const {
+  const auto index = static_cast<std::size_t>(iside) * length + istep;
+
+  if (velocityEncoding == encoding::float32) {
+    return floatVelocities[index];
+  }
+
+  return quantizedVelocities[index] * scales[iside];
+}
+
+std::size_t PlaybackTrajectory::getSize() const {
+  return floatVelocities.size() * sizeof(float) +
+         quantizedVelocities.size() * sizeof(std::int16_t) + scales.size() * sizeof(double);
+}
+} // namespace okapi
@@ -0,0 +1,36 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/ramseteFollower.hpp"
+#include "okapi/api/util/mathUtil.hpp"
+#include <cmath>
+
+namespace okapi {
+RamseteFollower::RamseteFollower(const Gains &igains) : gains(igains) {
+}
+
+RamseteFollower::RamseteFollower() : RamseteFollower(Gains()) {
+}
+
+RamseteFollower::Output RamseteFollower::step(const Pose &itarget,
+                                              const double ilinear,
+                                              const double iangular,
+                                              const Pose &ipose) const {
+  // Rotate the error into the frame of the robot
+  const double dx = itarget.x - ipose.x;
+  const double dy = itarget.y - ipose.y;
+  const double errorX = std::cos(ipose.heading) * dx + std::sin(ipose.heading) * dy;
+  const double errorY = -std::sin(ipose.heading) * dx + std::cos(ipose.heading) * dy;
+  const double errorHeading = std::remainder(itarget.heading - ipose.heading, 2 * pi);
+
+  const double k = 2 * gains.zeta * std::sqrt(iangular * iangular + gains.b * ilinear * ilinear);
+
+  // sin(x) / x goes to 1 as x goes to 0
+  const double sinc = std::abs(errorHeading) < 1e-9 ? 1.0 : std::sin(errorHeading) / errorHeading;
+
+  return Output{ilinear * std::cos(errorHeading) + k * errorX,
+                iangular + k * errorHeading + gains.b * ilinear * sinc * errorY};
+}
+} // namespace okapi
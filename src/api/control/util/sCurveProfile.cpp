@@ -0,0 +1,127 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/sCurveProfile.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace okapi {
+SCurveProfile::SCurveProfile() = default;
+
+SCurveProfile::SCurveProfile(const double idistance,
+                             const double imaxVel,
+                             const double imaxAccel,
+                             const double imaxJerk)
+  : distance(std::abs(idistance)),
+    sign(idistance < 0 ? -1 : 1),
+    jerk(imaxJerk > 0 ? imaxJerk : 0) {
+  if (distance == 0) {
+    return;
+  }
+
+  // Try to reach the maximum velocity first. With limited jerk, the maximum acceleration is only
+  // reached if the velocity gained while ramping the acceleration up and down fits under it.
+  peakVel = imaxVel;
+  if (jerk > 0 && imaxAccel * imaxAccel / jerk > imaxVel) {
+    jerkTime = std::sqrt(imaxVel / jerk);
+    peakAccel = jerk * jerkTime;
+  } else {
+    jerkTime = jerk > 0 ? imaxAccel / jerk : 0;
+    peakAccel = imaxAccel;
+  }
+
+  constAccelTime = peakVel / peakAccel - jerkTime;
+  accelTime = 2 * jerkTime + constAccelTime;
+
+  // The acceleration is symmetric, so the average velocity while accelerating is half the peak
+  accelDistance = peakVel * accelTime / 2;
+
+  if (2 * accelDistance > distance) {
+    // Too short to reach the maximum velocity, so find the peak velocity which covers the distance
+    // while accelerating and then immediately slowing down
+    if (jerk == 0) {
+      peakVel = std::sqrt(imaxAccel * distance);
+      jerkTime = 0;
+      peakAccel = imaxAccel;
+    } else {
+      // Solve peakVel * (peakVel / a + a / j) = distance, which holds if a is still reached
+      const double b = imaxAccel * imaxAccel / jerk;
+      peakVel = (-b + std::sqrt(b * b + 4 * imaxAccel * distance)) / 2;
+
+      if (peakVel >= b) {
+        jerkTime = imaxAccel / jerk;
+        peakAccel = imaxAccel;
+      } else {
+        // Otherwise peakVel * 2 * sqrt(peakVel / j) = distance
+        peakVel = std::cbrt(distance * distance * jerk / 4);
+        jerkTime = std::sqrt(peakVel / jerk);
+        peakAccel = jerk * jerkTime;
+      }
+    }
+
+    constAccelTime = std::max(peakVel / peakAccel - jerkTime, 0.0);
+    accelTime = 2 * jerkTime + constAccelTime;
+    accelDistance = distance / 2;
+  }
+
+  cruiseTime = (distance - 2 * accelDistance) / peakVel;
+  duration = 2 * accelTime + cruiseTime;
+}
+
+SCurveProfile::State SCurveProfile::sample(const double itime) const {
+  State state{0, 0, 0};
+
+  if (itime <= 0) {
+    return state;
+  } else if (itime >= duration) {
+    state.position = distance;
+  } else if (itime < accelTime) {
+    state = sampleAccel(itime);
+  } else if (itime < accelTime + cruiseTime) {
+    state.position = accelDistance + peakVel * (itime - accelTime);
+    state.velocity = peakVel;
+  } else {
+    // Slowing down mirrors speeding up in time
+    const State mirror = sampleAccel(duration - itime);
+    state.position = distance - mirror.position;
+    state.velocity = mirror.velocity;
+    state.acceleration = -mirror.acceleration;
+  }
+
+  state.position *= sign;
+  state.velocity *= sign;
+  state.acceleration *= sign;
+  return state;
+}
+
+SCurveProfile::State SCurveProfile::sampleAccel(const double itime) const {
+  if (itime < jerkTime) {
+    return {jerk * itime * itime * itime / 6, jerk * itime * itime / 2, jerk * itime};
+  }
+
+  const double v1 = jerk * jerkTime * jerkTime / 2;
+  const double p1 = jerk * jerkTime * jerkTime * jerkTime / 6;
+
+  if (itime < jerkTime + constAccelTime) {
+    const double t = itime - jerkTime;
+    return {p1 + v1 * t + peakAccel * t * t / 2, v1 + peakAccel * t, peakAccel};
+  }
+
+  const double t = itime - jerkTime - constAccelTime;
+  const double v2 = v1 + peakAccel * constAccelTime;
+  const double p2 = p1 + v1 * constAccelTime + peakAccel * constAccelTime * constAccelTime / 2;
+  return {p2 + v2 * t + peakAccel * t * t / 2 - jerk * t * t * t / 6,
+          v2 + peakAccel * t - jerk * t * t / 2,
+          peakAccel - jerk * t};
+}
+
+double SCurveProfile::getDuration() const {
+  return duration;
+}
+
+double SCurveProfile::getDistance() const {
+  return sign * distance;
+}
+} // namespace okapi
@@ -0,0 +1,238 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/trajectoryCache.hpp"
+#include <cinttypes>
+#include <cstring>
+#include <mutex>
+
+namespace okapi {
+namespace {
+constexpr std::uint64_t fnvOffsetBasis = 0xcbf29ce484222325ULL;
+constexpr std::uint64_t fnvPrime = 0x100000001b3ULL;
+
+// Change this whenever generation changes so trajectories from older versions are not reused
+constexpr std::uint32_t generatorVersion = 4;
+
+void hashBytes(std::uint64_t &ihash, const void *idata, const std::size_t isize) {
+  const auto *bytes = static_cast<const unsigned char *>(idata);
+  for (std::size_t i = 0; i < isize; ++i) {
+    ihash ^= bytes[i];
+    ihash *= fnvPrime;
+  }
+}
+
+void hashDouble(std::uint64_t &ihash, double ivalue) {
+  // Hash 0.0 and -0.0 the same since they generate the same trajectory
+  if (ivalue == 0) {
+    ivalue = 0;
+  }
+
+  hashBytes(ihash, &ivalue, sizeof(ivalue));
+}
+} // namespace
+
+const Segment *TrajectoryCache::Entry::side(const std::int32_t iside) const {
+  return segments.data() + static_cast<std::size_t>(iside) * header.length;
+}
+
+TrajectoryCache::TrajectoryCache(const std::size_t imaxBytes) : maxBytes(imaxBytes) {
+}
+
+std::uint64_t TrajectoryCache::makeKey(const std::vector<Waypoint> &ipoints,
+                                       const PathfinderLimits &ilimits,
+                                       const double iwheelTrack,
+                                       const double idt,
+                                       const std::int32_t isides) {
+  std::uint64_t hash = fnvOffsetBasis;
+  hashBytes(hash, &generatorVersion, sizeof(generatorVersion));
+
+  const auto count = static_cast<std::uint64_t>(ipoints.size());
+  hashBytes(hash, &count, sizeof(count));
+  for (const auto &point : ipoints) {
+    hashDouble(hash, point.x);
+    hashDouble(hash, point.y);
+    hashDouble(hash, point.angle);
+  }
+
+  hashDouble(hash, ilimits.maxVel);
+  hashDouble(hash, ilimits.maxAccel);
+  hashDouble(hash, ilimits.maxJerk);
+  hashBytes(hash, &ilimits.fit, sizeof(ilimits.fit));
+  hashDouble(hash, ilimits.maxWheelVel);
+  hashDouble(hash, ilimits.maxWheelAccel);
+  hashDouble(hash, ilimits.startVel);
+  hashDouble(hash, ilimits.endVel);
+  hashDouble(hash, ilimits.lengthTolerance);
+  hashBytes(hash, &ilimits.lengthSamples, sizeof(ilimits.lengthSamples));
+  hashDouble(hash, iwheelTrack);
+  hashDouble(hash, idt);
+  hashBytes(hash, &isides, sizeof(isides));
+
+  return hash;
+}
+
+std::shared_ptr<const TrajectoryCache::Entry> TrajectoryCache::find(const std::uint64_t ikey) {
+  std::string dir;
+
+  {
+    std::scoped_lock lock(mutex);
+    const auto it = entries.find(ikey);
+    if (it != entries.end()) {
+      recency.splice(recency.begin(), recency, it->second.position);
+      return it->second.entry;
+    }
+
+    dir = directory;
+  }
+
+  if (dir.empty()) {
+    return nullptr;
+  }
+
+  // Load outside of the lock so a slow SD card does not block other lookups
+  auto entry = load(dir, ikey);
+  if (entry) {
+    std::scoped_lock lock(mutex);
+    insertInMemory(ikey, entry);
+  }
+
+  return entry;
+}
+
+void TrajectoryCache::insert(const std::uint64_t ikey,
+                             const TrajectoryFileHeader &iheader,
+                             const Segment *const *isides) {
+  auto entry = std::make_shared<Entry>();
+  entry->header = iheader;
+  entry->segments.resize(static_cast<std::size_t>(iheader.sides) * iheader.length);
+  for (std::int32_t i = 0; i < iheader.sides; ++i) {
+    std::memcpy(entry->segments.data() + static_cast<std::size_t>(i) * iheader.length,
+                isides[i],
+                sizeof(Segment) * iheader.length);
+  }
+
+  std::string dir;
+
+  {
+    std::scoped_lock lock(mutex);
+    insertInMemory(ikey, entry);
+    dir = directory;
+  }
+
+  if (!dir.empty()) {
+    store(dir, ikey, *entry);
+  }
+}
+
+void TrajectoryCache::setDirectory(const std::string &idirectory) {
+  std::scoped_lock lock(mutex);
+  directory = idirectory;
+}
+
+void TrajectoryCache::setMaxSize(const std::size_t imaxBytes) {
+  std::scoped_lock lock(mutex);
+  maxBytes = imaxBytes;
+  evict();
+}
+
+std::size_t TrajectoryCache::getSize() {
+  std::scoped_lock lock(mutex);
+  return size;
+}
+
+void TrajectoryCache::clear() {
+  std::scoped_lock lock(mutex);
+  entries.clear();
+  recency.clear();
+  size = 0;
+}
+
+void TrajectoryCache::insertInMemory(const std::uint64_t ikey,
+                                     std::shared_ptr<const Entry> ientry) {
+  const auto it = entries.find(ikey);
+  if (it != entries.end()) {
+    size -= sizeOf(*it->second.entry);
+    recency.erase(it->second.position);
+    entries.erase(it);
+  }
+
+  size += sizeOf(*ientry);
+  recency.push_front(ikey);
+  entries.emplace(ikey, Slot{std::move(ientry), recency.begin()});
+  evict();
+}
+
+void TrajectoryCache::evict() {
+  while (size > maxBytes && !recency.empty()) {
+    const auto it = entries.find(recency.back());
+    size -= sizeOf(*it->second.entry);
+    entries.erase(it);
+    recency.pop_back();
+  }
+}
+
+std::string TrajectoryCache::makeFilePath(const std::string &idirectory, const std::uint64_t ikey) {
+  char name[32];
+  snprintf(name, sizeof(name), "/%016" PRIx64 ".traj", ikey);
+  return idirectory + name;
+}
+
+std::shared_ptr<const TrajectoryCache::Entry>
+TrajectoryCache::load(const std::string &idirectory, const std::uint64_t ikey) {
+  FILE *file = fopen(makeFilePath(idirectory, ikey).c_str(), "rb");
+  if (file == nullptr) {
+    return nullptr;
+  }
+
+  auto entry = std::make_shared<Entry>();
+  bool success = readTrajectoryFileHeader(file, entry->header);
+  if (success) {
+    entry->segments.resize(static_cast<std::size_t>(entry->header.sides) * entry->header.length);
+
+    std::vector<Segment *> sides;
+    for (std::int32_t i = 0; i < entry->header.sides; ++i) {
+      sides.push_back(entry->segments.data() + static_cast<std::size_t>(i) * entry->header.length);
+    }
+
+    success = readTrajectoryFileSegments(file, entry->header, sides.data());
+  }
+
+  fclose(file);
+
+  if (!success) {
+    return nullptr;
+  }
+
+  return entry;
+}
+
+void TrajectoryCache::store(const std::string &idirectory,
+                            const std::uint64_t ikey,
+                            const Entry &ientry) {
+  const std::string path = makeFilePath(idirectory, ikey);
+  FILE *file = fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    return;
+  }
+
+  std::vector<const Segment *> sides;
+  for (std::int32_t i = 0; i < ientry.header.sides; ++i) {
+    sides.push_back(ientry.side(i));
+  }
+
+  const bool success = writeTrajectoryFile(file, ientry.header, sides.data());
+  fclose(file);
+
+  // Don't leave a truncated file behind, it would be rejected on every lookup
+  if (!success) {
+    remove(path.c_str());
+  }
+}
+
+std::size_t TrajectoryCache::sizeOf(const Entry &ientry) {
+  return ientry.segments.size() * sizeof(Segment);
+}
+} // namespace okapi
@@ -0,0 +1,37 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/trajectoryFollower.hpp"
+#include <algorithm>
+
+namespace okapi {
+TrajectoryFollower::TrajectoryFollower(const Gains &igains) : gains(igains) {
+}
+
+double TrajectoryFollower::step(const double itargetVelocity,
+                                const double itargetAcceleration,
+                                const double iposition,
+                                const double idt) {
+  targetPosition += itargetVelocity * idt;
+  error = targetPosition - iposition;
+
+  const double friction =
+    itargetVelocity > 0 ? gains.kS : (itargetVelocity < 0 ? -gains.kS : 0);
+
+  return std::clamp(friction + gains.kV * itargetVelocity + gains.kA * itargetAcceleration +
+                      gains.kP * error,
+                    -1.0,
+                    1.0);
+}
+
+double TrajectoryFollower::getError() const {
+  return error;
+}
+
+void TrajectoryFollower::reset() {
+  targetPosition = 0;
+  error = 0;
+}
+} // namespace okapi
@@ -0,0 +1,296 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/util/binaryLog.hpp"
+#include <cinttypes>
+#include <cstring>
+
+namespace okapi {
+std::string formatLogMessage(std::string_view iformat, const std::vector<std::string> &iargs) {
+  std::string message;
+  std::size_t arg = 0;
+
+  for (std::size_t i = 0; i < iformat.size(); ++i) {
+    if (arg < iargs.size() && iformat[i] == '{' && i + 1 < iformat.size() &&
+        iformat[i + 1] == '}') {
+      message += iargs[arg++];
+      ++i;
+    } else {
+      message += iformat[i];
+    }
+  }
+
+  for (; arg < iargs.size(); ++arg) {
+    message += " " + iargs[arg];
+  }
+
+  return message;
+}
+
+BinaryLogWriter::BinaryLogWriter(std::uint8_t *odata, const std::size_t icapacity) noexcept
+  : data(odata), capacity(icapacity) {
+}
+
+void BinaryLogWriter::putU8(const std::uint8_t ivalue) noexcept {
+  putBytes(&ivalue, 1);
+}
+
+void BinaryLogWriter::putU16(const std::uint16_t ivalue) noexcept {
+  const std::uint8_t bytes[] = {static_cast<std::uint8_t>(ivalue),
+                                static_cast<std::uint8_t>(ivalue >> 8)};
+  putBytes(bytes, sizeof(bytes));
+}
+
+void BinaryLogWriter::putU32(const std::uint32_t ivalue) noexcept {
+  putU16(static_cast<std::uint16_t>(ivalue));
+  putU16(static_cast<std::uint16_t>(ivalue >> 16));
+}
+
+void BinaryLogWriter::putU64(const std::uint64_t ivalue) noexcept {
+  putU32(static_cast<std::uint32_t>(ivalue));
+  putU32(static_cast<std::uint32_t>(ivalue >> 32));
+}
+
+void BinaryLogWriter::putBytes(const void *idata, const std::size_t isize) noexcept {
+  if (!valid || length + isize > capacity) {
+    valid = false;
+    return;
+  }
+
+  memcpy(data + length, idata, isize);
+  length += isize;
+}
+
+void BinaryLogWriter::putFloat(const float ivalue) noexcept {
+  std::uint32_t bits;
+  memcpy(&bits, &ivalue, sizeof(bits));
+  putU32(bits);
+}
+
+void BinaryLogWriter::putDouble(const double ivalue) noexcept {
+  std::uint64_t bits;
+  memcpy(&bits, &ivalue, sizeof(bits));
+  putU64(bits);
+}
+
+std::size_t BinaryLogWriter::size() const noexcept {
+  return length;
+}
+
+bool BinaryLogWriter::isValid() const noexcept {
+  return valid;
+}
+
+BinaryLogDecoder::BinaryLogDecoder() {
+  formats[binaryLogTextFormat] = "{}";
+}
+
+bool BinaryLogDecoder::decode(FILE *iin, FILE *iout) {
+  int tag;
+  while ((tag = fgetc(iin)) != EOF) {
+    if (!decodeBlock(iin, iout, static_cast<std::uint8_t>(tag))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool BinaryLogDecoder::decodeBlock(FILE *iin, FILE *iout, const std::uint8_t itag) {
+  switch (static_cast<BinaryLogBlock>(itag)) {
+  case BinaryLogBlock::header: {
+    char magic[4];
+    std::uint8_t version;
+    if (!readBytes(iin, magic, sizeof(magic)) || memcmp(magic, "OKLG", sizeof(magic)) != 0 ||
+        !readU8(iin, version) || version != binaryLogVersion) {
+      return false;
+    }
+
+    // The logger was opened again, so every ID starts over
+    formats.clear();
+    formats[binaryLogTextFormat] = "{}";
+    threads.clear();
+    lastTime = 0;
+    wraps = 0;
+    return true;
+  }
+
+  case BinaryLogBlock::format: {
+    std::uint16_t id;
+    std::uint16_t length;
+    return readU16(iin, id) && readU16(iin, length) && readString(iin, length, formats[id]);
+  }
+
+  case BinaryLogBlock::thread: {
+    std::uint8_t id;
+    std::uint8_t length;
+    return readU8(iin, id) && readU8(iin, length) && readString(iin, length, threads[id]);
+  }
+
+  case BinaryLogBlock::record: {
+    std::uint8_t level;
+    std::uint32_t time;
+    std::uint16_t format;
+    std::uint8_t thread;
+    std::uint8_t count;
+    if (!readU8(iin, level) || !readU32(iin, time) || !readU16(iin, format) ||
+        !readU8(iin, thread) || !readU8(iin, count)) {
+      return false;
+    }
+
+    std::vector<std::string> args(count);
+    for (auto &arg : args) {
+      if (!readArg(iin, arg)) {
+        return false;
+      }
+    }
+
+    // Tasks can log slightly out of order, so only a large step back is a wrap
+    if (time < lastTime && lastTime - time > 0x80000000u) {
+      ++wraps;
+    }
+    lastTime = time;
+    const std::uint64_t micros = (wraps << 32) + time;
+
+    static const char *const levelNames[] = {"OFF", "ERROR", "WARN", "INFO", "DEBUG"};
+    const auto formatIt = formats.find(format);
+    const auto threadIt = threads.find(thread);
+
+    fprintf(iout,
+            "%" PRIu64 ".%03u (%s) %s: %s\n",
+            micros / 1000,
+            static_cast<unsigned>(micros % 1000),
+            threadIt == threads.end() ? "unknown" : threadIt->second.c_str(),
+            level < sizeof(levelNames) / sizeof(levelNames[0]) ? levelNames[level] : "UNKNOWN",
+            formatLogMessage(formatIt == formats.end() ? "<unknown format>" : formatIt->second,
+                             args)
+              .c_str());
+    return true;
+  }
+
+  case BinaryLogBlock::dropped: {
+    std::uint32_t count;
+    if (!readU32(iin, count)) {
+      return false;
+    }
+
+    fprintf(iout, "Dropped %" PRIu32 " log statements because the buffer was full\n", count);
+    return true;
+  }
+  }
+
+  return false;
+}
+
+bool BinaryLogDecoder::readArg(FILE *iin, std::string &oarg) {
+  std::uint8_t type;
+  if (!readU8(iin, type)) {
+    return false;
+  }
+
+  switch (static_cast<BinaryLogArg>(type)) {
+  case BinaryLogArg::int32: {
+    std::uint32_t value;
+    if (!readU32(iin, value)) {
+      return false;
+    }
+    oarg = std::to_string(static_cast<std::int32_t>(value));
+    return true;
+  }
+
+  case BinaryLogArg::int64: {
+    std::uint64_t value;
+    if (!readU64(iin, value)) {
+      return false;
+    }
+    oarg = std::to_string(static_cast<std::int64_t>(value));
+    return true;
+  }
+
+  case BinaryLogArg::float32: {
+    std::uint32_t bits;
+    if (!readU32(iin, bits)) {
+      return false;
+    }
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    oarg = logArgToString(value);
+    return true;
+  }
+
+  case BinaryLogArg::float64: {
+    std::uint64_t bits;
+    if (!readU64(iin, bits)) {
+      return false;
+    }
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    oarg = logArgToString(value);
+    return true;
+  }
+
+  case BinaryLogArg::boolean: {
+    std::uint8_t value;
+    if (!readU8(iin, value)) {
+      return false;
+    }
+    oarg = logArgToString(value != 0);
+    return true;
+  }
+
+  case BinaryLogArg::string: {
+    std::uint16_t length;
+    return readU16(iin, length) && readString(iin, length, oarg);
+  }
+  }
+
+  return false;
+}
+
+bool BinaryLogDecoder::readBytes(FILE *iin, void *odata, const std::size_t isize) {
+  return fread(odata, 1, isize, iin) == isize;
+}
+
+bool BinaryLogDecoder::readU8(FILE *iin, std::uint8_t &ovalue) {
+  return readBytes(iin, &ovalue, 1);
+}
+
+bool BinaryLogDecoder::readU16(FILE *iin, std::uint16_t &ovalue) {
+  std::uint8_t bytes[2];
+  if (!readBytes(iin, bytes, sizeof(bytes))) {
+    return false;
+  }
+
+  ovalue = static_cast<std::uint16_t>(bytes[0] | (bytes[1] << 8));
+  return true;
+}
+
+bool BinaryLogDecoder::readU32(FILE *iin, std::uint32_t &ovalue) {
+  std::uint16_t low;
+  std::uint16_t high;
+  if (!readU16(iin, low) || !readU16(iin, high)) {
+    return false;
+  }
+
+  ovalue = low | (static_cast<std::uint32_t>(high) << 16);
+  return true;
+}
+
+bool BinaryLogDecoder::readU64(FILE *iin, std::uint64_t &ovalue) {
+  std::uint32_t low;
+  std::uint32_t high;
+  if (!readU32(iin, low) || !readU32(iin, high)) {
+    return false;
+  }
+
+  ovalue = low | (static_cast<std::uint64_t>(high) << 32);
+  return true;
+}
+
+bool BinaryLogDecoder::readString(FILE *iin, const std::size_t ilength, std::string &ovalue) {
+  ovalue.resize(ilength);
+  return ilength == 0 || readBytes(iin, &ovalue[0], ilength);
+}
+} // namespace okapi
@@ -0,0 +1,44 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/util/logRingBuffer.hpp"
+#include <new>
+
+namespace okapi {
+LogRingBuffer::LogRingBuffer(const std::size_t icapacity) noexcept {
+  std::size_t capacity = 1;
+  while (capacity < icapacity) {
+    capacity <<= 1;
+  }
+
+  cells.reset(new (std::nothrow) Cell[capacity]);
+  if (!cells) {
+    return;
+  }
+
+  mask = capacity - 1;
+  for (std::size_t i = 0; i < capacity; ++i) {
+    cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+bool LogRingBuffer::tryPop(LogRecord &orecord) noexcept {
+  Cell &cell = cells[dequeuePos & mask];
+  if (cell.sequence.load(std::memory_order_acquire) != dequeuePos + 1) {
+    return false;
+  }
+
+  orecord = cell.record;
+
+  // Free the cell for the writer one lap ahead
+  cell.sequence.store(dequeuePos + mask + 1, std::memory_order_release);
+  ++dequeuePos;
+  return true;
+}
+
+std::size_t LogRingBuffer::getCapacity() const noexcept {
+  return cells ? mask + 1 : 0;
+}
+} // namespace okapi
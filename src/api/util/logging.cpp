@@ -4,8 +4,53 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 #include "okapi/api/util/logging.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(THREADS_STD)
+#include <chrono>
+#include <thread>
+#endif
 
 namespace okapi {
+namespace {
+#if defined(THREADS_STD)
+constexpr std::uint32_t writerPriority = 0;
+#else
+// Just above the idle task, so the writer only runs when nothing more important does
+constexpr std::uint32_t writerPriority = TASK_PRIORITY_MIN + 1;
+#endif
+
+void sleepMillis(const std::uint32_t ims) {
+#if defined(THREADS_STD)
+  std::this_thread::sleep_for(std::chrono::milliseconds(ims));
+#else
+  pros::c::delay(ims);
+#endif
+}
+
+// Copies as much of a string as fits, always leaving room for the terminator
+template <std::size_t N> void copyTruncated(char (&odest)[N], std::string_view isrc) {
+  const std::size_t length = std::min(isrc.size(), N - 1);
+  memcpy(odest, isrc.data(), length);
+  odest[length] = '\0';
+}
+
+// Adds a record to a buffer, waiting for room if iblock is set. Returns false if it was dropped.
+template <typename F> bool pushRecord(LogRingBuffer &ibuffer, F &&ifill, const bool iblock) {
+  while (!ibuffer.tryPush(ifill)) {
+    if (!iblock) {
+      return false;
+    }
+
+    // A delay instead of a yield so the lower priority writer task gets to run
+    sleepMillis(1);
+  }
+
+  return true;
+}
+} // namespace
+
 std::shared_ptr<Logger> defaultLogger;
 
 int DefaultLoggerInitializer::count;
@@ -15,25 +60,272 @@ Logger::Logger() noexcept : Logger(nullptr, nullptr, LogLevel::off) {
 
 Logger::Logger(std::unique_ptr<AbstractTimer> itimer,
                std::string_view ifileName,
-               const Logger::LogLevel &ilevel) noexcept
+               const Logger::LogLevel &ilevel,
+               const Encoding iencoding) noexcept
   : Logger(std::move(itimer),
            fopen(ifileName.data(), isSerialStream(ifileName) ? "w" : "a"),
-           ilevel) {
+           ilevel,
+           iencoding) {
 }
 
 Logger::Logger(std::unique_ptr<AbstractTimer> itimer,
                FILE *const ifile,
-               const Logger::LogLevel &ilevel) noexcept
-  : timer(std::move(itimer)), logLevel(ilevel), logfile(ifile) {
+               const Logger::LogLevel &ilevel,
+               const Encoding iencoding) noexcept
+  : timer(std::move(itimer)), logLevel(ilevel), logfile(ifile), encoding(iencoding) {
+  writeHeader();
+}
+
+Logger::Logger(std::unique_ptr<AbstractTimer> itimer,
+               std::string_view ifileName,
+               const Logger::LogLevel &ilevel,
+               const AsyncOptions &iasync,
+               const Encoding iencoding) noexcept
+  : Logger(std::move(itimer),
+           fopen(ifileName.data(), isSerialStream(ifileName) ? "w" : "a"),
+           ilevel,
+           iasync,
+           iencoding) {
+}
+
+Logger::Logger(std::unique_ptr<AbstractTimer> itimer,
+               FILE *const ifile,
+               const Logger::LogLevel &ilevel,
+               const AsyncOptions &iasync,
+               const Encoding iencoding) noexcept
+  : timer(std::move(itimer)),
+    logLevel(ilevel),
+    logfile(ifile),
+    overflow(iasync.overflow),
+    encoding(iencoding) {
+  if (!logfile || !timer || logLevel == LogLevel::off) {
+    // Nothing will be logged, so there is nothing for a writer task to do
+    return;
+  }
+
+  // Written before the writer task starts, so it is always first
+  writeHeader();
+
+  buffer.reset(new (std::nothrow) LogRingBuffer(iasync.capacity));
+  if (buffer && buffer->getCapacity() == 0) {
+    buffer.reset();
+  }
+
+  if (buffer) {
+    writer = new CrossplatformThread(writerTrampoline, this, "OkapiLib Logger", writerPriority);
+  }
 }
 
 Logger::~Logger() {
+  close();
+}
+
+bool Logger::isAsync() const noexcept {
+  return buffer != nullptr;
+}
+
+void Logger::close() noexcept {
+  stopWriter();
+
   if (logfile) {
     fclose(logfile);
     logfile = nullptr;
   }
 }
 
+void Logger::enqueue(const char *ilevel,
+                     const long itime,
+                     std::string_view ithread,
+                     std::string_view imessage) noexcept {
+  const auto fill = [&](LogRecord &record) {
+    record.time = itime;
+    record.level = ilevel;
+    copyTruncated(record.thread, ithread);
+    copyTruncated(record.message, imessage);
+    record.length = 0;
+  };
+
+  if (!pushRecord(*buffer, fill, overflow == Overflow::block)) {
+    droppedCount.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void Logger::writeBlock(const std::uint8_t *idata,
+                        const std::size_t isize,
+                        const bool iblock) noexcept {
+  if (!buffer) {
+    std::scoped_lock lock(logfileMutex);
+    fwrite(idata, 1, isize, logfile);
+    return;
+  }
+
+  const auto fill = [&](LogRecord &record) {
+    memcpy(record.message, idata, isize);
+    record.length = static_cast<std::uint16_t>(isize);
+  };
+
+  if (!pushRecord(*buffer, fill, iblock || overflow == Overflow::block)) {
+    droppedCount.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void Logger::writeHeader() noexcept {
+  if (encoding != Encoding::binary || !logfile) {
+    return;
+  }
+
+  const std::uint8_t header[] = {
+    static_cast<std::uint8_t>(BinaryLogBlock::header), 'O', 'K', 'L', 'G', binaryLogVersion};
+  fwrite(header, 1, sizeof(header), logfile);
+}
+
+std::uint16_t Logger::registerFormat(std::string_view iformat) noexcept {
+  std::scoped_lock lock(internMutex);
+  const auto id = static_cast<std::uint16_t>(formats.size());
+  formats.emplace_back(iformat);
+
+  if (encoding == Encoding::binary && logfile && timer) {
+    std::uint8_t data[sizeof(LogRecord::message)];
+    BinaryLogWriter block(data, sizeof(data));
+    block.putU8(static_cast<std::uint8_t>(BinaryLogBlock::format));
+    block.putU16(id);
+
+    // Cut the format short to fit in one block
+    const auto length = static_cast<std::uint16_t>(std::min(iformat.size(), sizeof(data) - 5));
+    block.putU16(length);
+    block.putBytes(iformat.data(), length);
+    writeBlock(data, block.size(), true);
+  }
+
+  return id;
+}
+
+std::string Logger::getFormat(const std::uint16_t iformat) noexcept {
+  std::scoped_lock lock(internMutex);
+  return iformat < formats.size() ? formats[iformat] : std::string();
+}
+
+std::uint8_t Logger::getThreadId() noexcept {
+  const std::string_view name = CrossplatformThread::getCurrentName();
+
+  const auto find = [&](const ThreadName *inode) -> const ThreadName * {
+    for (; inode != nullptr; inode = inode->next.get()) {
+      if (inode->name == name) {
+        return inode;
+      }
+    }
+    return nullptr;
+  };
+
+  if (const auto node = find(threadNames.load(std::memory_order_acquire))) {
+    return node->id;
+  }
+
+  // Another task may have added this name while this one was searching
+  std::scoped_lock lock(internMutex);
+  if (const auto node = find(threadNameList.get())) {
+    return node->id;
+  }
+
+  // Every task after the first 255 shares the last ID, which has no name
+  const std::size_t count = threadNameList ? threadNameList->id + 1 : 0;
+  if (count >= 0xff) {
+    return 0xff;
+  }
+
+  const auto id = static_cast<std::uint8_t>(count);
+  threadNameList = std::make_unique<const ThreadName>(
+    ThreadName{std::string(name), id, std::move(threadNameList)});
+  threadNames.store(threadNameList.get(), std::memory_order_release);
+
+  std::uint8_t data[sizeof(LogRecord::message)];
+  BinaryLogWriter block(data, sizeof(data));
+  block.putU8(static_cast<std::uint8_t>(BinaryLogBlock::thread));
+  block.putU8(id);
+  const auto length = static_cast<std::uint8_t>(std::min<std::size_t>(name.size(), 0xff));
+  block.putU8(length);
+  block.putBytes(name.data(), length);
+  writeBlock(data, block.size(), true);
+
+  return id;
+}
+
+std::uint32_t Logger::getMicros() const noexcept {
+  return static_cast<std::uint32_t>(
+    static_cast<std::uint64_t>(timer->millis().convert(millisecond) * 1000));
+}
+
+void Logger::stopWriter() noexcept {
+  if (!writer) {
+    return;
+  }
+
+  writerStop.store(true, std::memory_order_release);
+
+  // Deleting the task on the brain does not wait for it, so wait for it to finish writing first
+  while (!writerDone.load(std::memory_order_acquire)) {
+    sleepMillis(1);
+  }
+
+  delete writer;
+  writer = nullptr;
+}
+
+void Logger::writerTrampoline(void *context) {
+  if (context) {
+    static_cast<Logger *>(context)->writerLoop();
+  }
+}
+
+void Logger::writerLoop() noexcept {
+  LogRecord record;
+
+  while (true) {
+    // Check before draining so every statement logged before the logger stopped gets written
+    const bool stopping = writerStop.load(std::memory_order_acquire);
+    bool wrote = false;
+
+    while (buffer->tryPop(record)) {
+      if (record.length > 0) {
+        fwrite(record.message, 1, record.length, logfile);
+      } else {
+        fprintf(
+          logfile, "%ld (%s) %s: %s\n", record.time, record.thread, record.level, record.message);
+      }
+      wrote = true;
+    }
+
+    const std::size_t dropped = droppedCount.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0 && encoding == Encoding::binary) {
+      std::uint8_t data[5];
+      BinaryLogWriter block(data, sizeof(data));
+      block.putU8(static_cast<std::uint8_t>(BinaryLogBlock::dropped));
+      block.putU32(static_cast<std::uint32_t>(dropped));
+      fwrite(data, 1, block.size(), logfile);
+      wrote = true;
+    } else if (dropped > 0) {
+      fprintf(logfile,
+              "%ld (OkapiLib Logger) WARN: Dropped %lu log statements because the buffer was "
+              "full\n",
+              static_cast<long>(timer->millis().convert(millisecond)),
+              static_cast<unsigned long>(dropped));
+      wrote = true;
+    }
+
+    if (wrote) {
+      fflush(logfile);
+    }
+
+    if (stopping) {
+      break;
+    }
+
+    sleepMillis(5);
+  }
+
+  writerDone.store(true, std::memory_order_release);
+}
+
 std::shared_ptr<Logger> Logger::getDefaultLogger() {
   return defaultLogger;
 }
@@ -0,0 +1,125 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/util/loopStats.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace okapi {
+LoopStats::LoopStats(std::string iname, std::unique_ptr<AbstractTimer> itimer)
+  : name(std::move(iname)), timer(std::move(itimer)) {
+}
+
+void LoopStats::setEnabled(const bool ienabled) noexcept {
+  enabled.store(ienabled && timer, std::memory_order_release);
+}
+
+bool LoopStats::isEnabled() const noexcept {
+  return enabled.load(std::memory_order_acquire);
+}
+
+void LoopStats::delayUntil(AbstractRate &irate, const QTime iperiod) {
+  if (!enabled.load(std::memory_order_relaxed)) {
+    // Start over when measuring is turned back on so the time spent off isn't counted
+    hasLastWake = false;
+    irate.delayUntil(iperiod);
+    return;
+  }
+
+  const QTime end = timer->millis();
+  irate.delayUntil(iperiod);
+  const QTime wake = timer->millis();
+
+  if (hasLastWake) {
+    record(end - lastWake, iperiod, wake - lastWake);
+  }
+
+  lastWake = wake;
+  hasLastWake = true;
+}
+
+void LoopStats::record(const QTime iduration,
+                       const QTime iperiod,
+                       const QTime iactualPeriod) noexcept {
+  const std::uint32_t duration = toMicros(iduration);
+  const std::uint32_t jitter = toMicros(abs(iactualPeriod - iperiod));
+
+  iterations.fetch_add(1, std::memory_order_relaxed);
+  if (iduration >= iperiod) {
+    overruns.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  totalDuration.fetch_add(duration, std::memory_order_relaxed);
+  totalJitter.fetch_add(jitter, std::memory_order_relaxed);
+
+  // Only this task writes the maximums, so they don't need a compare and swap
+  if (duration > maxDuration.load(std::memory_order_relaxed)) {
+    maxDuration.store(duration, std::memory_order_relaxed);
+  }
+  if (jitter > maxJitter.load(std::memory_order_relaxed)) {
+    maxJitter.store(jitter, std::memory_order_relaxed);
+  }
+
+  const std::size_t bucket = std::min<std::size_t>(duration / 1000, histogramSize - 1);
+  histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+LoopStats::Summary LoopStats::getSummary() const noexcept {
+  Summary summary;
+  summary.iterations = iterations.load(std::memory_order_relaxed);
+  summary.overruns = overruns.load(std::memory_order_relaxed);
+
+  if (summary.iterations > 0) {
+    summary.meanDuration =
+      totalDuration.load(std::memory_order_relaxed) / summary.iterations / 1000.0 * millisecond;
+    summary.meanJitter =
+      totalJitter.load(std::memory_order_relaxed) / summary.iterations / 1000.0 * millisecond;
+  }
+
+  summary.maxDuration = maxDuration.load(std::memory_order_relaxed) / 1000.0 * millisecond;
+  summary.maxJitter = maxJitter.load(std::memory_order_relaxed) / 1000.0 * millisecond;
+
+  for (std::size_t i = 0; i < histogramSize; ++i) {
+    summary.histogram[i] = histogram[i].load(std::memory_order_relaxed);
+  }
+
+  return summary;
+}
+
+void LoopStats::reset() noexcept {
+  iterations.store(0, std::memory_order_relaxed);
+  overruns.store(0, std::memory_order_relaxed);
+  totalDuration.store(0, std::memory_order_relaxed);
+  maxDuration.store(0, std::memory_order_relaxed);
+  totalJitter.store(0, std::memory_order_relaxed);
+  maxJitter.store(0, std::memory_order_relaxed);
+
+  for (auto &bucket : histogram) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+void LoopStats::log(const std::shared_ptr<Logger> &logger) const {
+  const Summary summary = getSummary();
+
+  std::string buckets;
+  for (std::size_t i = 0; i < histogramSize; ++i) {
+    buckets += (i == 0 ? "" : " ") + std::to_string(summary.histogram[i]);
+  }
+
+  LOG_INFO(name + ": " + std::to_string(summary.iterations) + " iterations, " +
+           std::to_string(summary.overruns) + " overruns, duration mean " +
+           std::to_string(summary.meanDuration.convert(millisecond)) + " ms max " +
+           std::to_string(summary.maxDuration.convert(millisecond)) + " ms, jitter mean " +
+           std::to_string(summary.meanJitter.convert(millisecond)) + " ms max " +
+           std::to_string(summary.maxJitter.convert(millisecond)) +
+           " ms, iterations by duration in ms: " + buckets);
+}
+
+std::uint32_t LoopStats::toMicros(const QTime itime) noexcept {
+  // A timer which goes backwards would otherwise wrap around to a huge duration
+  return static_cast<std::uint32_t>(std::lround(std::max(0.0, itime.convert(millisecond) * 1000)));
+}
+} // namespace okapi
@@ -212,6 +212,17 @@ ChassisControllerBuilder::withGains(const IterativePosPIDController::Gains &idis
   return *this;
 }
 
+ChassisControllerBuilder &
+ChassisControllerBuilder::withTurnProfile(const QAngularSpeed imaxVel,
+                                          const QAngularAcceleration imaxAccel,
+                                          const QAngularJerk imaxJerk) {
+  hasTurnProfile = true;
+  turnMaxVel = imaxVel;
+  turnMaxAccel = imaxAccel;
+  turnMaxJerk = imaxJerk;
+  return *this;
+}
+
 ChassisControllerBuilder &
 ChassisControllerBuilder::withDerivativeFilters(std::unique_ptr<Filter> idistanceFilter,
                                                 std::unique_ptr<Filter> iturnFilter,
@@ -432,6 +443,10 @@ std::shared_ptr<ChassisControllerPID> ChassisControllerBuilder::buildCCPID() {
     driveScales,
     controllerLogger);
 
+  if (hasTurnProfile) {
+    out->setTurnProfile(turnMaxVel, turnMaxAccel, turnMaxJerk);
+  }
+
   out->startThread();
 
   if (isParentedToCurrentTask && NOT_INITIALIZE_TASK && NOT_COMP_INITIALIZE_TASK) {
@@ -68,6 +68,22 @@ AsyncMotionProfileControllerBuilder::withLimits(const PathfinderLimits &ilimits)
   return *this;
 }
 
+AsyncMotionProfileControllerBuilder &
+AsyncMotionProfileControllerBuilder::withTurnLimits(const PathfinderLimits &iturnLimits) {
+  hasTurnLimits = true;
+  turnLimits = iturnLimits;
+  return *this;
+}
+
+AsyncMotionProfileControllerBuilder &
+AsyncMotionProfileControllerBuilder::withFollowerGains(const TrajectoryFollower::Gains &igains,
+                                                       const QTime iperiod) {
+  hasFollowerGains = true;
+  followerGains = igains;
+  followerPeriod = iperiod;
+  return *this;
+}
+
 AsyncMotionProfileControllerBuilder &
 AsyncMotionProfileControllerBuilder::withTimeUtilFactory(const TimeUtilFactory &itimeUtilFactory) {
   timeUtilFactory = itimeUtilFactory;
@@ -132,6 +148,43 @@ AsyncMotionProfileControllerBuilder::buildMotionProfileController() {
 
   auto out = std::make_shared<AsyncMotionProfileController>(
     timeUtilFactory.create(), limits, model, scales, pair, controllerLogger);
+
+  if (hasFollowerGains) {
+    out->setFollowerGains(followerGains, followerPeriod);
+  }
+
+  out->startThread();
+
+  if (isParentedToCurrentTask && NOT_INITIALIZE_TASK && NOT_COMP_INITIALIZE_TASK) {
+    out->getThread()->notifyWhenDeletingRaw(pros::c::task_get_current());
+  }
+
+  return out;
+}
+
+std::shared_ptr<AsyncHolonomicMotionProfileController>
+AsyncMotionProfileControllerBuilder::buildHolonomicMotionProfileController() {
+  if (!hasModel) {
+    std::string msg("AsyncMotionProfileControllerBuilder: No model given.");
+    LOG_ERROR(msg);
+    throw std::runtime_error(msg);
+  }
+
+  const auto xModel = std::dynamic_pointer_cast<XDriveModel>(model);
+  if (!xModel) {
+    std::string msg("AsyncMotionProfileControllerBuilder: The model must be an XDriveModel.");
+    LOG_ERROR(msg);
+    throw std::runtime_error(msg);
+  }
+
+  if (!hasLimits || !hasTurnLimits) {
+    std::string msg("AsyncMotionProfileControllerBuilder: No limits or turn limits given.");
+    LOG_ERROR(msg);
+    throw std::runtime_error(msg);
+  }
+
+  auto out = std::make_shared<AsyncHolonomicMotionProfileController>(
+    timeUtilFactory.create(), limits, turnLimits, xModel, scales, pair, controllerLogger);
   out->startThread();
 
   if (isParentedToCurrentTask && NOT_INITIALIZE_TASK && NOT_COMP_INITIALIZE_TASK) {
@@ -26,6 +26,56 @@ void pf_fit_hermite_quintic(Waypoint a, Waypoint b, Spline *s) {
     (*s).d = 0; (*s).e = a0_delta;
 }
 
+void pf_fit_hermite_quintic_curvature(Waypoint a, Waypoint b, double a_curvature, double b_curvature, Spline *s) {
+    pf_fit_hermite_pre(a, b, s);
+    
+    double a0_delta = tan(bound_radians(a.angle - (*s).angle_offset));
+    double a1_delta = tan(bound_radians(b.angle - (*s).angle_offset));
+    
+    // Second derivatives which give the requested curvatures with these slopes
+    double a0_second = a_curvature * pow(1 + a0_delta * a0_delta, 1.5);
+    double a1_second = b_curvature * pow(1 + a1_delta * a1_delta, 1.5);
+    
+    double d = (*s).knot_distance;
+    
+    (*s).e = a0_delta;
+    (*s).d = a0_second / 2;
+    
+    // Solve for the rest so the spline ends at b with the requested slope and second derivative
+    double r0 = -((*s).d * d * d + (*s).e * d);
+    double r1 = d * (a1_delta - 2 * (*s).d * d - (*s).e);
+    double r2 = d * d * (a1_second - 2 * (*s).d);
+    
+    double a5 = (r2 + 12 * r0 - 6 * r1) / 2;
+    double b4 = r1 - 3 * r0 - 2 * a5;
+    double c3 = r0 - a5 - b4;
+    
+    (*s).a = a5 / (d*d*d*d*d);
+    (*s).b = b4 / (d*d*d*d);
+    (*s).c = c3 / (d*d*d);
+}
+
+void pf_fit_hermite_curvature_continuous(Waypoint *path, int path_length, Spline *splines) {
+    int i;
+    
+    // Cubic splines give a reasonable estimate of the curvature at each waypoint
+    for (i = 0; i < path_length - 1; i++) {
+        pf_fit_hermite_cubic(path[i], path[i + 1], &splines[i]);
+    }
+    
+    // Start and end straight. Each inner waypoint gets the average curvature of its cubic splines.
+    double start_curvature = 0;
+    for (i = 0; i < path_length - 1; i++) {
+        double end_curvature = 0;
+        if (i < path_length - 2) {
+            end_curvature = (pf_spline_curvature(splines[i], 1) + pf_spline_curvature(splines[i + 1], 0)) / 2;
+        }
+        
+        pf_fit_hermite_quintic_curvature(path[i], path[i + 1], start_curvature, end_curvature, &splines[i]);
+        start_curvature = end_curvature;
+    }
+}
+
 void pf_fit_hermite_pre(Waypoint a, Waypoint b, Spline *s) {
     (*s).x_offset = a.x;
     (*s).y_offset = a.y;
@@ -6,22 +6,44 @@ int pathfinder_prepare(Waypoint *path, int path_length, void (*fit)(Waypoint,Way
         double max_velocity, double max_acceleration, double max_jerk, TrajectoryCandidate *cand) {
     if (path_length < 2) return -1;
     
-    cand->saptr = malloc((path_length - 1) * sizeof(Spline));
-    cand->laptr = malloc((path_length - 1) * sizeof(double));
+    return pathfinder_prepare_into(path, path_length, fit, sample_count, dt, max_velocity,
+        max_acceleration, max_jerk, cand, malloc((path_length - 1) * sizeof(Spline)),
+        malloc((path_length - 1) * sizeof(double)));
+}
+
+// A positive tolerance measures splines with Gauss-Kronrod quadrature instead of samples. With
+// reuse_lengths set, splines which already have a positive length are not measured again.
+static int prepare(Waypoint *path, int path_length, void (*fit)(Waypoint,Waypoint,Spline*), int sample_count, double tolerance,
+        double dt, double max_velocity, double max_acceleration, double max_jerk, TrajectoryCandidate *cand,
+        Spline *splines, double *spline_lengths, int reuse_lengths) {
+    if (path_length < 2) return -1;
+    
+    cand->saptr = splines;
+    cand->laptr = spline_lengths;
     double totalLength = 0;
     
     int i;
     for (i = 0; i < path_length-1; i++) {
         Spline s;
-        fit(path[i], path[i+1], &s);
-        double dist = pf_spline_distance(&s, sample_count);
+        if (fit) {
+            fit(path[i], path[i+1], &s);
+        } else {
+            // The caller already fitted the splines
+            s = splines[i];
+        }
+        double dist;
+        if (reuse_lengths && spline_lengths[i] > 0) {
+            dist = spline_lengths[i];
+        } else {
+            dist = tolerance > 0 ? pf_spline_distance_gauss(&s, tolerance) : pf_spline_distance(&s, sample_count);
+        }
         cand->saptr[i] = s;
         cand->laptr[i] = dist;
         totalLength += dist;
     }
     
     TrajectoryConfig config = {dt, max_velocity, max_acceleration, max_jerk, 0, path[0].angle,
-        totalLength, 0, path[0].angle, sample_count};
+        totalLength, 0, path[0].angle, sample_count, tolerance};
     TrajectoryInfo info = pf_trajectory_prepare(config);
     int trajectory_length = info.length;
     
@@ -34,19 +56,51 @@ int pathfinder_prepare(Waypoint *path, int path_length, void (*fit)(Waypoint,Way
     return 0;
 }
 
+int pathfinder_prepare_into(Waypoint *path, int path_length, void (*fit)(Waypoint,Waypoint,Spline*), int sample_count, double dt,
+        double max_velocity, double max_acceleration, double max_jerk, TrajectoryCandidate *cand,
+        Spline *splines, double *spline_lengths) {
+    return prepare(path, path_length, fit, sample_count, 0, dt, max_velocity, max_acceleration,
+        max_jerk, cand, splines, spline_lengths, 0);
+}
+
+int pathfinder_prepare_gauss_into(Waypoint *path, int path_length, void (*fit)(Waypoint,Waypoint,Spline*), double tolerance, double dt,
+        double max_velocity, double max_acceleration, double max_jerk, TrajectoryCandidate *cand,
+        Spline *splines, double *spline_lengths) {
+    if (tolerance <= 0) return -1;
+    
+    return prepare(path, path_length, fit, 0, tolerance, dt, max_velocity, max_acceleration,
+        max_jerk, cand, splines, spline_lengths, 0);
+}
+
+int pathfinder_prepare_fitted_into(Waypoint *path, int path_length, double tolerance, double dt,
+        double max_velocity, double max_acceleration, double max_jerk, TrajectoryCandidate *cand,
+        Spline *splines, double *spline_lengths) {
+    if (tolerance <= 0) return -1;
+    
+    return prepare(path, path_length, 0, 0, tolerance, dt, max_velocity, max_acceleration,
+        max_jerk, cand, splines, spline_lengths, 1);
+}
+
 int pathfinder_generate(TrajectoryCandidate *c, Segment *segments) {
-    int trajectory_length = c->length;
+    double *buffer = malloc(MAX(c->length, 0) * sizeof(double));
+    int result = pathfinder_generate_into(c, segments, buffer);
+    free(buffer);
+    return result;
+}
+
+// A NULL table walks the samples of the spline for every segment. Candidates prepared with
+// Gauss-Kronrod quadrature never use the table. A NULL curvatures array is not filled in.
+static void place(TrajectoryCandidate *c, Segment *segments, int trajectory_length, double *table,
+        double *curvatures) {
     int path_length = c->path_length;
-    double totalLength = c->totalLength;
     
     Spline *splines = (c->saptr);
     double *splineLengths = (c->laptr);
     
-    int trajectory_status = pf_trajectory_create(c->info, c->config, segments);
-    if (trajectory_status < 0) return trajectory_status;
-    
     int spline_i = 0;
     double spline_pos_initial = 0, splines_complete = 0;
+    int table_spline_i = -1;
+    double gauss_from = 0, gauss_from_distance = 0;
     
     int i;
     for (i = 0; i < trajectory_length; ++i) {
@@ -57,11 +111,29 @@ int pathfinder_generate(TrajectoryCandidate *c, Segment *segments) {
             double pos_relative = pos - spline_pos_initial;
             if (pos_relative <= splineLengths[spline_i]) {
                 Spline si = splines[spline_i];
-                double percentage = pf_spline_progress_for_distance(si, pos_relative, c->config.sample_count);
+                double percentage;
+                if (c->config.tolerance > 0) {
+                    if (table_spline_i != spline_i) {
+                        gauss_from = 0;
+                        gauss_from_distance = 0;
+                        table_spline_i = spline_i;
+                    }
+                    percentage = pf_spline_progress_for_distance_gauss_from(si, pos_relative,
+                        c->config.tolerance, &gauss_from, &gauss_from_distance);
+                } else if (table) {
+                    if (table_spline_i != spline_i) {
+                        pf_spline_distance_table(si, c->config.sample_count, table);
+                        table_spline_i = spline_i;
+                    }
+                    percentage = pf_spline_progress_for_distance_table(si, pos_relative, c->config.sample_count, table);
+                } else {
+                    percentage = pf_spline_progress_for_distance(si, pos_relative, c->config.sample_count);
+                }
                 Coord coords = pf_spline_coords(si, percentage);
                 segments[i].heading = pf_spline_angle(si, percentage);
                 segments[i].x = coords.x;
                 segments[i].y = coords.y;
+                if (curvatures) curvatures[i] = pf_spline_curvature(si, percentage);
                 found = 1;
             } else if (spline_i < path_length - 2) {
                 splines_complete += splineLengths[spline_i];
@@ -73,10 +145,35 @@ int pathfinder_generate(TrajectoryCandidate *c, Segment *segments) {
                 Coord coords = pf_spline_coords(si, 1.0);
                 segments[i].x = coords.x;
                 segments[i].y = coords.y;
+                if (curvatures) curvatures[i] = pf_spline_curvature(si, 1.0);
                 found = 1;
             }
         }
     }
+}
+
+static int generate(TrajectoryCandidate *c, Segment *segments, double *buffer, double *table) {
+    int trajectory_status = pf_trajectory_create_into(c->info, c->config, segments, buffer);
+    if (trajectory_status < 0) return trajectory_status;
     
-    return trajectory_length;
+    place(c, segments, c->length, table, NULL);
+    
+    return c->length;
+}
+
+void pathfinder_place_on_splines(TrajectoryCandidate *c, Segment *segments, int length, double *curvatures) {
+    place(c, segments, length, NULL, curvatures);
+}
+
+void pathfinder_place_on_splines_lut(TrajectoryCandidate *c, Segment *segments, int length, double *curvatures,
+        double *table) {
+    place(c, segments, length, table, curvatures);
+}
+
+int pathfinder_generate_into(TrajectoryCandidate *c, Segment *segments, double *buffer) {
+    return generate(c, segments, buffer, NULL);
+}
+
+int pathfinder_generate_lut(TrajectoryCandidate *c, Segment *segments, double *buffer, double *table) {
+    return generate(c, segments, buffer, table);
 }
\ No newline at end of file
@@ -25,6 +25,16 @@ double pf_spline_deriv_2(double a, double b, double c, double d, double e, doubl
     return (5*a*x + 4*b) * (x*x*x) + (3*c*x + 2*d) * x + e;
 }
 
+double pf_spline_deriv_second(Spline s, double percentage) {
+    double x = percentage * s.knot_distance;
+    return (20*s.a*x + 12*s.b) * (x*x) + 6*s.c*x + 2*s.d;
+}
+
+double pf_spline_curvature(Spline s, double percentage) {
+    double dydx = pf_spline_deriv(s, percentage);
+    return pf_spline_deriv_second(s, percentage) / pow(1 + dydx*dydx, 1.5);
+}
+
 double pf_spline_angle(Spline s, double percentage) {
     return bound_radians(atan(pf_spline_deriv(s, percentage)) + s.angle_offset);
 }
@@ -87,4 +97,163 @@ double pf_spline_progress_for_distance(Spline s, double distance, int sample_cou
             / (arc_length - last_arc_length) - 1) / sample_count_d;
     }
     return interpolated;
+}
+
+void pf_spline_distance_table(Spline s, int sample_count, double *table) {
+    double sample_count_d = (double) sample_count;
+    
+    double a = s.a; double b = s.b; double c = s.c;
+    double d = s.d; double e = s.e; double knot = s.knot_distance;
+    
+    double arc_length = 0, t = 0, dydt = 0;
+    
+    double deriv0 = pf_spline_deriv_2(a, b, c, d, e, knot, 0);
+
+    double integrand = 0;
+    double last_integrand = sqrt(1 + deriv0*deriv0) / sample_count_d;
+    
+    // Same sums as pf_spline_progress_for_distance so both give the same progress
+    int i;
+    for (i = 0; i <= sample_count; i = i + 1) {
+        t = i / sample_count_d;
+        dydt = pf_spline_deriv_2(a, b, c, d, e, knot, t);
+        integrand = sqrt(1 + dydt*dydt) / sample_count_d;
+        arc_length += (integrand + last_integrand) / 2;
+        table[i] = arc_length;
+        last_integrand = integrand;
+    }
+}
+
+double pf_spline_progress_for_distance_table(Spline s, double distance, int sample_count, const double *table) {
+    double sample_count_d = (double) sample_count;
+    
+    distance /= s.knot_distance;
+    
+    // Find the first sample past the distance
+    int low = 0, high = sample_count + 1;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (table[mid] > distance) high = mid;
+        else low = mid + 1;
+    }
+    
+    if (low > sample_count) {
+        // The distance is past the end of the spline
+        return 1;
+    }
+    
+    double arc_length = table[low];
+    double last_arc_length = low > 0 ? table[low - 1] : 0;
+    
+    double interpolated = low / sample_count_d;
+    if (arc_length != last_arc_length) {
+        interpolated += ((distance - last_arc_length)
+            / (arc_length - last_arc_length) - 1) / sample_count_d;
+    }
+    return interpolated;
+}
+
+// 15 point Gauss-Kronrod rule on [-1, 1]. The odd Kronrod nodes are the nodes of the embedded 7
+// point Gauss rule, and the difference between the two rules estimates the error.
+static const double gk_nodes[8] = {
+    0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+    0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+    0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+    0.207784955007898467600689403773245, 0.000000000000000000000000000000000
+};
+static const double gk_kronrod_weights[8] = {
+    0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+    0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+    0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+    0.204432940075298892414161999234649, 0.209482141084727828012999174891714
+};
+static const double gk_gauss_weights[4] = {
+    0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+    0.381830050505118944950369775488975, 0.417959183673469387755102040816327
+};
+
+#define PF_GAUSS_MAX_DEPTH 30
+
+// Rate of change of arc length with respect to percentage
+static double arc_length_rate(const Spline *s, double t) {
+    double dydx = pf_spline_deriv_2(s->a, s->b, s->c, s->d, s->e, s->knot_distance, t);
+    return s->knot_distance * sqrt(1 + dydx*dydx);
+}
+
+static double gauss_kronrod(const Spline *s, double from, double to, double *error) {
+    double center = (from + to) / 2;
+    double half = (to - from) / 2;
+    
+    double f_center = arc_length_rate(s, center);
+    double kronrod = f_center * gk_kronrod_weights[7];
+    double gauss = f_center * gk_gauss_weights[3];
+    
+    int i;
+    for (i = 0; i < 7; i++) {
+        double dx = half * gk_nodes[i];
+        double f = arc_length_rate(s, center - dx) + arc_length_rate(s, center + dx);
+        kronrod += f * gk_kronrod_weights[i];
+        if (i % 2 == 1) gauss += f * gk_gauss_weights[i / 2];
+    }
+    
+    *error = fabs((kronrod - gauss) * half);
+    return kronrod * half;
+}
+
+static double adaptive_distance(const Spline *s, double from, double to, double tolerance, int depth) {
+    double error;
+    double length = gauss_kronrod(s, from, to, &error);
+    if (error <= tolerance || depth >= PF_GAUSS_MAX_DEPTH) return length;
+    
+    double middle = (from + to) / 2;
+    return adaptive_distance(s, from, middle, tolerance / 2, depth + 1)
+        + adaptive_distance(s, middle, to, tolerance / 2, depth + 1);
+}
+
+double pf_spline_distance_gauss(Spline *s, double tolerance) {
+    double al = adaptive_distance(s, 0, 1, tolerance, 0);
+    s->arc_length = al;
+    return al;
+}
+
+double pf_spline_progress_for_distance_gauss(Spline s, double distance, double tolerance) {
+    double from = 0, from_distance = 0;
+    return pf_spline_progress_for_distance_gauss_from(s, distance, tolerance, &from, &from_distance);
+}
+
+double pf_spline_progress_for_distance_gauss_from(Spline s, double distance, double tolerance,
+        double *from, double *from_distance) {
+    double total = s.arc_length > 0 ? s.arc_length : pf_spline_distance_gauss(&s, tolerance);
+    if (distance <= 0) return 0;
+    if (distance >= total) return 1;
+    
+    if (*from_distance > distance) {
+        // The known point is past the distance, so start over from the beginning of the spline
+        *from = 0;
+        *from_distance = 0;
+    }
+    
+    // Newton's method on length(t) - distance, kept inside a bisection bracket in case a step
+    // overshoots where the spline bends sharply
+    double low = *from, high = 1;
+    double t = *from + (distance - *from_distance) / arc_length_rate(&s, *from);
+    if (t <= low || t >= high) t = (low + high) / 2;
+    
+    double length = *from_distance;
+    int i;
+    for (i = 0; i < 50; i++) {
+        length = *from_distance + adaptive_distance(&s, *from, t, tolerance, 0);
+        double f = length - distance;
+        if (fabs(f) <= tolerance) break;
+        
+        if (f > 0) high = t;
+        else low = t;
+        
+        double next = t - f / arc_length_rate(&s, t);
+        t = (next > low && next < high) ? next : (low + high) / 2;
+    }
+    
+    *from = t;
+    *from_distance = length;
+    return t;
 }
\ No newline at end of file
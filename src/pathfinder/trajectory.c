@@ -41,7 +41,14 @@ TrajectoryInfo pf_trajectory_prepare(TrajectoryConfig c) {
 }
 
 int pf_trajectory_create(TrajectoryInfo info, TrajectoryConfig c, Segment *seg) {
-    int ret = pf_trajectory_fromSecondOrderFilter(info.filter1, info.filter2, info.dt, info.u, info.v, info.impulse, info.length, seg);
+    double *buffer = malloc(MAX(info.length, 0) * sizeof(double));
+    int ret = pf_trajectory_create_into(info, c, seg, buffer);
+    free(buffer);
+    return ret;
+}
+
+int pf_trajectory_create_into(TrajectoryInfo info, TrajectoryConfig c, Segment *seg, double *buffer) {
+    int ret = pf_trajectory_fromSecondOrderFilter_into(info.filter1, info.filter2, info.dt, info.u, info.v, info.impulse, info.length, seg, buffer);
     
     if (ret < 0) {
         return ret;
@@ -57,8 +64,6 @@ int pf_trajectory_create(TrajectoryInfo info, TrajectoryConfig c, Segment *seg)
 
 int pf_trajectory_fromSecondOrderFilter(int filter_1_l, int filter_2_l, 
         double dt, double u, double v, double impulse, int len, Segment *t) {
-    Segment last_section = {dt, 0, 0, 0, u, 0, 0};
-    
     if (len < 0) {
         // Error
         return -1;
@@ -66,6 +71,22 @@ int pf_trajectory_fromSecondOrderFilter(int filter_1_l, int filter_2_l,
     
     // double f1_buffer[len];
     double *f1_buffer = malloc(len * sizeof(double));       // VS doesn't support VLAs
+    int ret = pf_trajectory_fromSecondOrderFilter_into(filter_1_l, filter_2_l, dt, u, v, impulse, len, t, f1_buffer);
+    free(f1_buffer);
+    return ret;
+}
+
+int pf_trajectory_fromSecondOrderFilter_into(int filter_1_l, int filter_2_l, 
+        double dt, double u, double v, double impulse, int len, Segment *t, double *f1_buffer) {
+    Segment last_section = {dt, 0, 0, 0, u, 0, 0};
+    
+    if (len < 0) {
+        // Error
+        return -1;
+    } else if (len == 0) {
+        return 0;
+    }
+    
     f1_buffer[0] = (u / v) * filter_1_l;
     double f2;
     
@@ -108,6 +129,5 @@ int pf_trajectory_fromSecondOrderFilter(int filter_1_l, int filter_2_l,
 
         last_section = t[i];
     }
-    free(f1_buffer);
     return 0;
 }
\ No newline at end of file
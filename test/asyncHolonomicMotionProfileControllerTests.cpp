@@ -0,0 +1,178 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/async/asyncHolonomicMotionProfileController.hpp"
+#include "test/tests/api/implMocks.hpp"
+#include <gtest/gtest.h>
+
+using namespace okapi;
+
+class MockAsyncHolonomicMotionProfileController : public AsyncHolonomicMotionProfileController {
+  public:
+  using AsyncHolonomicMotionProfileController::AsyncHolonomicMotionProfileController;
+
+  const HolonomicPath &getPathData(const std::string &ipathId) {
+    std::scoped_lock lock(currentPathMutex);
+    return *paths.at(ipathId);
+  }
+
+  // The commands of one wheel at one step, in the order of the XDriveModel constructor
+  float command(const std::string &ipathId, const int istep, const int iwheel) {
+    return getPathData(ipathId).commands.at(4 * istep + iwheel);
+  }
+};
+
+class AsyncHolonomicMotionProfileControllerTest : public ::testing::Test {
+  protected:
+  void SetUp() override {
+    topLeftMotor = std::make_shared<MockMotor>();
+    topRightMotor = std::make_shared<MockMotor>();
+    bottomRightMotor = std::make_shared<MockMotor>();
+    bottomLeftMotor = std::make_shared<MockMotor>();
+
+    model = std::make_shared<XDriveModel>(topLeftMotor,
+                                          topRightMotor,
+                                          bottomRightMotor,
+                                          bottomLeftMotor,
+                                          topLeftMotor->getEncoder(),
+                                          topRightMotor->getEncoder(),
+                                          200,
+                                          v5MotorMaxVoltage);
+
+    controller = new MockAsyncHolonomicMotionProfileController(createTimeUtil(),
+                                                               {1.0, 2.0, 10.0},
+                                                               {2.0, 4.0, 20.0},
+                                                               model,
+                                                               {{4_in, 10.5_in}, quadEncoderTPR},
+                                                               AbstractMotor::gearset::green);
+    controller->startThread();
+  }
+
+  void TearDown() override {
+    delete controller;
+  }
+
+  std::shared_ptr<MockMotor> topLeftMotor;
+  std::shared_ptr<MockMotor> topRightMotor;
+  std::shared_ptr<MockMotor> bottomRightMotor;
+  std::shared_ptr<MockMotor> bottomLeftMotor;
+  std::shared_ptr<XDriveModel> model;
+  MockAsyncHolonomicMotionProfileController *controller;
+};
+
+TEST_F(AsyncHolonomicMotionProfileControllerTest, ConstructWithGearRatioOf0) {
+  EXPECT_THROW(AsyncHolonomicMotionProfileController(createTimeUtil(),
+                                                     {},
+                                                     {},
+                                                     nullptr,
+                                                     {{2_in, 8_in}, 360},
+                                                     AbstractMotor::gearset::green * 0),
+               std::invalid_argument);
+}
+
+TEST_F(AsyncHolonomicMotionProfileControllerTest, SettledWhenDisabled) {
+  assertControllerIsSettledWhenDisabled(*controller, std::string("A"));
+}
+
+TEST_F(AsyncHolonomicMotionProfileControllerTest, StrafingLeftDrivesTheDiagonalsApart) {
+  controller->generatePath({PathfinderPoint{0_m, 0_m, 90_deg}, PathfinderPoint{0_m, 2_ft, 90_deg}},
+                           0_deg,
+                           "A");
+
+  const int middle = controller->getPathData("A").length / 2;
+  EXPECT_LT(controller->command("A", middle, 0), -0.1);
+  EXPECT_GT(controller->command("A", middle, 1), 0.1);
+  EXPECT_LT(controller->command("A", middle, 2), -0.1);
+  EXPECT_GT(controller->command("A", middle, 3), 0.1);
+  EXPECT_FLOAT_EQ(controller->command("A", middle, 0), -controller->command("A", middle, 1));
+}
+
+TEST_F(AsyncHolonomicMotionProfileControllerTest, TurnAndDriveTakeAsLongAsTheSlowerOne) {
+  controller->generatePath(
+    {PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{1_ft, 0_m, 0_deg}}, 0_deg, "A");
+  controller->generatePath({PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{1_ft, 0_m, 0_deg}},
+                           180_deg,
+                           "B",
+                           {1.0, 2.0, 10.0},
+                           {1.0, 1.0, 10.0});
+
+  // Turning half a circle at these limits takes longer than driving a foot
+  const auto &straight = controller->getPathData("A");
+  const auto &turning = controller->getPathData("B");
+  EXPECT_GT(turning.length, straight.length);
+
+  // The robot has stopped driving and is only turning counterclockwise near the end
+  const int last = (straight.length + turning.length) / 2;
+  EXPECT_LT(controller->command("B", last, 0), 0);
+  EXPECT_GT(controller->command("B", last, 1), 0);
+  EXPECT_GT(controller->command("B", last, 2), 0);
+  EXPECT_LT(controller->command("B", last, 3), 0);
+  EXPECT_FLOAT_EQ(controller->command("B", last, 0), -controller->command("B", last, 1));
+}
+
+TEST_F(AsyncHolonomicMotionProfileControllerTest, FastPathsAreSlowedDownInsteadOfSaturating) {
+  // Driving diagonally at 1 m/s while turning needs more than the 1.06 m/s a wheel can do
+  controller->generatePath(
+    {PathfinderPoint{0_m, 0_m, 45_deg}, PathfinderPoint{2_ft, 2_ft, 45_deg}}, 90_deg, "A");
+
+  const auto &path = controller->getPathData("A");
+  float peak = 0;
+  for (int i = 0; i < path.length; ++i) {
+    for (int wheel = 0; wheel < 4; ++wheel) {
+      peak = std::max(peak, std::abs(controller->command("A", i, wheel)));
+    }
+  }
+
+  // Slowed down just enough, so no wheel has to be clamped and the robot keeps its direction
+  EXPECT_LE(peak, 1.001);
+  EXPECT_GT(peak, 0.99);
+}
+
+TEST_F(AsyncHolonomicMotionProfileControllerTest, FollowPathThenStop) {
+  controller->generatePath({PathfinderPoint{0_m, 0_m, 45_deg}, PathfinderPoint{1_ft, 1_ft, 45_deg}},
+                           90_deg,
+                           "A");
+
+  controller->setTarget("A");
+  EXPECT_EQ(controller->getTarget(), "A");
+  controller->waitUntilSettled();
+
+  for (const auto &motor : {topLeftMotor, topRightMotor, bottomRightMotor, bottomLeftMotor}) {
+    EXPECT_GT(motor->maxVelocity, 0);
+    EXPECT_EQ(motor->lastVelocity, 0);
+  }
+}
+
+TEST_F(AsyncHolonomicMotionProfileControllerTest, RemoveRunningPath) {
+  controller->generatePath(
+    {PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{3_ft, 0_m, 0_deg}}, 0_deg, "A");
+
+  controller->setTarget("A");
+  EXPECT_FALSE(controller->removePath("A"));
+  EXPECT_EQ(controller->getPaths().size(), 1);
+
+  controller->forceRemovePath("A");
+  EXPECT_EQ(controller->getPaths().size(), 0);
+  controller->waitUntilSettled();
+}
+
+TEST_F(AsyncHolonomicMotionProfileControllerTest, DestructorStopsFollowingPath) {
+  controller->generatePath(
+    {PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{10_ft, 0_m, 0_deg}}, 0_deg, "A");
+
+  controller->setTarget("A");
+  auto timeUtil = createTimeUtil();
+  auto rate = timeUtil.getRate();
+  while (topLeftMotor->lastVelocity == 0) {
+    rate->delayUntil(1_ms);
+  }
+
+  // The path takes several seconds, so the destructor must not wait for it to be driven
+  auto timer = timeUtil.getTimer();
+  const QTime start = timer->millis();
+  delete controller;
+  controller = nullptr;
+  EXPECT_LT(timer->millis() - start, 500_ms);
+}
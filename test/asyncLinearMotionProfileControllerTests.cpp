@@ -232,3 +232,13 @@ TEST_F(AsyncLinearMotionProfileControllerTest, FollowPathBackwards) {
   // still running
   controller->flipDisable(true);
 }
+
+TEST_F(AsyncLinearMotionProfileControllerTest, RepeatedPathIsCached) {
+  controller->generatePath({0_m, 3_m}, "A");
+  const std::size_t cacheSize = controller->getTrajectoryCache().getSize();
+  EXPECT_GT(cacheSize, 0);
+
+  controller->generatePath({0_m, 3_m}, "B");
+  EXPECT_EQ(controller->getTrajectoryCache().getSize(), cacheSize);
+  EXPECT_EQ(controller->getPaths().size(), 2);
+}
@@ -14,19 +14,76 @@ class MockAsyncMotionProfileController : public AsyncMotionProfileController {
   using AsyncMotionProfileController::AsyncMotionProfileController;
   using AsyncMotionProfileController::convertLinearToRotational;
   using AsyncMotionProfileController::internalLoadPath;
+  using AsyncMotionProfileController::internalLoadPathBinary;
   using AsyncMotionProfileController::internalStorePath;
+  using AsyncMotionProfileController::internalStorePathBinary;
   using AsyncMotionProfileController::makeFilePath;
 
   void executeSinglePath(const TrajectoryPair &path, std::unique_ptr<AbstractRate> rate) override {
     executeSinglePathCalled = true;
+    ++executeSinglePathCount;
+    if (!path.isCompact()) {
+      lastStart = plannedPose(path, 0);
+    }
     AsyncMotionProfileController::executeSinglePath(path, std::move(rate));
   }
 
-  TrajectoryPair &getPathData(std::string ipathId) {
-    return paths.at(ipathId);
+  const TrajectoryPair &getPathData(std::string ipathId) {
+    return *findPath(ipathId);
+  }
+
+  std::size_t getInternedPathCount() const {
+    return loadPathTable()->names.size();
   }
 
   bool executeSinglePathCalled{false};
+  std::atomic_int executeSinglePathCount{0};
+  RamseteFollower::Pose lastStart{0, 0, 0}; // Where the last path followed starts
+};
+
+/**
+ * A timer which runs faster than real time, so every tick of a rate appears to be late.
+ */
+class FastMockTimer : public AbstractTimer {
+  public:
+  explicit FastMockTimer(const double ispeedup) : AbstractTimer(0_ms), speedup(ispeedup) {
+  }
+
+  QTime millis() const override {
+    return realTimer.millis() * speedup;
+  }
+
+  MockTimer realTimer;
+  double speedup;
+};
+
+/**
+ * Odometry which reports the robot at the origin once, then a fixed distance to its right.
+ */
+class DriftingOdometry : public Odometry {
+  public:
+  void setScales(const ChassisScales &) override {
+  }
+
+  void step() override {
+  }
+
+  OdomState getState(const StateMode &) const override {
+    return calls++ == 0 ? OdomState{} : OdomState{0_m, 0.3_m, 0_deg};
+  }
+
+  void setState(const OdomState &, const StateMode &) override {
+  }
+
+  std::shared_ptr<ReadOnlyChassisModel> getModel() override {
+    return nullptr;
+  }
+
+  ChassisScales getScales() override {
+    return {{4_in, 10.5_in}, quadEncoderTPR};
+  }
+
+  mutable std::atomic_int calls{0};
 };
 
 class AsyncMotionProfileControllerTest : public ::testing::Test {
@@ -115,6 +172,13 @@ TEST_F(AsyncMotionProfileControllerTest, FollowPathWithMoveTo) {
   EXPECT_GT(rightMotor->maxVelocity, 0);
 }
 
+TEST_F(AsyncMotionProfileControllerTest, MoveToReusesItsPathId) {
+  controller->moveTo({PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{1_ft, 0_m, 0_deg}});
+  controller->moveTo({PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{1_ft, 0_m, 0_deg}});
+
+  EXPECT_EQ(controller->getInternedPathCount(), 1);
+}
+
 TEST_F(AsyncMotionProfileControllerTest, WrongPathNameDoesNotMoveAnything) {
   controller->setTarget("A");
   controller->waitUntilSettled();
@@ -373,3 +437,620 @@ TEST_F(AsyncMotionProfileControllerTest, SaveLoadPath) {
   controller->setTarget("A");
   EXPECT_EQ(controller->getTarget(), "A");
 }
+
+TEST_F(AsyncMotionProfileControllerTest, SaveLoadPathBinary) {
+  controller->generatePath(
+    {PathfinderPoint{0_in, 0_in, 0_deg}, PathfinderPoint{3_ft, 1_ft, 45_deg}}, "A");
+
+  FILE *pathFile = tmpfile();
+  EXPECT_TRUE(controller->internalStorePathBinary(pathFile, "A"));
+
+  const auto &genPath = controller->getPathData("A");
+  const int genPathLen = genPath.length;
+  const Segment lastLeft = genPath.left()[genPathLen - 1];
+  const Segment lastRight = genPath.right()[genPathLen - 1];
+
+  controller->removePath("A");
+  rewind(pathFile);
+  EXPECT_TRUE(controller->internalLoadPathBinary(pathFile, "A"));
+  fclose(pathFile);
+
+  EXPECT_EQ(controller->getPaths().front(), "A");
+  EXPECT_EQ(controller->getPaths().size(), 1);
+
+  const auto &loadedPath = controller->getPathData("A");
+  EXPECT_EQ(loadedPath.length, genPathLen);
+  EXPECT_DOUBLE_EQ(loadedPath.left()[genPathLen - 1].position, lastLeft.position);
+  EXPECT_DOUBLE_EQ(loadedPath.right()[genPathLen - 1].velocity, lastRight.velocity);
+  EXPECT_DOUBLE_EQ(loadedPath.limits.maxVel, 1.0);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, LoadPathBinaryRejectsCsvFile) {
+  controller->generatePath(
+    {PathfinderPoint{0_in, 0_in, 0_deg}, PathfinderPoint{3_ft, 0_in, 0_deg}}, "A");
+
+  FILE *leftFile = tmpfile();
+  FILE *rightFile = tmpfile();
+  controller->internalStorePath(leftFile, rightFile, "A");
+  controller->removePath("A");
+
+  rewind(leftFile);
+  EXPECT_FALSE(controller->internalLoadPathBinary(leftFile, "A"));
+  EXPECT_EQ(controller->getPaths().size(), 0);
+
+  fclose(leftFile);
+  fclose(rightFile);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, StoreNonExistentPathBinary) {
+  FILE *pathFile = tmpfile();
+  EXPECT_FALSE(controller->internalStorePathBinary(pathFile, "A"));
+  fclose(pathFile);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, GeneratePathAsync) {
+  controller->generatePathAsync(
+    {PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{3_ft, 0_m, 45_deg}}, "A");
+
+  EXPECT_TRUE(controller->waitUntilPathGenerated("A"));
+  EXPECT_FALSE(controller->isGeneratingPath("A"));
+  EXPECT_EQ(controller->getPaths().front(), "A");
+  EXPECT_EQ(controller->getPaths().size(), 1);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, SetTargetWaitsForAsyncPath) {
+  controller->generatePathAsync(
+    {PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{3_ft, 0_m, 45_deg}}, "A");
+  controller->setTarget("A");
+
+  controller->waitUntilSettled();
+
+  EXPECT_TRUE(controller->executeSinglePathCalled);
+  assertMotorsHaveBeenStopped(leftMotor.get(), rightMotor.get());
+  EXPECT_GT(leftMotor->maxVelocity, 0);
+  EXPECT_GT(rightMotor->maxVelocity, 0);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, ImpossibleAsyncPathIsNotSaved) {
+  controller->generatePathAsync({PathfinderPoint{0_m, 0_m, 0_deg},
+                                 PathfinderPoint{3_ft, 0_m, 0_deg},
+                                 PathfinderPoint{3_ft, 1_ft, 0_deg},
+                                 PathfinderPoint{2_ft, 1_ft, 0_deg},
+                                 PathfinderPoint{1_ft, 1_m, 0_deg},
+                                 PathfinderPoint{1_ft, 0_m, 0_deg}},
+                                "A");
+
+  EXPECT_FALSE(controller->waitUntilPathGenerated("A"));
+  EXPECT_EQ(controller->getPaths().size(), 0);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, RepeatedPathIsCached) {
+  controller->generatePath(
+    {PathfinderPoint{0_in, 0_in, 0_deg}, PathfinderPoint{3_ft, 1_ft, 45_deg}}, "A");
+  const std::size_t cacheSize = controller->getTrajectoryCache().getSize();
+  EXPECT_GT(cacheSize, 0);
+
+  controller->generatePath(
+    {PathfinderPoint{0_in, 0_in, 0_deg}, PathfinderPoint{3_ft, 1_ft, 45_deg}}, "B");
+  EXPECT_EQ(controller->getTrajectoryCache().getSize(), cacheSize);
+
+  const auto &pathA = controller->getPathData("A");
+  const auto &pathB = controller->getPathData("B");
+  ASSERT_EQ(pathA.length, pathB.length);
+  EXPECT_NE(pathA.left(), pathB.left());
+  EXPECT_DOUBLE_EQ(pathA.left()[pathA.length - 1].position,
+                   pathB.left()[pathB.length - 1].position);
+  EXPECT_DOUBLE_EQ(pathA.right()[pathA.length - 1].position,
+                   pathB.right()[pathB.length - 1].position);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, DifferentLimitsAreNotCached) {
+  controller->generatePath(
+    {PathfinderPoint{0_in, 0_in, 0_deg}, PathfinderPoint{3_ft, 0_in, 0_deg}}, "A");
+  const std::size_t cacheSize = controller->getTrajectoryCache().getSize();
+
+  controller->generatePath(
+    {PathfinderPoint{0_in, 0_in, 0_deg}, PathfinderPoint{3_ft, 0_in, 0_deg}}, "B", {0.5, 2, 10});
+  EXPECT_GT(controller->getTrajectoryCache().getSize(), cacheSize);
+  EXPECT_GT(controller->getPathData("B").length, controller->getPathData("A").length);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, WheelLimitsSlowDownOnCurves) {
+  PathfinderLimits limits{1.0, 2.0, 10.0};
+  limits.maxWheelVel = 0.8;
+  controller->generatePath(
+    {PathfinderPoint{0_ft, 0_ft, 0_deg}, PathfinderPoint{3_ft, 2_ft, 45_deg}}, "A", limits);
+
+  const auto &path = controller->getPathData("A");
+  for (int i = 0; i < path.length; ++i) {
+    EXPECT_LE(path.left()[i].velocity, 0.8 + 1e-3);
+    EXPECT_LE(path.right()[i].velocity, 0.8 + 1e-3);
+  }
+}
+
+TEST_F(AsyncMotionProfileControllerTest, GeneratePathsMatchesGeneratePath) {
+  controller->generatePath(
+    {PathfinderPoint{0_ft, 0_ft, 0_deg}, PathfinderPoint{3_ft, 2_ft, 45_deg}}, "A");
+  controller->getTrajectoryCache().setMaxSize(0);
+
+  const auto errors = controller->generatePaths(
+    {{{PathfinderPoint{0_ft, 0_ft, 0_deg}, PathfinderPoint{3_ft, 2_ft, 45_deg}}, "B"},
+     {{PathfinderPoint{0_ft, 0_ft, 0_deg}, PathfinderPoint{3_ft, 0_ft, 0_deg}}, "C"},
+     {{PathfinderPoint{0_ft, 0_ft, 0_deg}, PathfinderPoint{3_ft, 0_ft, 0_deg}},
+      "D",
+      PathfinderLimits{0.5, 2, 10}}});
+
+  EXPECT_EQ(errors, std::vector<std::string>(3));
+  ASSERT_EQ(controller->getPaths().size(), 4);
+
+  const auto &a = controller->getPathData("A");
+  const auto &b = controller->getPathData("B");
+  ASSERT_EQ(a.length, b.length);
+  for (int i = 0; i < a.length; ++i) {
+    EXPECT_DOUBLE_EQ(a.left()[i].velocity, b.left()[i].velocity);
+    EXPECT_DOUBLE_EQ(a.right()[i].velocity, b.right()[i].velocity);
+  }
+
+  EXPECT_GT(controller->getPathData("D").length, controller->getPathData("C").length);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, GeneratePathsReportsEachFailure) {
+  const auto errors = controller->generatePaths(
+    {{{PathfinderPoint{0_ft, 0_ft, 0_deg}, PathfinderPoint{3_ft, 0_ft, 0_deg}}, "A"},
+     {{PathfinderPoint{0_ft, 0_ft, 0_deg}}, "B"},
+     {{}, "C"},
+     {{PathfinderPoint{0_ft, 0_ft, 0_deg}, PathfinderPoint{2_ft, 0_ft, 0_deg}}, "D"}});
+
+  ASSERT_EQ(errors.size(), 4);
+  EXPECT_TRUE(errors[0].empty());
+  EXPECT_FALSE(errors[1].empty());
+  EXPECT_FALSE(errors[2].empty());
+  EXPECT_TRUE(errors[3].empty());
+  EXPECT_EQ(controller->getPaths(), (std::vector<std::string>{"A", "D"}));
+}
+
+TEST_F(AsyncMotionProfileControllerTest, GeneratePathsReplacingOtherPathsKeepsRunning) {
+  controller->generatePaths(
+    {{{PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{3_ft, 0_m, 0_deg}}, "A"},
+     {{PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{2_ft, 0_m, 0_deg}}, "B"}});
+
+  controller->setTarget("A");
+  const auto oldB = controller->getPathData("B").length;
+
+  controller->generatePaths(
+    {{{PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{4_ft, 0_m, 0_deg}}, "B"}});
+  EXPECT_FALSE(controller->isDisabled());
+  EXPECT_GT(controller->getPathData("B").length, oldB);
+  EXPECT_EQ(controller->getPaths(), (std::vector<std::string>{"A", "B"}));
+}
+
+TEST_F(AsyncMotionProfileControllerTest, GeneratePathsReplacingRunningPathDisables) {
+  controller->generatePath({PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{3_ft, 0_m, 0_deg}},
+                           "A");
+  controller->setTarget("A");
+
+  controller->generatePaths(
+    {{{PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{3_ft, 3_ft, 45_deg}}, "A"}});
+  EXPECT_TRUE(controller->isDisabled());
+  EXPECT_EQ(controller->getPaths().size(), 1);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, PathSidesShareOneAllocation) {
+  controller->generatePath(
+    {PathfinderPoint{0_in, 0_in, 0_deg}, PathfinderPoint{3_ft, 0_in, 0_deg}}, "A");
+
+  const auto &path = controller->getPathData("A");
+  EXPECT_EQ(path.right(), path.left() + path.length);
+  EXPECT_GT(path.right()[path.length - 1].position, 0);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, SingleWaypointPathThrows) {
+  EXPECT_THROW(controller->generatePath({PathfinderPoint{0_in, 0_in, 0_deg}}, "A"),
+               std::runtime_error);
+  EXPECT_EQ(controller->getPaths().size(), 0);
+
+  // The scratch must still be usable after a failed generation
+  controller->generatePath(
+    {PathfinderPoint{0_in, 0_in, 0_deg}, PathfinderPoint{3_ft, 0_in, 0_deg}}, "A");
+  EXPECT_EQ(controller->getPaths().size(), 1);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, ZeroLimitsAreExplained) {
+  try {
+    controller->generatePath(
+      {PathfinderPoint{0_in, 0_in, 0_deg}, PathfinderPoint{3_ft, 0_in, 0_deg}}, "A", {0, 2, 10});
+    FAIL() << "The path should be impossible";
+  } catch (const std::runtime_error &e) {
+    EXPECT_NE(std::string(e.what()).find("must be positive"), std::string::npos);
+  }
+}
+
+TEST_F(AsyncMotionProfileControllerTest, ReportOfStraightPath) {
+  controller->generatePath(
+    {PathfinderPoint{0_in, 0_in, 0_deg}, PathfinderPoint{3_ft, 0_in, 0_deg}}, "A");
+
+  const auto report = controller->getPathReport("A");
+  ASSERT_TRUE(report.has_value());
+
+  const auto &path = controller->getPathData("A");
+  EXPECT_NEAR(report->duration.convert(second), path.length * 0.01, 1e-9);
+  EXPECT_NEAR(report->maxWheelRpm, controller->convertLinearToRotational(1_mps).convert(rpm), 1);
+  EXPECT_NEAR(report->maxWheelAccel, 2, 0.1);
+  EXPECT_NEAR(report->maxCurvature, 0, 1e-6);
+  EXPECT_TRUE(report->hotSpots.empty());
+  EXPECT_TRUE(report->feasible);
+
+  EXPECT_FALSE(controller->getPathReport("B").has_value());
+}
+
+TEST_F(AsyncMotionProfileControllerTest, PreviewFindsHotSpotWithoutSavingPath) {
+  // A radius of 4 inches is under half the wheel track, so the inner wheel has to reverse
+  const auto report = controller->previewPath(
+    {PathfinderPoint{0_in, 0_in, 0_deg}, PathfinderPoint{4_in, 4_in, 90_deg}}, {0.5, 2, 10});
+
+  EXPECT_TRUE(controller->getPaths().empty());
+  ASSERT_EQ(report.hotSpots.size(), 1);
+  EXPECT_GT(report.hotSpots[0].curvature, 2 / (10.5_in).convert(meter));
+  EXPECT_GT(report.hotSpots[0].time, 0_ms);
+  EXPECT_LT(report.hotSpots[0].time, report.duration);
+  EXPECT_GE(report.maxCurvature, report.hotSpots[0].curvature);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, InfeasiblePathIsRejected) {
+  controller->setPathValidation(AsyncMotionProfileController::PathValidation::reject);
+
+  // The wheels can only reach about 2.1 m/s
+  EXPECT_THROW(controller->generatePath({PathfinderPoint{0_in, 0_in, 0_deg},
+                                         PathfinderPoint{3_m, 0_in, 0_deg}},
+                                        "A",
+                                        {3, 4, 20}),
+               std::runtime_error);
+  EXPECT_TRUE(controller->getPaths().empty());
+
+  controller->generatePath(
+    {PathfinderPoint{0_in, 0_in, 0_deg}, PathfinderPoint{3_m, 0_in, 0_deg}}, "A", {2, 4, 20});
+  EXPECT_EQ(controller->getPaths().size(), 1);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, InfeasiblePathIsRescaled) {
+  controller->setPathValidation(AsyncMotionProfileController::PathValidation::rescale);
+
+  const std::initializer_list<PathfinderPoint> points{PathfinderPoint{0_in, 0_in, 0_deg},
+                                                      PathfinderPoint{3_m, 1_m, 45_deg}};
+  EXPECT_FALSE(controller->previewPath(points, {3, 4, 20}).feasible);
+
+  controller->generatePath(points, "A", {3, 4, 20});
+  const auto report = controller->getPathReport("A");
+  ASSERT_TRUE(report.has_value());
+  EXPECT_TRUE(report->feasible);
+  EXPECT_GT(controller->getPathData("A").limits.maxWheelVel, 0);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, FollowCompactedPath) {
+  controller->generatePath(
+    {PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{3_ft, 0_m, 45_deg}}, "A");
+  controller->setTarget("A");
+  controller->waitUntilSettled();
+  const auto leftVelocity = leftMotor->maxVelocity;
+  const auto rightVelocity = rightMotor->maxVelocity;
+  leftMotor->maxVelocity = 0;
+  rightMotor->maxVelocity = 0;
+
+  // The compact path only keeps its velocities and derives the same commands from them
+  EXPECT_TRUE(controller->compactPath("A", PlaybackTrajectory::encoding::int16));
+  EXPECT_TRUE(controller->getPathData("A").isCompact());
+  EXPECT_TRUE(controller->getPathData("A").commands.empty());
+
+  controller->setTarget("A");
+  controller->waitUntilSettled();
+
+  assertMotorsHaveBeenStopped(leftMotor.get(), rightMotor.get());
+  EXPECT_GT(leftMotor->maxVelocity, 0);
+  EXPECT_GT(rightMotor->maxVelocity, 0);
+  EXPECT_NEAR(leftMotor->maxVelocity, leftVelocity, 1);
+  EXPECT_NEAR(rightMotor->maxVelocity, rightVelocity, 1);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, CompactingRunningPathDoesNotInterruptIt) {
+  controller->generatePath(
+    {PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{3_ft, 0_m, 0_deg}}, "A");
+  const auto &original = controller->getPathData("A");
+  const int length = original.length;
+  const Segment last = original.left()[length - 1];
+
+  controller->setTarget("A");
+  auto rate = createTimeUtil().getRate();
+  while (!controller->executeSinglePathCalled) {
+    rate->delayUntil(1_ms);
+  }
+
+  // The running path is swapped for the compact copy instead of being changed under the loop
+  EXPECT_TRUE(controller->compactPath("A"));
+  EXPECT_TRUE(controller->getPathData("A").isCompact());
+  EXPECT_FALSE(controller->isSettled());
+
+  controller->waitUntilSettled();
+
+  EXPECT_FALSE(controller->isDisabled());
+  EXPECT_EQ(controller->executeSinglePathCount, 1);
+  EXPECT_EQ(controller->getPathData("A").length, length);
+  EXPECT_FLOAT_EQ(controller->getPathData("A").playback.getVelocity(0, length - 1), last.velocity);
+  assertMotorsHaveBeenStopped(leftMotor.get(), rightMotor.get());
+}
+
+TEST_F(AsyncMotionProfileControllerTest, GetPathsIsSortedById) {
+  controller->generatePath({PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{1_ft, 0_m, 0_deg}},
+                           "B");
+  controller->generatePath({PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{1_ft, 0_m, 0_deg}},
+                           "A");
+  controller->removePath("B");
+  controller->generatePath({PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{1_ft, 0_m, 0_deg}},
+                           "B");
+
+  EXPECT_EQ(controller->getPaths(), (std::vector<std::string>{"A", "B"}));
+}
+
+TEST_F(AsyncMotionProfileControllerTest, FollowPathByHandle) {
+  const auto handle = controller->generatePath(
+    {PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{3_ft, 0_m, 0_deg}}, "A");
+  EXPECT_TRUE(handle.isValid());
+  EXPECT_EQ(controller->getPathHandle("A"), handle);
+
+  controller->setTarget(handle);
+  EXPECT_EQ(controller->getTargetHandle(), handle);
+  EXPECT_EQ(controller->getTarget(), "A");
+
+  controller->waitUntilSettled();
+
+  EXPECT_EQ(controller->executeSinglePathCount, 1);
+  assertMotorsHaveBeenStopped(leftMotor.get(), rightMotor.get());
+  EXPECT_GT(leftMotor->maxVelocity, 0);
+  EXPECT_GT(rightMotor->maxVelocity, 0);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, HandleStaysTheSameWhenPathIsSavedAgain) {
+  const auto handle = controller->generatePath(
+    {PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{1_ft, 0_m, 0_deg}}, "A");
+  const auto other = controller->getPathHandle("B");
+  EXPECT_NE(other, handle);
+
+  EXPECT_TRUE(controller->removePath("A"));
+  EXPECT_EQ(controller->getPaths().size(), 0);
+  EXPECT_EQ(controller->generatePath(
+              {PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{2_ft, 0_m, 0_deg}}, "A"),
+            handle);
+  EXPECT_EQ(controller->getPathHandle("B"), other);
+
+  // Getting a handle does not save a path
+  EXPECT_EQ(controller->getPaths(), std::vector<std::string>{"A"});
+}
+
+TEST_F(AsyncMotionProfileControllerTest, InvalidHandleDoesNotMoveAnything) {
+  EXPECT_FALSE(AsyncMotionProfileController::PathHandle().isValid());
+
+  controller->setTarget(AsyncMotionProfileController::PathHandle());
+  EXPECT_EQ(controller->getTarget(), "");
+  controller->waitUntilSettled();
+
+  EXPECT_EQ(leftMotor->maxVelocity, 0);
+  EXPECT_EQ(rightMotor->maxVelocity, 0);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, FollowPathWithFollowerGains) {
+  controller->generatePath(
+    {PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{3_ft, 0_m, 0_deg}}, "A");
+  controller->setFollowerGains({0.5, 0.1, 0.05, 2}, 2_ms);
+
+  // The encoders never move, so the wheels fall behind the path
+  controller->setTarget("A");
+  controller->waitUntilSettled();
+
+  EXPECT_EQ(leftMotor->maxVelocity, 0);
+  EXPECT_EQ(rightMotor->maxVelocity, 0);
+  EXPECT_GT(leftMotor->lastVoltage, 0);
+  EXPECT_GT(rightMotor->lastVoltage, 0);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, FollowPathBackwardsWithFollowerGains) {
+  controller->generatePath(
+    {PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{3_ft, 0_m, 0_deg}}, "A");
+  controller->setFollowerGains({0.5, 0.1, 0.05, 2});
+
+  controller->setTarget("A", true);
+  controller->waitUntilSettled();
+
+  EXPECT_LT(leftMotor->lastVoltage, 0);
+  EXPECT_LT(rightMotor->lastVoltage, 0);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, FollowPathWithOdometrySteersBackToPath) {
+  controller->generatePath(
+    {PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{1_ft, 0_m, 0_deg}}, "A", {0.2, 2, 10});
+  auto odometry = std::make_shared<DriftingOdometry>();
+  controller->setRamseteFollower(odometry, {20, 0.7});
+
+  controller->setTarget("A");
+  controller->waitUntilSettled();
+
+  // The robot drifted to the right, so the right wheels speed up to turn left
+  EXPECT_GT(odometry->calls, 1);
+  EXPECT_GT(rightMotor->maxVelocity, leftMotor->maxVelocity);
+  assertMotorsHaveBeenStopped(leftMotor.get(), rightMotor.get());
+}
+
+TEST_F(AsyncMotionProfileControllerTest, QueuedPathsRunWithoutStopping) {
+  PathfinderLimits first{1.0, 2.0, 10.0};
+  first.endVel = 0.5;
+  PathfinderLimits second{1.0, 2.0, 10.0};
+  second.startVel = 0.5;
+
+  controller->generatePath(
+    {PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{2_ft, 0_m, 0_deg}}, "A", first);
+  controller->generatePath(
+    {PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{2_ft, 0_m, 0_deg}}, "B", second);
+
+  EXPECT_NEAR(controller->getPathData("A").left()[controller->getPathData("A").length - 1].velocity,
+              0.5,
+              0.03);
+  EXPECT_NEAR(controller->getPathData("B").left()[0].velocity, 0.5, 0.03);
+
+  controller->setTarget("A");
+  controller->queueTarget("B");
+  controller->waitUntilSettled();
+
+  EXPECT_EQ(controller->executeSinglePathCount, 2);
+  EXPECT_EQ(controller->getTarget(), "B");
+  assertMotorsHaveBeenStopped(leftMotor.get(), rightMotor.get());
+}
+
+TEST_F(AsyncMotionProfileControllerTest, QueueTargetWhenIdleStartsPath) {
+  controller->generatePath(
+    {PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{2_ft, 0_m, 0_deg}}, "A");
+
+  controller->queueTarget("A");
+  EXPECT_FALSE(controller->isSettled());
+  controller->waitUntilSettled();
+
+  EXPECT_EQ(controller->executeSinglePathCount, 1);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, LateTicksSkipAheadToStayOnTime) {
+  auto fastController = std::make_unique<MockAsyncMotionProfileController>(
+    createTimeUtil(Supplier<std::unique_ptr<AbstractTimer>>(
+      []() { return std::make_unique<FastMockTimer>(4); })),
+    PathfinderLimits{1.0, 2.0, 10.0},
+    std::make_shared<SkidSteerModel>(leftMotor,
+                                     rightMotor,
+                                     leftMotor->getEncoder(),
+                                     rightMotor->getEncoder(),
+                                     100,
+                                     v5MotorMaxVoltage),
+    ChassisScales({4_in, 10.5_in}, quadEncoderTPR),
+    AbstractMotor::gearset::green * (1.0 / 2));
+  fastController->startThread();
+
+  fastController->generatePath(
+    {PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{3_ft, 0_m, 0_deg}}, "A");
+  const QTime pathTime = fastController->getPathData("A").length * 10_ms;
+
+  MockTimer timer;
+  const QTime start = timer.millis();
+  fastController->setTarget("A");
+  fastController->waitUntilSettled();
+
+  // The path plays back against the timer, which runs four times faster than the rate
+  EXPECT_TRUE(fastController->executeSinglePathCalled);
+  EXPECT_LT(timer.millis() - start, pathTime * 0.5);
+  assertMotorsHaveBeenStopped(leftMotor.get(), rightMotor.get());
+}
+
+TEST_F(AsyncMotionProfileControllerTest, CompactNonExistentPath) {
+  EXPECT_FALSE(controller->compactPath("A"));
+}
+
+TEST_F(AsyncMotionProfileControllerTest, StoreCompactedPathBinary) {
+  controller->generatePath(
+    {PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{3_ft, 0_m, 0_deg}}, "A");
+  controller->compactPath("A");
+
+  FILE *pathFile = tmpfile();
+  EXPECT_FALSE(controller->internalStorePathBinary(pathFile, "A"));
+  fclose(pathFile);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, ReplanWithoutPathFails) {
+  EXPECT_FALSE(controller->replan());
+}
+
+TEST_F(AsyncMotionProfileControllerTest, ReplanSwitchesPathsWithoutStopping) {
+  controller->generatePath({PathfinderPoint{0_m, 0_m, 0_deg},
+                            PathfinderPoint{2_ft, 0_m, 0_deg},
+                            PathfinderPoint{4_ft, 1_ft, 0_deg}},
+                           "A");
+
+  controller->setTarget("A");
+  auto rate = createTimeUtil().getRate();
+  while (!controller->executeSinglePathCalled) {
+    rate->delayUntil(1_ms);
+  }
+  rate->delayUntil(200_ms);
+
+  EXPECT_TRUE(controller->replan());
+  controller->waitUntilSettled();
+
+  // Without odometry the new path starts where the old one was when it was replanned
+  EXPECT_EQ(controller->executeSinglePathCount, 2);
+  EXPECT_GT(controller->lastStart.x, 0);
+  EXPECT_LT(controller->lastStart.x, (2_ft).convert(meter));
+  EXPECT_FALSE(controller->isDisabled());
+  assertMotorsHaveBeenStopped(leftMotor.get(), rightMotor.get());
+
+  // The saved path is not changed
+  EXPECT_EQ(controller->getPathData("A").waypoints.size(), 3);
+}
+
+TEST_F(AsyncMotionProfileControllerTest, ReplanStartsFromOdometryPose) {
+  auto odometry = std::make_shared<DriftingOdometry>();
+  controller->setRamseteFollower(odometry);
+  controller->generatePath({PathfinderPoint{0_m, 0_m, 0_deg},
+                            PathfinderPoint{2_ft, 0_m, 0_deg},
+                            PathfinderPoint{4_ft, 0_m, 0_deg}},
+                           "A");
+
+  controller->setTarget("A");
+  auto rate = createTimeUtil().getRate();
+  while (!controller->executeSinglePathCalled) {
+    rate->delayUntil(1_ms);
+  }
+  rate->delayUntil(200_ms);
+
+  EXPECT_TRUE(controller->replan());
+  controller->waitUntilSettled();
+
+  // The robot is 0.3 m to its right, which is -y in the frame of the path. The first segment is
+  // one step into the path.
+  EXPECT_EQ(controller->executeSinglePathCount, 2);
+  EXPECT_NEAR(controller->lastStart.x, 0, 1e-3);
+  EXPECT_NEAR(controller->lastStart.y, -0.3, 1e-3);
+  assertMotorsHaveBeenStopped(leftMotor.get(), rightMotor.get());
+}
+
+TEST_F(AsyncMotionProfileControllerTest, ReplannedPathIsValidated) {
+  // The wheels can only reach about 2.1 m/s, which the default warning lets through
+  controller->generatePath({PathfinderPoint{0_m, 0_m, 0_deg},
+                            PathfinderPoint{1_m, 0_m, 0_deg},
+                            PathfinderPoint{3_m, 0_m, 0_deg}},
+                           "A",
+                           {3, 4, 20});
+
+  controller->setTarget("A");
+  auto rate = createTimeUtil().getRate();
+  while (!controller->executeSinglePathCalled) {
+    rate->delayUntil(1_ms);
+  }
+
+  controller->setPathValidation(AsyncMotionProfileController::PathValidation::reject);
+  EXPECT_FALSE(controller->replan());
+
+  controller->setPathValidation(AsyncMotionProfileController::PathValidation::rescale);
+  EXPECT_TRUE(controller->replan());
+
+  controller->flipDisable(true);
+  controller->waitUntilSettled();
+}
+
+TEST_F(AsyncMotionProfileControllerTest, CompactedPathCannotBeReplanned) {
+  controller->generatePath(
+    {PathfinderPoint{0_m, 0_m, 0_deg}, PathfinderPoint{2_ft, 0_m, 0_deg}}, "A");
+  controller->compactPath("A");
+
+  controller->setTarget("A");
+  auto rate = createTimeUtil().getRate();
+  while (!controller->executeSinglePathCalled) {
+    rate->delayUntil(1_ms);
+  }
+
+  EXPECT_FALSE(controller->replan());
+  controller->waitUntilSettled();
+  EXPECT_EQ(controller->executeSinglePathCount, 1);
+}
@@ -49,6 +49,17 @@ TEST_F(AsyncWrapperTest, GetTargetTestVelPID) {
   EXPECT_EQ(velPIDController->getTarget(), 10);
 }
 
+TEST_F(AsyncWrapperTest, LoopStatsMeasureTheControllerTask) {
+  posPIDController->getLoopStats().setEnabled(true);
+  posPIDController->startThread();
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  const auto summary = posPIDController->getLoopStats().getSummary();
+  EXPECT_GT(summary.iterations, 0);
+  EXPECT_GE(summary.maxDuration, summary.meanDuration);
+}
+
 TEST_F(AsyncWrapperTest, SettledWhenDisabledPosPID) {
   assertControllerIsSettledWhenDisabled(*posPIDController, 100.0);
 }
@@ -7,6 +7,7 @@
 #include "okapi/api/chassis/model/skidSteerModel.hpp"
 #include "test/tests/api/implMocks.hpp"
 #include <gtest/gtest.h>
+#include <thread>
 
 using namespace okapi;
 
@@ -399,3 +400,41 @@ TEST_F(ChassisControllerPIDTest, isSettledInModeNone) {
   controller->mode = CCPIDUnderTest::modeType::none;
   EXPECT_TRUE(controller->isSettled());
 }
+
+TEST_F(ChassisControllerPIDTest, ProfiledTurnMovesTheTargetAlongTheProfile) {
+  controller->setTurnProfile(180_deg / second, 360_deg / second / second);
+  controller->turnAngleAsync(wheelDiam / wheelTrack * 360_deg);
+
+  // The whole turn takes 1.5 seconds, so the target has moved partway after half a second
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  const double finalTarget = gearsetToTPR(controller->getGearsetRatioPair().internalGearset);
+  EXPECT_GT(turnController->getTarget(), 0);
+  EXPECT_LT(turnController->getTarget(), finalTarget);
+  EXPECT_FALSE(controller->isSettled());
+
+  // The feedforward drives the robot clockwise
+  EXPECT_GT(leftMotor->lastVelocity, 0);
+  EXPECT_LT(rightMotor->lastVelocity, 0);
+
+  controller->waitUntilSettled();
+
+  EXPECT_DOUBLE_EQ(turnController->getTarget(), finalTarget);
+  EXPECT_TRUE(turnController->isDisabled());
+  assertMotorsHaveBeenStopped(leftMotor, rightMotor);
+}
+
+TEST_F(ChassisControllerPIDTest, DisabledTurnProfileStepsTheTarget) {
+  controller->setTurnProfile(180_deg / second, 360_deg / second / second);
+  controller->disableTurnProfile();
+  controller->turnRawAsync(100);
+
+  EXPECT_DOUBLE_EQ(turnController->getTarget(), 100);
+  controller->waitUntilSettled();
+}
+
+TEST_F(ChassisControllerPIDTest, TurnProfileMustHavePositiveLimits) {
+  EXPECT_THROW(controller->setTurnProfile(0_deg / second, 360_deg / second / second),
+               std::invalid_argument);
+  EXPECT_THROW(controller->setTurnProfile(180_deg / second, -360_deg / second / second),
+               std::invalid_argument);
+}
@@ -6,6 +6,7 @@
 #include "okapi/api/util/logging.hpp"
 #include "test/tests/api/implMocks.hpp"
 #include <gtest/gtest.h>
+#include <thread>
 
 using namespace okapi;
 
@@ -172,3 +173,274 @@ TEST_F(LoggerTest, TestLazyLogging) {
     free(line);
   }
 }
+
+TEST_F(LoggerTest, AsyncLoggerWritesInOrder) {
+  logger = std::make_shared<Logger>(std::make_unique<ConstantMockTimer>(0_ms),
+                                    logFile,
+                                    Logger::LogLevel::debug,
+                                    Logger::AsyncOptions{4, Logger::Overflow::block});
+  EXPECT_TRUE(logger->isAsync());
+
+  // Many more statements than the buffer holds, so logging has to wait for the writer
+  for (int i = 0; i < 100; ++i) {
+    LOG_INFO("MSG " + std::to_string(i));
+  }
+
+  logger->close();
+
+  std::string expected;
+  for (int i = 0; i < 100; ++i) {
+    expected += "0 (" + CrossplatformThread::getName() + ") INFO: MSG " + std::to_string(i) + "\n";
+  }
+  EXPECT_EQ(std::string(logBuffer, logSize), expected);
+}
+
+TEST_F(LoggerTest, AsyncLoggerCutsLongMessagesShort) {
+  logger = std::make_shared<Logger>(std::make_unique<ConstantMockTimer>(0_ms),
+                                    logFile,
+                                    Logger::LogLevel::debug,
+                                    Logger::AsyncOptions{});
+
+  LOG_WARN(std::string(1000, 'x'));
+  logger->close();
+
+  const std::string expected = "0 (" + CrossplatformThread::getName() + ") WARN: " +
+                               std::string(sizeof(LogRecord::message) - 1, 'x') + "\n";
+  EXPECT_EQ(std::string(logBuffer, logSize), expected);
+}
+
+TEST_F(LoggerTest, AsyncLoggerIsNotStartedWhenOff) {
+  logger = std::make_shared<Logger>(std::make_unique<ConstantMockTimer>(0_ms),
+                                    logFile,
+                                    Logger::LogLevel::off,
+                                    Logger::AsyncOptions{});
+  EXPECT_FALSE(logger->isAsync());
+}
+
+static void logFromTask(void *params) {
+  auto &logger = *static_cast<std::shared_ptr<Logger> *>(params);
+  LOG_INFO_S("MSG");
+}
+
+TEST_F(LoggerTest, TasksLogTheirName) {
+  logger = std::make_shared<Logger>(
+    std::make_unique<ConstantMockTimer>(0_ms), logFile, Logger::LogLevel::info);
+
+  // Joined when deleted
+  delete new CrossplatformThread(logFromTask, &logger, "Named Task");
+  logger->close();
+
+  EXPECT_EQ(std::string(logBuffer, logSize), "0 (Named Task) INFO: MSG\n");
+}
+
+TEST(CrossplatformThreadTest, SetNameOnlyRenamesTheCallingThread) {
+  const std::string mainName = CrossplatformThread::getName();
+
+  std::string renamed;
+  std::thread([&]() {
+    CrossplatformThread::setName("Renamed");
+    renamed = CrossplatformThread::getCurrentName();
+  }).join();
+
+  EXPECT_EQ(renamed, "Renamed");
+  EXPECT_EQ(CrossplatformThread::getName(), mainName);
+}
+
+// Decodes a binary log into the text lines a text logger would have written
+static std::string decodeBinaryLog(char *ibuffer, const size_t isize) {
+  FILE *in = fmemopen(ibuffer, isize, "rb");
+  char *outBuffer = nullptr;
+  size_t outSize = 0;
+  FILE *out = open_memstream(&outBuffer, &outSize);
+
+  BinaryLogDecoder decoder;
+  EXPECT_TRUE(decoder.decode(in, out));
+
+  fclose(in);
+  fclose(out);
+  std::string text(outBuffer, outSize);
+  free(outBuffer);
+  return text;
+}
+
+TEST_F(LoggerTest, TextLoggerFormatsRecords) {
+  logger = std::make_shared<Logger>(
+    std::make_unique<ConstantMockTimer>(0_ms), logFile, Logger::LogLevel::debug);
+
+  const auto format = logger->registerFormat("New error is {} after {} tries");
+  LOG_DEBUG_RECORD(format, 1.5, 3);
+  logger->close();
+
+  EXPECT_EQ(std::string(logBuffer, logSize),
+            "0 (" + CrossplatformThread::getName() +
+              ") DEBUG: New error is 1.500000 after 3 tries\n");
+}
+
+TEST_F(LoggerTest, BinaryLoggerRoundTrip) {
+  logger = std::make_shared<Logger>(std::make_unique<ConstantMockTimer>(0_ms),
+                                    logFile,
+                                    Logger::LogLevel::info,
+                                    Logger::Encoding::binary);
+
+  const auto format = logger->registerFormat("{} is {} of {}");
+  LOG_INFO_RECORD(format, "kP", 2.5f, -7);
+  LOG_DEBUG_RECORD(format, "kI", 0.0, 1);
+  LOG_WARN(std::string("Plain text"));
+  LOG_ERROR_RECORD(format, true, static_cast<std::uint64_t>(1) << 40, 'c');
+  logger->close();
+
+  const std::string thread = CrossplatformThread::getName();
+  EXPECT_EQ(decodeBinaryLog(logBuffer, logSize),
+            "0.000 (" + thread + ") INFO: kP is 2.500000 of -7\n" + "0.000 (" + thread +
+              ") WARN: Plain text\n" + "0.000 (" + thread +
+              ") ERROR: true is 1099511627776 of 99\n");
+}
+
+TEST_F(LoggerTest, BinaryLoggerIsSmallerThanText) {
+  logger = std::make_shared<Logger>(std::make_unique<ConstantMockTimer>(0_ms),
+                                    logFile,
+                                    Logger::LogLevel::info,
+                                    Logger::Encoding::binary);
+
+  const auto format = logger->registerFormat("PIDTuner: New error is {}");
+  for (int i = 0; i < 100; ++i) {
+    LOG_INFO_RECORD(format, 1.5);
+  }
+  logger->close();
+
+  const std::string text = decodeBinaryLog(logBuffer, logSize);
+  EXPECT_LT(logSize * 3, text.size());
+}
+
+TEST_F(LoggerTest, AsyncBinaryLoggerRoundTrip) {
+  logger = std::make_shared<Logger>(std::make_unique<ConstantMockTimer>(0_ms),
+                                    logFile,
+                                    Logger::LogLevel::debug,
+                                    Logger::AsyncOptions{4, Logger::Overflow::block},
+                                    Logger::Encoding::binary);
+  EXPECT_TRUE(logger->isAsync());
+
+  const auto format = logger->registerFormat("MSG {}");
+  for (int i = 0; i < 100; ++i) {
+    LOG_DEBUG_RECORD(format, i);
+  }
+  logger->close();
+
+  std::string expected;
+  for (int i = 0; i < 100; ++i) {
+    expected +=
+      "0.000 (" + CrossplatformThread::getName() + ") DEBUG: MSG " + std::to_string(i) + "\n";
+  }
+  EXPECT_EQ(decodeBinaryLog(logBuffer, logSize), expected);
+}
+
+TEST_F(LoggerTest, BinaryLoggerCutsLongStringsShort) {
+  logger = std::make_shared<Logger>(std::make_unique<ConstantMockTimer>(0_ms),
+                                    logFile,
+                                    Logger::LogLevel::debug,
+                                    Logger::Encoding::binary);
+
+  const auto format = logger->registerFormat("{}{}");
+  LOG_DEBUG_RECORD(format, std::string(1000, 'x'), 1);
+  logger->close();
+
+  const std::string text = decodeBinaryLog(logBuffer, logSize);
+  EXPECT_LT(text.size(), sizeof(LogRecord::message) + 64);
+  EXPECT_NE(text.find("DEBUG: xxx"), std::string::npos);
+
+  // The string took all the room, so the number after it was left out and its placeholder stays
+  EXPECT_EQ(text.substr(text.size() - 4), "x{}\n");
+}
+
+TEST(BinaryLogTest, FormatFillsPlaceholdersInOrder) {
+  EXPECT_EQ(formatLogMessage("{} and {}", {"a", "b"}), "a and b");
+  EXPECT_EQ(formatLogMessage("{} and {}", {"a"}), "a and {}");
+  EXPECT_EQ(formatLogMessage("{}", {"a", "b"}), "a b");
+  EXPECT_EQ(formatLogMessage("none", {}), "none");
+}
+
+TEST(BinaryLogTest, WriterRejectsArgumentsWhichDoNotFit) {
+  std::uint8_t data[8];
+  BinaryLogWriter writer(data, sizeof(data));
+
+  EXPECT_TRUE(writer.putArg(1));
+  EXPECT_EQ(writer.size(), 5);
+  EXPECT_FALSE(writer.putArg(1.0));
+  EXPECT_EQ(writer.size(), 5);
+  EXPECT_TRUE(writer.isValid());
+}
+
+TEST(BinaryLogTest, DecoderRejectsDamagedLog) {
+  char data[] = {static_cast<char>(BinaryLogBlock::header), 'O', 'K', 'L', 'G', 1,
+                 static_cast<char>(BinaryLogBlock::record), 3, 0};
+  FILE *in = fmemopen(data, sizeof(data), "rb");
+  FILE *out = fopen("/dev/null", "w");
+
+  BinaryLogDecoder decoder;
+  EXPECT_FALSE(decoder.decode(in, out));
+
+  fclose(in);
+  fclose(out);
+}
+
+TEST(LogRingBufferTest, CapacityIsRoundedUpToPowerOfTwo) {
+  EXPECT_EQ(LogRingBuffer(5).getCapacity(), 8);
+  EXPECT_EQ(LogRingBuffer(8).getCapacity(), 8);
+}
+
+TEST(LogRingBufferTest, FullBufferRejectsRecords) {
+  LogRingBuffer buffer(2);
+  const auto fill = [](const long itime) {
+    return [=](LogRecord &record) { record.time = itime; };
+  };
+
+  EXPECT_TRUE(buffer.tryPush(fill(1)));
+  EXPECT_TRUE(buffer.tryPush(fill(2)));
+  EXPECT_FALSE(buffer.tryPush(fill(3)));
+
+  LogRecord record{};
+  ASSERT_TRUE(buffer.tryPop(record));
+  EXPECT_EQ(record.time, 1);
+
+  // Taking a record out makes room for another
+  EXPECT_TRUE(buffer.tryPush(fill(3)));
+  ASSERT_TRUE(buffer.tryPop(record));
+  EXPECT_EQ(record.time, 2);
+  ASSERT_TRUE(buffer.tryPop(record));
+  EXPECT_EQ(record.time, 3);
+  EXPECT_FALSE(buffer.tryPop(record));
+}
+
+TEST(LogRingBufferTest, ConcurrentWritersLoseNothing) {
+  LogRingBuffer buffer(16);
+  constexpr int writers = 4;
+  constexpr int perWriter = 1000;
+
+  std::vector<std::thread> threads;
+  for (int w = 0; w < writers; ++w) {
+    threads.emplace_back([&, w]() {
+      for (int i = 0; i < perWriter; ++i) {
+        while (!buffer.tryPush([&](LogRecord &record) { record.time = w * perWriter + i; })) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  // Each writer's records must come out in the order it wrote them
+  std::vector<long> last(writers, -1);
+  int count = 0;
+  LogRecord record{};
+  while (count < writers * perWriter) {
+    if (buffer.tryPop(record)) {
+      const int writer = static_cast<int>(record.time / perWriter);
+      EXPECT_GT(record.time, last[writer]);
+      last[writer] = record.time;
+      ++count;
+    }
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
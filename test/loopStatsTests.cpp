@@ -0,0 +1,174 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/util/loopStats.hpp"
+#include "test/tests/api/implMocks.hpp"
+#include <gtest/gtest.h>
+
+using namespace okapi;
+
+/**
+ * A timer which reads a clock shared with a SteppedRate.
+ */
+class SteppedTimer : public AbstractTimer {
+  public:
+  explicit SteppedTimer(std::shared_ptr<QTime> inow) : AbstractTimer(0_ms), now(std::move(inow)) {
+  }
+
+  QTime millis() const override {
+    return *now;
+  }
+
+  std::shared_ptr<QTime> now;
+};
+
+/**
+ * A rate which moves the shared clock forward by a set amount each time the loop delays.
+ */
+class SteppedRate : public AbstractRate {
+  public:
+  explicit SteppedRate(std::shared_ptr<QTime> inow) : now(std::move(inow)) {
+  }
+
+  void delay(QFrequency) override {
+  }
+
+  void delayUntil(QTime) override {
+    *now += nextDelay;
+  }
+
+  void delayUntil(uint32_t) override {
+    *now += nextDelay;
+  }
+
+  std::shared_ptr<QTime> now;
+  QTime nextDelay{0_ms};
+};
+
+class LoopStatsTest : public ::testing::Test {
+  protected:
+  void SetUp() override {
+    now = std::make_shared<QTime>(0_ms);
+    rate = std::make_unique<SteppedRate>(now);
+    stats = std::make_unique<LoopStats>("Test Loop", std::make_unique<SteppedTimer>(now));
+  }
+
+  // Runs one iteration which takes iwork, then delays for idelay
+  void iterate(const QTime iwork, const QTime idelay) {
+    *now += iwork;
+    rate->nextDelay = idelay;
+    stats->delayUntil(*rate, 10_ms);
+  }
+
+  std::shared_ptr<QTime> now;
+  std::unique_ptr<SteppedRate> rate;
+  std::unique_ptr<LoopStats> stats;
+};
+
+TEST_F(LoopStatsTest, NothingIsMeasuredUntilEnabled) {
+  EXPECT_FALSE(stats->isEnabled());
+
+  for (int i = 0; i < 5; ++i) {
+    iterate(2_ms, 8_ms);
+  }
+
+  EXPECT_EQ(stats->getSummary().iterations, 0);
+}
+
+TEST_F(LoopStatsTest, MeasuresDurationJitterAndOverruns) {
+  stats->setEnabled(true);
+
+  // The first iteration only marks when the loop woke up
+  iterate(2_ms, 8_ms);
+  iterate(3_ms, 7_ms);
+  iterate(12_ms, 0_ms);
+  iterate(2_ms, 9_ms);
+
+  const auto summary = stats->getSummary();
+  EXPECT_EQ(summary.iterations, 3);
+  EXPECT_EQ(summary.overruns, 1);
+  EXPECT_NEAR(summary.meanDuration.convert(millisecond), 17.0 / 3, 1e-3);
+  EXPECT_DOUBLE_EQ(summary.maxDuration.convert(millisecond), 12);
+  EXPECT_DOUBLE_EQ(summary.meanJitter.convert(millisecond), 1);
+  EXPECT_DOUBLE_EQ(summary.maxJitter.convert(millisecond), 2);
+
+  std::array<std::size_t, LoopStats::histogramSize> histogram{};
+  histogram[2] = 1;
+  histogram[3] = 1;
+  histogram[12] = 1;
+  EXPECT_EQ(summary.histogram, histogram);
+}
+
+TEST_F(LoopStatsTest, LongIterationsGoInTheLastBucket) {
+  stats->setEnabled(true);
+  iterate(0_ms, 10_ms);
+  iterate(100_ms, 0_ms);
+
+  EXPECT_EQ(stats->getSummary().histogram.back(), 1);
+}
+
+TEST_F(LoopStatsTest, TimeSpentDisabledIsNotCounted) {
+  stats->setEnabled(true);
+  iterate(1_ms, 9_ms);
+  iterate(1_ms, 9_ms);
+
+  stats->setEnabled(false);
+  iterate(500_ms, 0_ms);
+
+  stats->setEnabled(true);
+  iterate(1_ms, 9_ms);
+  iterate(1_ms, 9_ms);
+
+  const auto summary = stats->getSummary();
+  EXPECT_EQ(summary.iterations, 2);
+  EXPECT_EQ(summary.overruns, 0);
+  EXPECT_DOUBLE_EQ(summary.maxDuration.convert(millisecond), 1);
+  EXPECT_DOUBLE_EQ(summary.maxJitter.convert(millisecond), 0);
+}
+
+TEST_F(LoopStatsTest, ResetClearsEverything) {
+  stats->setEnabled(true);
+  iterate(1_ms, 9_ms);
+  iterate(20_ms, 0_ms);
+
+  stats->reset();
+
+  const auto summary = stats->getSummary();
+  EXPECT_EQ(summary.iterations, 0);
+  EXPECT_EQ(summary.overruns, 0);
+  EXPECT_DOUBLE_EQ(summary.maxDuration.convert(millisecond), 0);
+  EXPECT_DOUBLE_EQ(summary.maxJitter.convert(millisecond), 0);
+  EXPECT_EQ(summary.histogram, (std::array<std::size_t, LoopStats::histogramSize>{}));
+}
+
+TEST_F(LoopStatsTest, LogsASummary) {
+  char *logBuffer = nullptr;
+  size_t logSize = 0;
+  FILE *logFile = open_memstream(&logBuffer, &logSize);
+  auto logger = std::make_shared<Logger>(
+    std::make_unique<ConstantMockTimer>(0_ms), logFile, Logger::LogLevel::info);
+
+  stats->setEnabled(true);
+  iterate(1_ms, 9_ms);
+  iterate(3_ms, 7_ms);
+  stats->log(logger);
+  logger->close();
+
+  const std::string log(logBuffer, logSize);
+  free(logBuffer);
+
+  EXPECT_NE(log.find("INFO: Test Loop: 1 iterations, 0 overruns"), std::string::npos);
+  EXPECT_NE(log.find("iterations by duration in ms: 0 0 0 1 0"), std::string::npos);
+}
+
+TEST(LoopStatsWithoutTimerTest, CannotBeEnabled) {
+  LoopStats stats("Test Loop", nullptr);
+  stats.setEnabled(true);
+  EXPECT_FALSE(stats.isEnabled());
+
+  MockRate rate;
+  stats.delayUntil(rate, 1_ms);
+  EXPECT_EQ(stats.getSummary().iterations, 0);
+}
@@ -0,0 +1,292 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/pathfinderUtil.hpp"
+#include <cmath>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace okapi;
+
+class PathfinderTest : public ::testing::Test {
+  protected:
+  void prepare(const int isampleCount) {
+    scratch.reserve(static_cast<int>(points.size()), 0);
+    ASSERT_EQ(pathfinder_prepare_into(points.data(),
+                                      static_cast<int>(points.size()),
+                                      FIT_HERMITE_CUBIC,
+                                      isampleCount,
+                                      0.01,
+                                      1.0,
+                                      2.0,
+                                      10.0,
+                                      &candidate,
+                                      scratch.splines(),
+                                      scratch.splineLengths()),
+              0);
+    scratch.reserve(static_cast<int>(points.size()), candidate.length, isampleCount);
+  }
+
+  std::vector<Waypoint> points{{0, 0, 0}, {1, 0.5, 0.7}, {1.5, 1.5, 1.5}};
+  TrajectoryCandidate candidate{};
+  PathfinderScratch scratch;
+};
+
+TEST_F(PathfinderTest, TableProgressMatchesSampledProgress) {
+  constexpr int sampleCount = PATHFINDER_SAMPLES_FAST;
+  prepare(sampleCount);
+
+  const Spline &spline = scratch.splines()[0];
+  const double length = scratch.splineLengths()[0];
+  pf_spline_distance_table(spline, sampleCount, scratch.table());
+
+  for (double distance = 0; distance <= length * 1.1; distance += length / 97) {
+    EXPECT_DOUBLE_EQ(pf_spline_progress_for_distance_table(
+                       spline, distance, sampleCount, scratch.table()),
+                     pf_spline_progress_for_distance(spline, distance, sampleCount));
+  }
+}
+
+TEST_F(PathfinderTest, TableGenerationMatchesSampledGeneration) {
+  prepare(PATHFINDER_SAMPLES_LOW);
+
+  std::vector<Segment> sampled(candidate.length);
+  std::vector<Segment> table(candidate.length);
+  pathfinder_generate_into(&candidate, sampled.data(), scratch.buffer());
+  pathfinder_generate_lut(&candidate, table.data(), scratch.buffer(), scratch.table());
+
+  for (int i = 0; i < candidate.length; ++i) {
+    EXPECT_DOUBLE_EQ(table[i].x, sampled[i].x);
+    EXPECT_DOUBLE_EQ(table[i].y, sampled[i].y);
+    EXPECT_DOUBLE_EQ(table[i].heading, sampled[i].heading);
+    EXPECT_DOUBLE_EQ(table[i].velocity, sampled[i].velocity);
+  }
+}
+
+TEST_F(PathfinderTest, GaussLengthOfStraightLine) {
+  Spline spline;
+  pf_fit_hermite_cubic(Waypoint{0, 0, 0}, Waypoint{2, 0, 0}, &spline);
+  EXPECT_NEAR(pf_spline_distance_gauss(&spline, 1e-9), 2, 1e-12);
+  EXPECT_NEAR(spline.arc_length, 2, 1e-12);
+  EXPECT_NEAR(pf_spline_progress_for_distance_gauss(spline, 0.5, 1e-9), 0.25, 1e-9);
+}
+
+TEST_F(PathfinderTest, GaussLengthMatchesManySamples) {
+  prepare(PATHFINDER_SAMPLES_HIGH);
+  std::vector<double> sampledLengths(scratch.splineLengths(),
+                                     scratch.splineLengths() + points.size() - 1);
+
+  ASSERT_EQ(pathfinder_prepare_gauss_into(points.data(),
+                                          static_cast<int>(points.size()),
+                                          FIT_HERMITE_CUBIC,
+                                          1e-9,
+                                          0.01,
+                                          1.0,
+                                          2.0,
+                                          10.0,
+                                          &candidate,
+                                          scratch.splines(),
+                                          scratch.splineLengths()),
+            0);
+
+  // The sampled length converges on the true length from above as the sample count grows
+  for (std::size_t i = 0; i < sampledLengths.size(); ++i) {
+    EXPECT_NEAR(scratch.splineLengths()[i], sampledLengths[i], 1e-4);
+    EXPECT_LT(scratch.splineLengths()[i], sampledLengths[i]);
+  }
+}
+
+TEST_F(PathfinderTest, GaussProgressFromKnownPointMatchesProgress) {
+  Spline spline;
+  pf_fit_hermite_cubic(points[0], points[1], &spline);
+  const double length = pf_spline_distance_gauss(&spline, 1e-9);
+
+  double from = 0;
+  double fromDistance = 0;
+  for (double distance = length / 50; distance < length; distance += length / 50) {
+    const double progress = pf_spline_progress_for_distance_gauss(spline, distance, 1e-9);
+    EXPECT_NEAR(
+      pf_spline_progress_for_distance_gauss_from(spline, distance, 1e-9, &from, &fromDistance),
+      progress,
+      1e-8);
+    EXPECT_NEAR(fromDistance, distance, 1e-9);
+  }
+}
+
+TEST_F(PathfinderTest, GaussGenerationEndsAtLastWaypoint) {
+  scratch.reserve(static_cast<int>(points.size()), 0);
+  ASSERT_EQ(pathfinder_prepare_gauss_into(points.data(),
+                                          static_cast<int>(points.size()),
+                                          FIT_HERMITE_CUBIC,
+                                          1e-6,
+                                          0.01,
+                                          1.0,
+                                          2.0,
+                                          10.0,
+                                          &candidate,
+                                          scratch.splines(),
+                                          scratch.splineLengths()),
+            0);
+  scratch.reserve(static_cast<int>(points.size()), candidate.length);
+
+  std::vector<Segment> segments(candidate.length);
+  pathfinder_generate_into(&candidate, segments.data(), scratch.buffer());
+
+  EXPECT_NEAR(segments.back().x, points.back().x, 1e-4);
+  EXPECT_NEAR(segments.back().y, points.back().y, 1e-4);
+}
+
+TEST_F(PathfinderTest, QuinticCurvatureFitHitsEndConditions) {
+  Spline spline;
+  pf_fit_hermite_quintic_curvature(Waypoint{0, 0, 0.3}, Waypoint{1, 1, 1.2}, 0.5, -0.8, &spline);
+
+  const Coord end = pf_spline_coords(spline, 1);
+  EXPECT_NEAR(end.x, 1, 1e-9);
+  EXPECT_NEAR(end.y, 1, 1e-9);
+  EXPECT_NEAR(pf_spline_angle(spline, 0), 0.3, 1e-9);
+  EXPECT_NEAR(pf_spline_angle(spline, 1), 1.2, 1e-9);
+  EXPECT_NEAR(pf_spline_curvature(spline, 0), 0.5, 1e-9);
+  EXPECT_NEAR(pf_spline_curvature(spline, 1), -0.8, 1e-9);
+}
+
+TEST_F(PathfinderTest, CurvatureContinuousFitMatchesCurvatureAtWaypoints) {
+  std::vector<Spline> cubic(points.size() - 1);
+  std::vector<Spline> continuous(points.size() - 1);
+  for (std::size_t i = 0; i < cubic.size(); ++i) {
+    pf_fit_hermite_cubic(points[i], points[i + 1], &cubic[i]);
+  }
+  pf_fit_hermite_curvature_continuous(
+    points.data(), static_cast<int>(points.size()), continuous.data());
+
+  // Cubic splines jump in curvature at the inner waypoint
+  EXPECT_GT(std::abs(pf_spline_curvature(cubic[0], 1) - pf_spline_curvature(cubic[1], 0)), 0.1);
+
+  EXPECT_NEAR(pf_spline_curvature(continuous[0], 1), pf_spline_curvature(continuous[1], 0), 1e-9);
+  EXPECT_NEAR(pf_spline_curvature(continuous[0], 0), 0, 1e-9);
+  EXPECT_NEAR(pf_spline_curvature(continuous[1], 1), 0, 1e-9);
+}
+
+TEST_F(PathfinderTest, PrepareWithEachFit) {
+  for (auto fit : {PathfinderFit::hermiteCubic,
+                   PathfinderFit::hermiteQuintic,
+                   PathfinderFit::curvatureContinuous}) {
+    PathfinderLimits limits{1.0, 2.0, 10.0, fit};
+    const int length = preparePathfinderCandidate(points, limits, 0.01, scratch, candidate);
+    ASSERT_GT(length, 0);
+
+    scratch.reserve(static_cast<int>(points.size()), length);
+    std::vector<Segment> segments(length);
+    pathfinder_generate_into(&candidate, segments.data(), scratch.buffer());
+
+    EXPECT_NEAR(segments.back().x, points.back().x, 1e-4);
+    EXPECT_NEAR(segments.back().y, points.back().y, 1e-4);
+  }
+}
+
+TEST_F(PathfinderTest, PrepareSingleWaypoint) {
+  std::vector<Waypoint> point{{0, 0, 0}};
+  EXPECT_LT(preparePathfinderCandidate(point, {1.0, 2.0, 10.0}, 0.01, scratch, candidate), 0);
+}
+
+TEST_F(PathfinderTest, WheelLimitsKeepBothWheelsUnderLimit) {
+  constexpr double wheelTrack = 0.5;
+  const auto maxWheelVelocity = [&](const PathfinderLimits &ilimits) {
+    const int length = generatePathfinderTrajectory(candidate, ilimits, wheelTrack, scratch);
+    EXPECT_GT(length, 0);
+
+    std::vector<Segment> left(length);
+    std::vector<Segment> right(length);
+    pathfinder_modify_tank(scratch.segments(), length, left.data(), right.data(), wheelTrack);
+
+    const Segment &last = scratch.segments()[length - 1];
+    EXPECT_NEAR(last.x, points.back().x, 1e-4);
+    EXPECT_NEAR(last.y, points.back().y, 1e-4);
+
+    double maxVelocity = 0;
+    for (int i = 0; i < length; ++i) {
+      maxVelocity = std::max({maxVelocity, left[i].velocity, right[i].velocity});
+    }
+    return maxVelocity;
+  };
+
+  PathfinderLimits limits{1.0, 2.0, 10.0};
+  ASSERT_GT(preparePathfinderCandidate(points, limits, 0.01, scratch, candidate), 0);
+  EXPECT_GT(maxWheelVelocity(limits), 1.1);
+
+  limits.maxWheelVel = 1.0;
+  limits.maxWheelAccel = 2.0;
+  ASSERT_GT(preparePathfinderCandidate(points, limits, 0.01, scratch, candidate), 0);
+  const double maxVelocity = maxWheelVelocity(limits);
+  EXPECT_LE(maxVelocity, 1.0 + 1e-3);
+  EXPECT_GT(maxVelocity, 0.9);
+}
+
+TEST_F(PathfinderTest, StartAndEndVelocities) {
+  PathfinderLimits limits{1.0, 2.0, 10.0};
+  limits.startVel = 0.5;
+  limits.endVel = 0.3;
+  ASSERT_GT(preparePathfinderCandidate(points, limits, 0.01, scratch, candidate), 0);
+
+  const int length = generatePathfinderTrajectory(candidate, limits, 0.5, scratch);
+  ASSERT_GT(length, 0);
+
+  const Segment &first = scratch.segments()[0];
+  const Segment &last = scratch.segments()[length - 1];
+  EXPECT_NEAR(first.velocity, 0.5, 2.0 * 0.01 + 1e-6);
+  EXPECT_LE(std::abs(first.acceleration), limits.maxAccel + 1e-6);
+  EXPECT_NEAR(last.velocity, 0.3, 1e-6);
+  EXPECT_NEAR(last.x, points.back().x, 1e-4);
+  EXPECT_NEAR(last.y, points.back().y, 1e-4);
+}
+
+TEST_F(PathfinderTest, PrepareReusesCachedSplines) {
+  const PathfinderLimits limits{1.0, 2.0, 10.0};
+  ASSERT_GT(preparePathfinderCandidate(points, limits, 0.01, scratch, candidate), 0);
+  const std::vector<Spline> splines(scratch.splines(), scratch.splines() + 2);
+  std::vector<double> lengths(scratch.splineLengths(), scratch.splineLengths() + 2);
+  const double totalLength = candidate.totalLength;
+
+  // Reusing the last spline gives the same path
+  TrajectoryCandidate reused{};
+  ASSERT_GT(
+    preparePathfinderCandidate(points, limits, 0.01, &splines[1], &lengths[1], 1, scratch, reused),
+    0);
+  EXPECT_NEAR(reused.totalLength, totalLength, 1e-9);
+  EXPECT_EQ(reused.length, candidate.length);
+
+  // The cached length is used as it is instead of being measured again
+  lengths[1] += 1;
+  ASSERT_GT(
+    preparePathfinderCandidate(points, limits, 0.01, &splines[1], &lengths[1], 1, scratch, reused),
+    0);
+  EXPECT_NEAR(reused.totalLength, totalLength + 1, 1e-9);
+}
+
+TEST_F(PathfinderTest, SampledLengthsMatchQuadrature) {
+  PathfinderLimits limits{1.0, 2.0, 10.0};
+  ASSERT_GT(preparePathfinderCandidate(points, limits, 0.01, scratch, candidate), 0);
+  const double totalLength = candidate.totalLength;
+
+  limits.lengthTolerance = 0;
+  limits.lengthSamples = PATHFINDER_SAMPLES_HIGH;
+  ASSERT_GT(preparePathfinderCandidate(points, limits, 0.01, scratch, candidate), 0);
+  EXPECT_NEAR(candidate.totalLength, totalLength, 1e-4);
+  EXPECT_EQ(candidate.config.sample_count, PATHFINDER_SAMPLES_HIGH);
+
+  // Both the plain and the wheel-limited generators look segments up in the table
+  for (const double maxWheelVel : {0.0, 1.0}) {
+    limits.maxWheelVel = maxWheelVel;
+    ASSERT_GT(preparePathfinderCandidate(points, limits, 0.01, scratch, candidate), 0);
+    const int length = generatePathfinderTrajectory(candidate, limits, 0.5, scratch);
+    ASSERT_GT(length, 0);
+
+    const Segment &last = scratch.segments()[length - 1];
+    EXPECT_NEAR(last.x, points.back().x, 1e-3);
+    EXPECT_NEAR(last.y, points.back().y, 1e-3);
+  }
+
+  limits.lengthSamples = 0;
+  EXPECT_LT(preparePathfinderCandidate(points, limits, 0.01, scratch, candidate), 0);
+}
@@ -0,0 +1,76 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/playbackTrajectory.hpp"
+#include <gtest/gtest.h>
+
+using namespace okapi;
+
+class PlaybackTrajectoryTest : public ::testing::Test {
+  protected:
+  void SetUp() override {
+    for (int i = 0; i < length; ++i) {
+      left[i] = Segment{0.01, 0, 0, 0, 0.013 * i, 0, 0, 0};
+      right[i] = Segment{0.01, 0, 0, 0, -0.021 * i, 0, 0, 0};
+    }
+  }
+
+  static constexpr int length = 100;
+
+  Segment left[length];
+  Segment right[length];
+  const Segment *sides[2]{left, right};
+};
+
+TEST_F(PlaybackTrajectoryTest, DefaultIsEmpty) {
+  PlaybackTrajectory trajectory;
+  EXPECT_EQ(trajectory.getSides(), 0);
+  EXPECT_EQ(trajectory.getLength(), 0);
+  EXPECT_EQ(trajectory.getSize(), 0);
+}
+
+TEST_F(PlaybackTrajectoryTest, Float32KeepsVelocities) {
+  PlaybackTrajectory trajectory(sides, 2, length);
+
+  EXPECT_EQ(trajectory.getSides(), 2);
+  EXPECT_EQ(trajectory.getLength(), length);
+  EXPECT_DOUBLE_EQ(trajectory.getDt(), 0.01);
+  EXPECT_EQ(trajectory.getEncoding(), PlaybackTrajectory::encoding::float32);
+  EXPECT_EQ(trajectory.getSize(), 2 * length * sizeof(float));
+
+  for (int i = 0; i < length; ++i) {
+    EXPECT_FLOAT_EQ(trajectory.getVelocity(0, i), left[i].velocity);
+    EXPECT_FLOAT_EQ(trajectory.getVelocity(1, i), right[i].velocity);
+  }
+}
+
+TEST_F(PlaybackTrajectoryTest, Int16QuantizesVelocities) {
+  PlaybackTrajectory trajectory(sides, 2, length, PlaybackTrajectory::encoding::int16);
+
+  EXPECT_EQ(trajectory.getEncoding(), PlaybackTrajectory::encoding::int16);
+  EXPECT_LT(trajectory.getSize(), 2 * length * sizeof(float));
+
+  // Each side is quantized relative to its own fastest velocity
+  const double leftStep = 0.013 * (length - 1) / 32767;
+  const double rightStep = 0.021 * (length - 1) / 32767;
+  for (int i = 0; i < length; ++i) {
+    EXPECT_NEAR(trajectory.getVelocity(0, i), left[i].velocity, leftStep);
+    EXPECT_NEAR(trajectory.getVelocity(1, i), right[i].velocity, rightStep);
+  }
+
+  EXPECT_DOUBLE_EQ(trajectory.getVelocity(0, length - 1), left[length - 1].velocity);
+  EXPECT_DOUBLE_EQ(trajectory.getVelocity(1, length - 1), right[length - 1].velocity);
+}
+
+TEST_F(PlaybackTrajectoryTest, Int16WithOnlyZeroVelocities) {
+  for (auto &segment : left) {
+    segment.velocity = 0;
+  }
+
+  PlaybackTrajectory trajectory(sides, 1, length, PlaybackTrajectory::encoding::int16);
+  for (int i = 0; i < length; ++i) {
+    EXPECT_EQ(trajectory.getVelocity(0, i), 0);
+  }
+}
@@ -0,0 +1,33 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/ramseteFollower.hpp"
+#include <gtest/gtest.h>
+
+using namespace okapi;
+
+TEST(RamseteFollowerTest, OnTargetOutputsTargetVelocity) {
+  RamseteFollower follower;
+  const auto output = follower.step({1, 2, 0.5}, 1.5, 0.3, {1, 2, 0.5});
+  EXPECT_DOUBLE_EQ(output.linear, 1.5);
+  EXPECT_DOUBLE_EQ(output.angular, 0.3);
+}
+
+TEST(RamseteFollowerTest, SpeedsUpWhenBehind) {
+  RamseteFollower follower;
+  const auto output = follower.step({1, 0, 0}, 1, 0, {0.9, 0, 0});
+  EXPECT_GT(output.linear, 1);
+  EXPECT_DOUBLE_EQ(output.angular, 0);
+}
+
+TEST(RamseteFollowerTest, TurnsTowardPath) {
+  RamseteFollower follower;
+
+  // The robot is to the right of the path, so it turns left (counterclockwise)
+  EXPECT_GT(follower.step({1, 0, 0}, 1, 0, {1, -0.1, 0}).angular, 0);
+
+  // The robot is pointed to the left of the path, so it turns right (clockwise)
+  EXPECT_LT(follower.step({1, 0, 0}, 1, 0, {1, 0, 0.2}).angular, 0);
+}
@@ -0,0 +1,105 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/sCurveProfile.hpp"
+#include <cmath>
+#include <gtest/gtest.h>
+
+using namespace okapi;
+
+// Checks that a profile starts and ends at rest, stays within its limits, and that its velocity
+// and acceleration are the derivatives of its position and velocity
+static void assertProfileIsConsistent(const SCurveProfile &profile,
+                                      const double maxVel,
+                                      const double maxAccel,
+                                      const double maxJerk) {
+  constexpr double dt = 1e-4;
+  const double duration = profile.getDuration();
+
+  SCurveProfile::State last = profile.sample(0);
+  EXPECT_DOUBLE_EQ(last.position, 0);
+  EXPECT_DOUBLE_EQ(last.velocity, 0);
+
+  for (double t = dt; t < duration; t += dt) {
+    const auto state = profile.sample(t);
+
+    EXPECT_LE(std::abs(state.velocity), maxVel * (1 + 1e-9));
+    EXPECT_LE(std::abs(state.acceleration), maxAccel * (1 + 1e-9));
+    EXPECT_NEAR((state.position - last.position) / dt, (state.velocity + last.velocity) / 2, 1e-3);
+
+    // The acceleration of a trapezoid jumps, so only the S-curve's is continuous
+    if (maxJerk > 0) {
+      EXPECT_NEAR(
+        (state.velocity - last.velocity) / dt, (state.acceleration + last.acceleration) / 2, 1e-1);
+      EXPECT_LE(std::abs(state.acceleration - last.acceleration) / dt, maxJerk * (1 + 1e-6));
+    }
+
+    last = state;
+  }
+
+  const auto end = profile.sample(duration);
+  EXPECT_NEAR(end.position, profile.getDistance(), 1e-9);
+  EXPECT_DOUBLE_EQ(end.velocity, 0);
+  EXPECT_DOUBLE_EQ(profile.sample(duration + 1).position, end.position);
+}
+
+TEST(SCurveProfileTest, DefaultIsEmpty) {
+  SCurveProfile profile;
+  EXPECT_EQ(profile.getDuration(), 0);
+  EXPECT_EQ(profile.sample(1).position, 0);
+}
+
+TEST(SCurveProfileTest, LongTrapezoidCruisesAtMaxVelocity) {
+  SCurveProfile profile(10, 2, 4);
+
+  // Accelerating and slowing down take half a second each and cover a meter together
+  EXPECT_DOUBLE_EQ(profile.getDuration(), 0.5 + 9.0 / 2 + 0.5);
+  EXPECT_DOUBLE_EQ(profile.sample(2).velocity, 2);
+  EXPECT_DOUBLE_EQ(profile.sample(0.25).acceleration, 4);
+  EXPECT_DOUBLE_EQ(profile.sample(5.25).acceleration, -4);
+  assertProfileIsConsistent(profile, 2, 4, 0);
+}
+
+TEST(SCurveProfileTest, ShortTrapezoidPeaksBelowMaxVelocity) {
+  SCurveProfile profile(1, 10, 4);
+
+  EXPECT_DOUBLE_EQ(profile.getDuration(), 2 * std::sqrt(1.0 / 4));
+  EXPECT_DOUBLE_EQ(profile.sample(profile.getDuration() / 2).velocity, std::sqrt(4.0));
+  assertProfileIsConsistent(profile, 10, 4, 0);
+}
+
+TEST(SCurveProfileTest, SCurveStaysWithinLimitsAtEveryLength) {
+  // From too short to reach either limit to long enough to cruise
+  for (const double distance : {0.01, 0.1, 0.5, 1.0, 2.0, 10.0}) {
+    SCurveProfile profile(distance, 2, 4, 20);
+    assertProfileIsConsistent(profile, 2, 4, 20);
+  }
+}
+
+TEST(SCurveProfileTest, SCurveWhichNeverReachesMaxAccel) {
+  SCurveProfile profile(5, 1, 10, 10);
+
+  EXPECT_DOUBLE_EQ(profile.sample(profile.getDuration() / 2).velocity, 1);
+  assertProfileIsConsistent(profile, 1, 10, 10);
+}
+
+TEST(SCurveProfileTest, SCurveTakesLongerThanTrapezoid) {
+  EXPECT_GT(SCurveProfile(1, 2, 4, 20).getDuration(), SCurveProfile(1, 2, 4).getDuration());
+}
+
+TEST(SCurveProfileTest, NegativeDistanceIsMirrored) {
+  SCurveProfile forward(3, 2, 4, 20);
+  SCurveProfile backward(-3, 2, 4, 20);
+
+  EXPECT_DOUBLE_EQ(backward.getDuration(), forward.getDuration());
+  EXPECT_DOUBLE_EQ(backward.getDistance(), -3);
+
+  for (const double t : {0.1, 0.7, 1.3}) {
+    EXPECT_DOUBLE_EQ(backward.sample(t).position, -forward.sample(t).position);
+    EXPECT_DOUBLE_EQ(backward.sample(t).velocity, -forward.sample(t).velocity);
+  }
+
+  assertProfileIsConsistent(backward, 2, 4, 20);
+}
@@ -0,0 +1,268 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/trajectoryCache.hpp"
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+using namespace okapi;
+
+class TrajectoryCacheTest : public ::testing::Test {
+  protected:
+  void SetUp() override {
+    header.sides = 2;
+    header.length = length;
+    header.dt = 0.01;
+    header.limits = {1, 2, 10};
+    header.wheelTrack = 0.5;
+
+    for (int i = 0; i < length; ++i) {
+      left[i] = Segment{0.01, 0, 0, 0.1 * i, 1, 0, 0, 0};
+      right[i] = Segment{0.01, 0, 0, 0.2 * i, 2, 0, 0, 0};
+    }
+  }
+
+  static constexpr int length = 10;
+  static constexpr std::size_t entrySize = 2 * length * sizeof(Segment);
+
+  TrajectoryFileHeader header;
+  Segment left[length];
+  Segment right[length];
+  const Segment *sides[2]{left, right};
+  std::vector<Waypoint> points{{0, 0, 0}, {1, 0, 0}};
+};
+
+TEST_F(TrajectoryCacheTest, KeyDependsOnAllInputs) {
+  const auto key = TrajectoryCache::makeKey(points, header.limits, 0.5, 0.01, 2);
+
+  EXPECT_EQ(key, TrajectoryCache::makeKey(points, header.limits, 0.5, 0.01, 2));
+  EXPECT_NE(key, TrajectoryCache::makeKey({{0, 0, 0}, {1, 1, 0}}, header.limits, 0.5, 0.01, 2));
+  EXPECT_NE(key, TrajectoryCache::makeKey(points, {1, 2, 11}, 0.5, 0.01, 2));
+  EXPECT_NE(key, TrajectoryCache::makeKey(points, header.limits, 0.6, 0.01, 2));
+  EXPECT_NE(key, TrajectoryCache::makeKey(points, header.limits, 0.5, 0.02, 2));
+  EXPECT_NE(key, TrajectoryCache::makeKey(points, header.limits, 0.5, 0.01, 1));
+}
+
+TEST_F(TrajectoryCacheTest, FindMissingEntry) {
+  TrajectoryCache cache;
+  EXPECT_EQ(cache.find(1), nullptr);
+}
+
+TEST_F(TrajectoryCacheTest, InsertThenFind) {
+  TrajectoryCache cache;
+  cache.insert(1, header, sides);
+
+  auto entry = cache.find(1);
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->header.length, length);
+  EXPECT_EQ(entry->header.sides, 2);
+  EXPECT_EQ(cache.getSize(), entrySize);
+
+  for (int i = 0; i < length; ++i) {
+    EXPECT_DOUBLE_EQ(entry->side(0)[i].position, left[i].position);
+    EXPECT_DOUBLE_EQ(entry->side(1)[i].position, right[i].position);
+  }
+}
+
+TEST_F(TrajectoryCacheTest, LeastRecentlyUsedEntryIsEvicted) {
+  TrajectoryCache cache(2 * entrySize);
+  cache.insert(1, header, sides);
+  cache.insert(2, header, sides);
+
+  // Use the first entry so the second one is evicted next
+  EXPECT_NE(cache.find(1), nullptr);
+  cache.insert(3, header, sides);
+
+  EXPECT_NE(cache.find(1), nullptr);
+  EXPECT_EQ(cache.find(2), nullptr);
+  EXPECT_NE(cache.find(3), nullptr);
+  EXPECT_EQ(cache.getSize(), 2 * entrySize);
+}
+
+TEST_F(TrajectoryCacheTest, ShrinkingMaxSizeEvicts) {
+  TrajectoryCache cache;
+  cache.insert(1, header, sides);
+  cache.insert(2, header, sides);
+
+  cache.setMaxSize(entrySize);
+  EXPECT_EQ(cache.find(1), nullptr);
+  EXPECT_NE(cache.find(2), nullptr);
+
+  cache.setMaxSize(0);
+  EXPECT_EQ(cache.getSize(), 0);
+}
+
+TEST_F(TrajectoryCacheTest, ReinsertingDoesNotGrowSize) {
+  TrajectoryCache cache;
+  cache.insert(1, header, sides);
+  cache.insert(1, header, sides);
+  EXPECT_EQ(cache.getSize(), entrySize);
+}
+
+TEST_F(TrajectoryCacheTest, EntriesArePersistedToDirectory) {
+  char directory[] = "/tmp/okapiTrajectoryCacheXXXXXX";
+  ASSERT_NE(mkdtemp(directory), nullptr);
+
+  {
+    TrajectoryCache cache;
+    cache.setDirectory(directory);
+    cache.insert(1, header, sides);
+  }
+
+  TrajectoryCache cache(0);
+  EXPECT_EQ(cache.find(1), nullptr);
+
+  cache.setDirectory(directory);
+  auto entry = cache.find(1);
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->header.length, length);
+  EXPECT_DOUBLE_EQ(entry->header.wheelTrack, 0.5);
+  EXPECT_DOUBLE_EQ(entry->side(1)[length - 1].position, right[length - 1].position);
+
+  remove((std::string(directory) + "/0000000000000001.traj").c_str());
+  rmdir(directory);
+}
+
+TEST_F(TrajectoryCacheTest, FileHeaderRoundTrip) {
+  header.limits.fit = PathfinderFit::curvatureContinuous;
+  header.limits.endVel = 0.25;
+
+  FILE *file = tmpfile();
+  ASSERT_NE(file, nullptr);
+  ASSERT_TRUE(writeTrajectoryFile(file, header, sides));
+  rewind(file);
+
+  TrajectoryFileHeader read;
+  ASSERT_TRUE(readTrajectoryFileHeader(file, read));
+  EXPECT_EQ(read.sides, 2);
+  EXPECT_EQ(read.length, length);
+  EXPECT_DOUBLE_EQ(read.dt, 0.01);
+  EXPECT_DOUBLE_EQ(read.wheelTrack, 0.5);
+  EXPECT_EQ(read.limits, header.limits);
+
+  Segment readLeft[length];
+  Segment readRight[length];
+  Segment *readSides[2]{readLeft, readRight};
+  ASSERT_TRUE(readTrajectoryFileSegments(file, read, readSides));
+  EXPECT_DOUBLE_EQ(readRight[length - 1].position, right[length - 1].position);
+  fclose(file);
+}
+
+TEST_F(TrajectoryCacheTest, FileHeaderFieldsAreLittleEndian) {
+  FILE *file = tmpfile();
+  ASSERT_NE(file, nullptr);
+  ASSERT_TRUE(writeTrajectoryFile(file, header, sides));
+  rewind(file);
+
+  std::uint8_t prefix[20];
+  ASSERT_EQ(fread(prefix, sizeof(prefix), 1, file), 1);
+  fclose(file);
+
+  EXPECT_EQ(std::string(reinterpret_cast<char *>(prefix), 4), "OKPT");
+  EXPECT_EQ(prefix[4], TrajectoryFileHeader::currentVersion);
+  EXPECT_EQ(prefix[12], 2);
+  EXPECT_EQ(prefix[16], length);
+}
+
+TEST_F(TrajectoryCacheTest, FileHeaderToleratesMissingAndUnknownFields) {
+  // An older file with only sides, length and dt, followed by a newer file with an extra field
+  const std::uint8_t older[] = {
+    'O', 'K', 'P', 'T',              // Magic number
+    TrajectoryFileHeader::oldestReadableVersion, 0, 0, 0, // Version
+    16,  0,   0,   0,                // Size of the fields
+    2,   0,   0,   0,                // Sides
+    1,   0,   0,   0,                // Length
+    0,   0,   0,   0, 0, 0, 0xe0, 0x3f // dt of 0.5
+  };
+  std::vector<std::uint8_t> newer;
+  {
+    FILE *file = tmpfile();
+    ASSERT_TRUE(writeTrajectoryFile(file, header, sides));
+    rewind(file);
+    std::uint8_t prefix[12];
+    ASSERT_EQ(fread(prefix, sizeof(prefix), 1, file), 1);
+    const std::size_t fieldsSize = prefix[8];
+    newer.assign(prefix, prefix + sizeof(prefix));
+    newer.resize(sizeof(prefix) + fieldsSize);
+    ASSERT_EQ(fread(newer.data() + sizeof(prefix), fieldsSize, 1, file), 1);
+    fclose(file);
+
+    newer[8] = static_cast<std::uint8_t>(fieldsSize + 4);
+    newer.insert(newer.end(), {0xde, 0xad, 0xbe, 0xef});
+  }
+
+  for (const auto &bytes : {std::vector<std::uint8_t>(older, older + sizeof(older)), newer}) {
+    FILE *file = tmpfile();
+    fwrite(bytes.data(), bytes.size(), 1, file);
+    rewind(file);
+
+    TrajectoryFileHeader read;
+    ASSERT_TRUE(readTrajectoryFileHeader(file, read));
+    EXPECT_EQ(read.sides, 2);
+    EXPECT_EQ(static_cast<std::size_t>(ftell(file)), bytes.size());
+    fclose(file);
+
+    if (bytes.size() == sizeof(older)) {
+      EXPECT_DOUBLE_EQ(read.dt, 0.5);
+      EXPECT_EQ(read.limits, PathfinderLimits({0, 0, 0}));
+    } else {
+      EXPECT_EQ(read.limits, header.limits);
+    }
+  }
+}
+
+TEST_F(TrajectoryCacheTest, FileSizeMatchesWrittenFields) {
+  FILE *file = tmpfile();
+  ASSERT_NE(file, nullptr);
+  ASSERT_TRUE(writeTrajectoryFile(file, header, sides));
+  rewind(file);
+
+  std::uint8_t prefix[12];
+  ASSERT_EQ(fread(prefix, sizeof(prefix), 1, file), 1);
+  const std::size_t fieldsSize = prefix[8] | (prefix[9] << 8);
+
+  fseek(file, 0, SEEK_END);
+  EXPECT_EQ(static_cast<std::size_t>(ftell(file)), sizeof(prefix) + fieldsSize + entrySize);
+  fclose(file);
+}
+
+TEST_F(TrajectoryCacheTest, FileHeaderRejectsUnreadableVersionsAndFits) {
+  std::vector<std::uint8_t> bytes;
+  {
+    FILE *file = tmpfile();
+    ASSERT_TRUE(writeTrajectoryFile(file, header, sides));
+    fseek(file, 0, SEEK_END);
+    bytes.resize(static_cast<std::size_t>(ftell(file)));
+    rewind(file);
+    ASSERT_EQ(fread(bytes.data(), bytes.size(), 1, file), 1);
+    fclose(file);
+  }
+
+  const auto readsHeader = [](const std::vector<std::uint8_t> &ibytes) {
+    FILE *file = tmpfile();
+    fwrite(ibytes.data(), ibytes.size(), 1, file);
+    rewind(file);
+    TrajectoryFileHeader read;
+    const bool result = readTrajectoryFileHeader(file, read);
+    fclose(file);
+    return result;
+  };
+
+  ASSERT_TRUE(readsHeader(bytes));
+
+  auto tooOld = bytes;
+  tooOld[4] = TrajectoryFileHeader::oldestReadableVersion - 1;
+  EXPECT_FALSE(readsHeader(tooOld));
+
+  auto tooNew = bytes;
+  tooNew[4] = TrajectoryFileHeader::currentVersion + 1;
+  EXPECT_FALSE(readsHeader(tooNew));
+
+  // The fit follows sides, length, dt, wheelTrack, maxVel, maxAccel and maxJerk
+  auto unknownFit = bytes;
+  unknownFit[12 + 2 * 4 + 5 * 8] = 7;
+  EXPECT_FALSE(readsHeader(unknownFit));
+}
@@ -0,0 +1,38 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/control/util/trajectoryFollower.hpp"
+#include <gtest/gtest.h>
+
+using namespace okapi;
+
+TEST(TrajectoryFollowerTest, FeedforwardOnTarget) {
+  TrajectoryFollower follower({0.5, 0.1, 0.05, 2});
+
+  // The wheel is exactly where the trajectory says it should be after the step
+  EXPECT_DOUBLE_EQ(follower.step(1, 2, 0.01, 0.01), 0.05 + 0.5 + 0.2);
+  EXPECT_DOUBLE_EQ(follower.getError(), 0);
+  EXPECT_DOUBLE_EQ(follower.step(-1, 0, 0, 0.01), -0.05 - 0.5);
+}
+
+TEST(TrajectoryFollowerTest, CorrectsPositionError) {
+  TrajectoryFollower follower({0, 0, 0, 2});
+
+  for (int i = 0; i < 10; ++i) {
+    follower.step(0.5, 0, 0, 0.01);
+  }
+
+  EXPECT_DOUBLE_EQ(follower.getError(), 0.05);
+  EXPECT_DOUBLE_EQ(follower.step(0, 0, 0.1, 0.01), -0.1);
+}
+
+TEST(TrajectoryFollowerTest, OutputIsClampedAndResets) {
+  TrajectoryFollower follower({1, 0, 0, 0});
+  EXPECT_DOUBLE_EQ(follower.step(3, 0, 0, 0.01), 1);
+  EXPECT_DOUBLE_EQ(follower.step(-3, 0, 0, 0.01), -1);
+
+  follower.reset();
+  EXPECT_DOUBLE_EQ(follower.getError(), 0);
+}
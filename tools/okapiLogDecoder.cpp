@@ -0,0 +1,50 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "okapi/api/util/binaryLog.hpp"
+#include <cstdio>
+
+/**
+ * Decodes a binary log written by a Logger with Logger::Encoding::binary.
+ *
+ * Usage: okapiLogDecoder <binary log> [text log]
+ *
+ * The text is written to stdout if no text log is given.
+ */
+int main(int argc, char **argv) {
+  if (argc < 2 || argc > 3) {
+    fprintf(stderr, "Usage: %s <binary log> [text log]\n", argv[0]);
+    return 2;
+  }
+
+  FILE *in = fopen(argv[1], "rb");
+  if (!in) {
+    fprintf(stderr, "Could not open %s\n", argv[1]);
+    return 1;
+  }
+
+  FILE *out = argc == 3 ? fopen(argv[2], "w") : stdout;
+  if (!out) {
+    fprintf(stderr, "Could not open %s\n", argv[2]);
+    fclose(in);
+    return 1;
+  }
+
+  okapi::BinaryLogDecoder decoder;
+  const bool ok = decoder.decode(in, out);
+  const long offset = ftell(in);
+
+  fclose(in);
+  if (out != stdout) {
+    fclose(out);
+  }
+
+  if (!ok) {
+    fprintf(stderr, "%s is damaged, stopped decoding at offset %ld\n", argv[1], offset);
+    return 1;
+  }
+
+  return 0;
+}